@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include <libklio/types.hpp>
+#include <libklio/readings-cursor.hpp>
 
 
 namespace klio {
@@ -35,10 +36,18 @@ namespace klio {
         };
 
         virtual void process(
-                klio::readings_t_Ptr readings,
+                klio::ReadingsCursor::Ptr readings,
                 const std::string& name,
                 const std::string& description) = 0;
 
+        virtual void process(
+                klio::readings_t_Ptr readings,
+                const std::string& name,
+                const std::string& description) {
+
+            process(klio::ReadingsCursor::Ptr(new klio::MapReadingsCursor(readings)), name, description);
+        };
+
     protected:
         std::ostream& _out;
 
@@ -3,16 +3,16 @@
 
 using namespace klio;
 
-void JSONExporter::process(klio::readings_t_Ptr readings,
+void JSONExporter::process(klio::ReadingsCursor::Ptr readings,
         const std::string& name, const std::string& description) {
     _out << "[";
-    klio::readings_it_t it;
-    for (it = readings->begin(); it != readings->end(); ++it) {
-        klio::timestamp_t ts1 = (*it).first;
-        double val1 = (*it).second;
-        _out << "[" << ts1 << "," << val1 << "]";
-        if (it != (--readings->end()))
+    klio::reading_t reading;
+    bool first = true;
+    while (readings->next(reading)) {
+        if (!first)
             _out << ",";
+        _out << "[" << reading.first << "," << reading.second << "]";
+        first = false;
     }
 
     _out << "]" << std::endl;
@@ -36,8 +36,10 @@ namespace klio {
         virtual ~JSONExporter() {
         };
 
+        using Exporter::process;
+
         void process(
-                klio::readings_t_Ptr readings,
+                klio::ReadingsCursor::Ptr readings,
                 const std::string& name,
                 const std::string& description);
 
@@ -18,6 +18,8 @@ void MSGStore::open() {
 }
 
 void MSGStore::close() {
+
+    stop_async_flush();
     Store::clear_buffers();
 }
 
@@ -95,6 +97,8 @@ void MSGStore::prepare() {
 
 void MSGStore::dispose() {
 
+    stop_async_flush();
+
     //Tries to delete the remote store
     try {
         std::string url = libmsg::Webclient::composeDeviceUrl(_url, _id);
@@ -213,15 +217,15 @@ void MSGStore::add_single_reading_record(const Sensor::Ptr sensor, const timesta
     }
 }
 
-void MSGStore::add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+void MSGStore::add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
 
     try {
         Json::Value jmeasurements(Json::arrayValue);
 
-        for (readings_cit_t rit = readings.begin(); rit != readings.end(); ++rit) {
+        for (size_t i = 0; i < readings.size(); i++) {
 
-            timestamp_t timestamp = (*rit).first;
-            double value = (*rit).second;
+            timestamp_t timestamp = readings.timestamp(i);
+            double value = readings.value(i);
 
             Json::Value jtuple(Json::arrayValue);
             jtuple.append(Json::Int64(timestamp));
@@ -244,7 +248,7 @@ void MSGStore::add_bulk_reading_records(const Sensor::Ptr sensor, const readings
     }
 }
 
-void MSGStore::update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+void MSGStore::update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
 
     add_bulk_reading_records(sensor, readings, ignore_errors);
 }
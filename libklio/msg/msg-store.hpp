@@ -98,8 +98,8 @@ namespace klio {
         void remove_sensor_record(const Sensor::Ptr sensor);
         void update_sensor_record(const Sensor::Ptr sensor);
         void add_single_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const bool ignore_errors);
-        void add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors);
-        void update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors);
+        void add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
+        void update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
 
         std::vector<Sensor::Ptr> get_sensor_records();
         readings_t_Ptr get_all_reading_records(const Sensor::Ptr sensor);
@@ -22,24 +22,26 @@ static uint32_t calc_next_day_timestamp(uint32_t ts) {
 }
 
 void OctaveExporter::write_values_function(const std::string& name,
-        klio::readings_t_Ptr readings) {
-    klio::readings_it_t it;
+        klio::ReadingsCursor::Ptr readings) {
+    klio::reading_t reading;
 
     _out << "function values = get_" << name << "_values()" << std::endl;
     _out << "  values = [ ..." << std::endl << "\t";
 
+    // Look for the first reading and determine the first timestamp in the dataset.
+    if (!readings->next(reading)) {
+        _out << "  ];" << std::endl;
+        _out << "end" << std::endl;
+        return;
+    }
+
     std::vector<double> current_day(MINUTES_PER_DAY);
     std::vector<double>::iterator day_it;
-    int32_t next_day_timestamp = 0;
+    int32_t next_day_timestamp = calc_next_day_timestamp(reading.first);
 
-    // Look for the first reading and determine the first timestamp in the dataset.
-    it = readings->begin();
-    klio::timestamp_t ts = (*it).first;
-    next_day_timestamp = calc_next_day_timestamp(ts);
-
-    for (it = readings->begin(); it != readings->end(); it++) {
-        klio::timestamp_t ts = (*it).first;
-        double val = (*it).second;
+    do {
+        klio::timestamp_t ts = reading.first;
+        double val = reading.second;
         //std::cout << ts << "\t" << val << std::endl;
         if (ts >= next_day_timestamp) {
             //    std::cout << " TS: " << ts << " next_day: " << next_day_timestamp << std::endl;
@@ -67,7 +69,7 @@ void OctaveExporter::write_values_function(const std::string& name,
             current_day[position] = val;
         }
         //  std::cout << position << " / " << val << std::endl;
-    }
+    } while (readings->next(reading));
     // Finish the last line - there is a difference: this one is not
     // terminated by a ";" symbol.
     for (uint16_t i = 0; i < MINUTES_PER_DAY; i++) {
@@ -88,7 +90,7 @@ void OctaveExporter::write_description_function(const std::string& description,
     _out << "end" << std::endl;
 }
 
-void OctaveExporter::process(klio::readings_t_Ptr readings,
+void OctaveExporter::process(klio::ReadingsCursor::Ptr readings,
         const std::string& name, const std::string& description) {
     write_lead_in(name, description);
     std::string clean_name =
@@ -32,8 +32,10 @@ namespace klio {
 
         OctaveExporter(std::ostream& out) : Exporter(out) {
         };
+        using Exporter::process;
+
         virtual void process(
-                klio::readings_t_Ptr readings,
+                klio::ReadingsCursor::Ptr readings,
                 const std::string& name,
                 const std::string& description);
 
@@ -47,7 +49,7 @@ namespace klio {
         void write_description_function(const std::string& name,
                 const std::string& description);
         void write_values_function(const std::string& name,
-                klio::readings_t_Ptr readings);
+                klio::ReadingsCursor::Ptr readings);
     };
 };
 
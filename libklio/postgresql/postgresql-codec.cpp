@@ -0,0 +1,105 @@
+#include <libklio/config.h>
+
+#ifdef ENABLE_POSTGRESQL
+
+#include <cstring>
+#include <libklio/postgresql/postgresql-codec.hpp>
+
+
+using namespace klio;
+
+const size_t PostgreSQLCodec::TUPLE_SIZE;
+
+//Signature, flags and length of the header extension
+static const char COPY_HEADER[] = "PGCOPY\n\377\r\n\0\0\0\0\0\0\0\0\0";
+static const size_t COPY_HEADER_SIZE = 19;
+
+void PostgreSQLCodec::append_copy_header(std::string& buffer) {
+
+    buffer.append(COPY_HEADER, COPY_HEADER_SIZE);
+}
+
+void PostgreSQLCodec::append_copy_trailer(std::string& buffer) {
+
+    append_int16(buffer, -1);
+}
+
+const std::string PostgreSQLCodec::encode_copy_prefix(const std::string& uuid) {
+
+    std::string prefix;
+    append_int16(prefix, 3);
+    append_int32(prefix, uuid.size());
+    prefix.append(uuid);
+    return prefix;
+}
+
+const std::string PostgreSQLCodec::encode_copy_prefix(const Sensor::uuid_t& uuid) {
+
+    std::string prefix;
+    append_int16(prefix, 3);
+    append_int32(prefix, uuid.size());
+    prefix.append(uuid.begin(), uuid.end());
+    return prefix;
+}
+
+void PostgreSQLCodec::append_copy_reading(std::string& buffer, const std::string& prefix, const timestamp_t timestamp, const double value) {
+
+    buffer.append(prefix);
+    append_int32(buffer, 4);
+    append_int32(buffer, static_cast<int32_t> (timestamp));
+    append_int32(buffer, 8);
+    append_double(buffer, value);
+}
+
+void PostgreSQLCodec::append_int16(std::string& buffer, const int16_t value) {
+
+    const uint16_t bits = static_cast<uint16_t> (value);
+    buffer.push_back(static_cast<char> (bits >> 8));
+    buffer.push_back(static_cast<char> (bits & 0xff));
+}
+
+void PostgreSQLCodec::append_int32(std::string& buffer, const int32_t value) {
+
+    const uint32_t bits = static_cast<uint32_t> (value);
+
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        buffer.push_back(static_cast<char> ((bits >> shift) & 0xff));
+    }
+}
+
+void PostgreSQLCodec::append_double(std::string& buffer, const double value) {
+
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof (bits));
+
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        buffer.push_back(static_cast<char> ((bits >> shift) & 0xff));
+    }
+}
+
+const int32_t PostgreSQLCodec::decode_int32(const char* data) {
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*> (data);
+    uint32_t bits = 0;
+
+    for (int i = 0; i < 4; i++) {
+        bits = (bits << 8) | bytes[i];
+    }
+    return static_cast<int32_t> (bits);
+}
+
+const double PostgreSQLCodec::decode_double(const char* data) {
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*> (data);
+    uint64_t bits = 0;
+
+    for (int i = 0; i < 8; i++) {
+        bits = (bits << 8) | bytes[i];
+    }
+
+    double value;
+    std::memcpy(&value, &bits, sizeof (value));
+    return value;
+}
+
+#endif /* ENABLE_POSTGRESQL */
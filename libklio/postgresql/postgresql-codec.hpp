@@ -0,0 +1,68 @@
+/**
+ * This file is part of libklio.
+ *
+ * (c) Fraunhofer ITWM
+ *
+ * libklio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libklio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libklio. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKLIO_POSTGRESQL_CODEC_HPP
+#define LIBKLIO_POSTGRESQL_CODEC_HPP 1
+
+#include <libklio/config.h>
+
+#ifdef ENABLE_POSTGRESQL
+
+#include <string>
+#include <stdint.h>
+#include <libklio/types.hpp>
+
+
+namespace klio {
+
+    /**
+     * Binary encoding of readings for COPY ... FROM STDIN (FORMAT binary),
+     * and decoding of query results in binary format. Integers and doubles
+     * are sent in network byte order, so neither side parses any text. The uuid field is the same for
+     * all readings of a sensor, so it is encoded once per sensor as the
+     * prefix of its tuples.
+     */
+    class PostgreSQLCodec {
+    public:
+        static const size_t TUPLE_SIZE = 2 + 4 + 36 + 4 + 4 + 4 + 8;
+
+        static void append_copy_header(std::string& buffer);
+        static void append_copy_trailer(std::string& buffer);
+
+        //Field count and uuid field of the tuples of a sensor, as text or as native uuid
+        static const std::string encode_copy_prefix(const std::string& uuid);
+        static const std::string encode_copy_prefix(const Sensor::uuid_t& uuid);
+        static void append_copy_reading(std::string& buffer, const std::string& prefix, const timestamp_t timestamp, const double value);
+
+        static void append_int16(std::string& buffer, const int16_t value);
+        static void append_int32(std::string& buffer, const int32_t value);
+        static void append_double(std::string& buffer, const double value);
+
+        //Fields of query results in binary format
+        static const int32_t decode_int32(const char* data);
+        static const double decode_double(const char* data);
+
+    private:
+        PostgreSQLCodec();
+    };
+};
+
+#endif /* ENABLE_POSTGRESQL */
+
+#endif /* LIBKLIO_POSTGRESQL_CODEC_HPP */
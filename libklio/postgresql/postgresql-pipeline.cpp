@@ -0,0 +1,206 @@
+#include <libklio/config.h>
+
+#ifdef ENABLE_POSTGRESQL
+
+#include <sstream>
+#include <libklio/postgresql/postgresql-pipeline.hpp>
+
+
+using namespace klio;
+
+void PostgreSQLPipeline::connection(PGconn* connection) {
+
+    _connection = connection;
+    _active = false;
+    _pending.clear();
+}
+
+void PostgreSQLPipeline::send(const char* statement_name, const char* params[], const int num_params,
+        const std::string& description, const bool ignore_errors) {
+
+#ifdef LIBPQ_HAS_PIPELINING
+
+    if (!_active) {
+        enter();
+    }
+    queue(PQsendQueryPrepared(_connection, statement_name, num_params, params, NULL, NULL, 0), description, ignore_errors);
+
+#else
+
+    execute(PQexecPrepared(_connection, statement_name, num_params, params, NULL, NULL, 0), description, ignore_errors);
+
+#endif /* LIBPQ_HAS_PIPELINING */
+}
+
+void PostgreSQLPipeline::send(const char* statement, const bool ignore_errors) {
+
+#ifdef LIBPQ_HAS_PIPELINING
+
+    if (!_active) {
+        enter();
+    }
+    queue(PQsendQueryParams(_connection, statement, 0, NULL, NULL, NULL, NULL, 0), statement, ignore_errors);
+
+#else
+
+    execute(PQexec(_connection, statement), statement, ignore_errors);
+
+#endif /* LIBPQ_HAS_PIPELINING */
+}
+
+void PostgreSQLPipeline::sync() {
+
+    if (!_active) {
+        return;
+    }
+
+    std::ostringstream errors;
+    unsigned int num_errors = 0;
+
+    while (!_pending.empty()) {
+
+        const pending_statement_t statement = _pending.front();
+        _pending.pop_front();
+        const std::string error = reap();
+
+        if (error.empty()) {
+            continue;
+
+        } else if (statement.ignore_errors) {
+            LOG(statement.description << ": " << error);
+
+        } else {
+            errors << std::endl << statement.description << ": " << error;
+            num_errors++;
+        }
+    }
+
+#ifdef LIBPQ_HAS_PIPELINING
+
+    _active = false;
+
+    if (!PQexitPipelineMode(_connection)) {
+        std::ostringstream oss;
+        oss << "Can't leave pipeline mode. Error: " << PQerrorMessage(_connection);
+        throw StoreException(oss.str());
+    }
+
+#endif /* LIBPQ_HAS_PIPELINING */
+
+    if (num_errors > 0) {
+        std::ostringstream oss;
+        oss << num_errors << " queued SQL statements failed." << errors.str();
+        throw StoreException(oss.str());
+    }
+}
+
+void PostgreSQLPipeline::enter() {
+
+#ifdef LIBPQ_HAS_PIPELINING
+
+    if (!PQenterPipelineMode(_connection)) {
+        std::ostringstream oss;
+        oss << "Can't enter pipeline mode. Error: " << PQerrorMessage(_connection);
+        throw StoreException(oss.str());
+    }
+    _active = true;
+
+#endif /* LIBPQ_HAS_PIPELINING */
+}
+
+void PostgreSQLPipeline::queue(const int sent, const std::string& description, const bool ignore_errors) {
+
+#ifdef LIBPQ_HAS_PIPELINING
+
+    if (!sent) {
+        std::ostringstream oss;
+        oss << "Can't queue SQL statement. Error: " << PQerrorMessage(_connection);
+        throw StoreException(oss.str());
+    }
+
+    pending_statement_t statement;
+    statement.description = description;
+    statement.ignore_errors = ignore_errors;
+    _pending.push_back(statement);
+
+    if (!PQpipelineSync(_connection)) {
+        std::ostringstream oss;
+        oss << "Can't send SQL statements. Error: " << PQerrorMessage(_connection);
+        throw StoreException(oss.str());
+    }
+
+    if (_pending.size() >= _max_pending) {
+        sync();
+    }
+
+#endif /* LIBPQ_HAS_PIPELINING */
+}
+
+void PostgreSQLPipeline::execute(PGresult* result, const std::string& description, const bool ignore_errors) {
+
+    const ExecStatusType status = PQresultStatus(result);
+    const bool failed = status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK;
+    std::ostringstream oss;
+
+    if (failed) {
+        oss << description << ": " << PQerrorMessage(_connection);
+    }
+    PQclear(result);
+
+    if (failed && ignore_errors) {
+        LOG(oss.str());
+
+    } else if (failed) {
+        throw StoreException(oss.str());
+    }
+}
+
+const std::string PostgreSQLPipeline::reap() {
+
+    std::string error;
+
+#ifdef LIBPQ_HAS_PIPELINING
+
+    //The results of the statement are followed by NULL, and then by its sync point
+    bool executed = false;
+    PGresult* result;
+
+    while ((result = PQgetResult(_connection))) {
+
+        const ExecStatusType status = PQresultStatus(result);
+        executed = true;
+
+        if (status == PGRES_PIPELINE_ABORTED) {
+            error = "Statement was not executed because of a previous error.";
+
+        } else if (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK) {
+            error = PQresultErrorMessage(result);
+        }
+        PQclear(result);
+    }
+
+    if (!executed) {
+        error = PQerrorMessage(_connection);
+    }
+
+    result = PQgetResult(_connection);
+
+    if (!result || PQresultStatus(result) != PGRES_PIPELINE_SYNC) {
+        error = error.empty() ? "Missing result of the pipeline." : error;
+    }
+
+    if (result) {
+        PQclear(result);
+    }
+
+    //Messages of libpq end with a line break
+    if (!error.empty() && error[error.size() - 1] == '\n') {
+        error.erase(error.size() - 1);
+    }
+
+#endif /* LIBPQ_HAS_PIPELINING */
+
+    return error;
+}
+
+#endif /* ENABLE_POSTGRESQL */
@@ -0,0 +1,113 @@
+/**
+ * This file is part of libklio.
+ *
+ * (c) Fraunhofer ITWM
+ *
+ * libklio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libklio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libklio. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKLIO_POSTGRESQL_PIPELINE_HPP
+#define LIBKLIO_POSTGRESQL_PIPELINE_HPP 1
+
+#include <libklio/config.h>
+
+#ifdef ENABLE_POSTGRESQL
+
+#include <deque>
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <postgresql/libpq-fe.h>
+#include <libklio/common.hpp>
+
+
+namespace klio {
+
+    /**
+     * Queues prepared statements in libpq pipeline mode, so that they are
+     * sent without waiting for the results of the previous ones. Every
+     * statement is followed by its own sync point, so a failing statement
+     * does not abort the ones after it.
+     *
+     * Simple queries, COPY and transaction control are not allowed in
+     * pipeline mode. sync() has to be called before them; it reaps all
+     * results, leaves pipeline mode and reports the statements that failed.
+     * The store also synchronizes it at the end of every write operation
+     * and commit, so failures are reported to the caller that queued them.
+     * Without pipelining support in libpq, statements are executed at once.
+     *
+     * The connection blocks while sending, so at most max_pending
+     * statements are queued before their results are reaped. Otherwise
+     * the server could block on unread results while the client blocks on
+     * sending.
+     */
+    class PostgreSQLPipeline {
+    public:
+        typedef boost::shared_ptr<PostgreSQLPipeline> Ptr;
+
+        PostgreSQLPipeline(PGconn* connection, const size_t max_pending) :
+        _connection(connection),
+        _max_pending(max_pending),
+        _active(false) {
+        };
+
+        virtual ~PostgreSQLPipeline() {
+        };
+
+        void connection(PGconn* connection);
+
+        /**
+         * Queues a prepared statement. The description names the statement
+         * in error reports. Errors of statements that ignore them are only
+         * logged.
+         */
+        void send(const char* statement_name, const char* params[], const int num_params,
+                const std::string& description, const bool ignore_errors);
+
+        //Queues a statement without parameters, such as BEGIN or COMMIT
+        void send(const char* statement, const bool ignore_errors);
+
+        /**
+         * Waits for the results of all queued statements and throws a
+         * StoreException that lists the statements that failed.
+         */
+        void sync();
+
+        const size_t pending() const {
+            return _pending.size();
+        };
+
+    private:
+        PostgreSQLPipeline(const PostgreSQLPipeline& original);
+        PostgreSQLPipeline& operator=(const PostgreSQLPipeline& rhs);
+
+        typedef struct {
+            std::string description;
+            bool ignore_errors;
+        } pending_statement_t;
+
+        void enter();
+        void queue(const int sent, const std::string& description, const bool ignore_errors);
+        void execute(PGresult* result, const std::string& description, const bool ignore_errors);
+        const std::string reap();
+
+        PGconn* _connection;
+        size_t _max_pending;
+        bool _active;
+        std::deque<pending_statement_t> _pending;
+    };
+};
+
+#endif /* ENABLE_POSTGRESQL */
+
+#endif /* LIBKLIO_POSTGRESQL_PIPELINE_HPP */
@@ -0,0 +1,118 @@
+#include <libklio/config.h>
+
+#ifdef ENABLE_POSTGRESQL
+
+#include <sstream>
+#include <libklio/postgresql/postgresql-codec.hpp>
+#include <libklio/postgresql/postgresql-readings-cursor.hpp>
+
+
+using namespace klio;
+
+PostgreSQLReadingsCursor::~PostgreSQLReadingsCursor() {
+
+    if (_result) {
+        PQclear(_result);
+    }
+
+    if (!_done) {
+        cancel();
+        clear_results();
+    }
+}
+
+bool PostgreSQLReadingsCursor::next(reading_t& reading) {
+
+    while (!_result || _row >= PQntuples(_result)) {
+
+        if (!fetch()) {
+            return false;
+        }
+    }
+
+    reading.first = _time_converter->convert_from_epoch(PostgreSQLCodec::decode_int32(PQgetvalue(_result, _row, 0)));
+    reading.second = PQgetisnull(_result, _row, 1) ? 0 : PostgreSQLCodec::decode_double(PQgetvalue(_result, _row, 1));
+    _row++;
+    return true;
+}
+
+bool PostgreSQLReadingsCursor::fetch() {
+
+    if (_result) {
+        PQclear(_result);
+        _result = NULL;
+        _row = 0;
+    }
+
+    if (_interrupted) {
+        throw StoreException("The readings query was interrupted before all readings were fetched.");
+
+    } else if (_done) {
+        return false;
+    }
+
+    PGresult* result = PQgetResult(_connection);
+
+    //The final result was not seen, so another statement has discarded the remaining rows
+    if (!result) {
+        _done = true;
+        _interrupted = true;
+        throw StoreException("The readings query was interrupted by another statement on the connection.");
+    }
+
+    const ExecStatusType status = PQresultStatus(result);
+
+#ifdef LIBPQ_HAS_CHUNK_MODE
+    if (status == PGRES_SINGLE_TUPLE || status == PGRES_TUPLES_CHUNK) {
+#else
+    if (status == PGRES_SINGLE_TUPLE) {
+#endif
+        _result = result;
+        return true;
+
+    } else if (status == PGRES_TUPLES_OK) {
+        PQclear(result);
+        clear_results();
+        _done = true;
+        return false;
+
+    } else {
+        std::ostringstream oss;
+        oss << "Can't fetch reading. Error: " << PQresultErrorMessage(result) << ", Error code: " << status;
+        PQclear(result);
+        clear_results();
+        _done = true;
+        throw StoreException(oss.str());
+    }
+}
+
+void PostgreSQLReadingsCursor::interrupt() {
+
+    if (!_done) {
+        cancel();
+        clear_results();
+        _done = true;
+        _interrupted = true;
+    }
+}
+
+void PostgreSQLReadingsCursor::cancel() {
+
+    PGcancel* cancel = PQgetCancel(_connection);
+
+    if (cancel) {
+        char error[256];
+        PQcancel(cancel, error, sizeof (error));
+        PQfreeCancel(cancel);
+    }
+}
+
+void PostgreSQLReadingsCursor::clear_results() {
+
+    PGresult* result;
+    while ((result = PQgetResult(_connection))) {
+        PQclear(result);
+    }
+}
+
+#endif /* ENABLE_POSTGRESQL */
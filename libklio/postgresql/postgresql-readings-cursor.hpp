@@ -0,0 +1,87 @@
+/**
+ * This file is part of libklio.
+ *
+ * (c) Fraunhofer ITWM
+ *
+ * libklio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libklio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libklio. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKLIO_POSTGRESQL_READINGS_CURSOR_HPP
+#define LIBKLIO_POSTGRESQL_READINGS_CURSOR_HPP 1
+
+#include <libklio/config.h>
+
+#ifdef ENABLE_POSTGRESQL
+
+#include <postgresql/libpq-fe.h>
+#include <libklio/readings-cursor.hpp>
+#include <libklio/time.hpp>
+
+
+namespace klio {
+
+    /**
+     * Fetches the rows of a query that was sent in chunked rows mode, or in
+     * single-row mode if libpq does not support chunks, so only one batch of
+     * rows is held in client memory at a time. The query must select
+     * timestamp and value in this order, with results in binary format. If
+     * the cursor is destroyed or interrupted before all rows were fetched,
+     * the query is cancelled and the remaining results are discarded, so
+     * the connection can be used again. Rows that were discarded by another
+     * statement on the connection are reported as an error, not as the end
+     * of the readings.
+     */
+    class PostgreSQLReadingsCursor : public ReadingsCursor {
+    public:
+        typedef boost::shared_ptr<PostgreSQLReadingsCursor> Ptr;
+
+        PostgreSQLReadingsCursor(PGconn* connection, const TimeConverter::Ptr time_converter) :
+        ReadingsCursor(),
+        _connection(connection),
+        _time_converter(time_converter),
+        _result(NULL),
+        _row(0),
+        _done(false),
+        _interrupted(false) {
+        };
+
+        virtual ~PostgreSQLReadingsCursor();
+
+        bool next(reading_t& reading);
+
+        const bool done() const {
+            return _done;
+        };
+        void interrupt();
+
+    private:
+        PostgreSQLReadingsCursor(const PostgreSQLReadingsCursor& original);
+        PostgreSQLReadingsCursor& operator=(const PostgreSQLReadingsCursor& rhs);
+
+        bool fetch();
+        void cancel();
+        void clear_results();
+
+        PGconn* _connection;
+        TimeConverter::Ptr _time_converter;
+        PGresult* _result;
+        int _row;
+        bool _done;
+        bool _interrupted;
+    };
+};
+
+#endif /* ENABLE_POSTGRESQL */
+
+#endif /* LIBKLIO_POSTGRESQL_READINGS_CURSOR_HPP */
@@ -5,6 +5,10 @@
 #include <iostream>
 #include <sstream>
 #include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/algorithm/string/split.hpp>
@@ -14,6 +18,9 @@
 
 using namespace klio;
 
+namespace bpt = boost::posix_time;
+namespace bg = boost::gregorian;
+
 const std::string PostgreSQLStore::DEFAULT_CONNECTION_INFO = "host=postgresql-server1 port=5432 dbname=kliostore user=kliouser password=12test34";
 
 const char* PostgreSQLStore::HAS_TABLE_STMT = "HAS_TABLE";
@@ -22,13 +29,26 @@ const char* PostgreSQLStore::DELETE_SENSOR_STMT = "DELETE_SENSOR";
 const char* PostgreSQLStore::UPDATE_SENSOR_STMT = "UPDATE_SENSOR";
 const char* PostgreSQLStore::SELECT_SENSORS_STMT = "SELECT_SENSORS";
 const char* PostgreSQLStore::INSERT_READING_STMT = "INSERT_READING";
-const char* PostgreSQLStore::COPY_READINGS_STMT = "COPY_READINGS";
-const char* PostgreSQLStore::UPDATE_READING_STMT = "UPDATE_READING";
+const char* PostgreSQLStore::UPSERT_READINGS_STMT = "UPSERT_READINGS";
+const char* PostgreSQLStore::INSERT_NEW_READINGS_STMT = "INSERT_NEW_READINGS";
 const char* PostgreSQLStore::SELECT_READINGS_STMT = "SELECT_READINGS";
 const char* PostgreSQLStore::SELECT_TIMEFRAME_READINGS_STMT = "SELECT_TIMEFRAME_READINGS";
 const char* PostgreSQLStore::COUNT_READINGS_STMT = "COUNT_READINGS";
 const char* PostgreSQLStore::SELECT_LAST_READING_STMT = "SELECT_LAST_READING";
 const char* PostgreSQLStore::SELECT_READING_STMT = "SELECT_READING";
+const char* PostgreSQLStore::SELECT_SUMMARY_STMT = "SELECT_SUMMARY";
+const char* PostgreSQLStore::SELECT_AGGREGATED_READINGS_STMT = "SELECT_AGGREGATED_READINGS";
+
+//COPY can not be prepared, so it is sent as a simple query
+const char* PostgreSQLStore::COPY_READINGS_SQL = "COPY readings (uuid, timestamp, value) FROM STDIN (FORMAT binary)";
+const char* PostgreSQLStore::COPY_STAGED_READINGS_SQL = "COPY staged_readings (uuid, timestamp, value) FROM STDIN (FORMAT binary)";
+const size_t PostgreSQLStore::COPY_CHUNK_SIZE = 65536;
+const size_t PostgreSQLStore::MAX_PENDING_STATEMENTS = 1000;
+const int PostgreSQLStore::FETCH_SIZE = 10000;
+
+//Rows that fit no partition violate the partition constraint of the parent table
+const char* PostgreSQLStore::NO_PARTITION_STATE = "23514";
+const char* PostgreSQLStore::DUPLICATE_KEY_STATE = "23505";
 
 void PostgreSQLStore::open() {
 
@@ -42,10 +62,22 @@ void PostgreSQLStore::open() {
 
 void PostgreSQLStore::close() {
 
+    stop_async_flush();
+
     if (_connection == NULL) {
         LOG("Store is already closed.");
 
     } else {
+        //An open cursor can not fetch any more readings from the closed connection
+        interrupt_cursor();
+
+        //Errors can not be reported to the caller of close
+        try {
+            sync_pipeline();
+
+        } catch (std::exception const& e) {
+            LOG("Queued statements failed: " << e.what());
+        }
         finalize_statements();
 
         if (_connection && _transaction) {
@@ -63,6 +95,13 @@ void PostgreSQLStore::open_db() {
 
     if (PQstatus(_connection) == CONNECTION_OK) {
 
+        if (_pipeline) {
+            _pipeline->connection(_connection);
+
+        } else if (!_synchronous) {
+            _pipeline = PostgreSQLPipeline::Ptr(new PostgreSQLPipeline(_connection, MAX_PENDING_STATEMENTS));
+        }
+
         if (_transaction) {
             _transaction->connection(_connection);
 
@@ -98,6 +137,9 @@ void PostgreSQLStore::clear_connection_references() {
     if (_transaction) {
         _transaction->connection(NULL);
     }
+    if (_pipeline) {
+        _pipeline->connection(NULL);
+    }
 }
 
 void PostgreSQLStore::check_integrity() {
@@ -112,7 +154,15 @@ void PostgreSQLStore::check_integrity() {
 void PostgreSQLStore::initialize() {
 
     execute("CREATE TABLE IF NOT EXISTS sensors (uuid VARCHAR(36), external_id VARCHAR(36), name VARCHAR(100), description VARCHAR(255), unit VARCHAR(20), timezone VARCHAR(30), device_type_id INTEGER, PRIMARY KEY(uuid))");
-    execute("CREATE TABLE IF NOT EXISTS readings (uuid VARCHAR(36), timestamp INTEGER, value FLOAT8, PRIMARY KEY(uuid, timestamp))");
+
+    if (_partitioned) {
+        //The primary key of each partition only covers one month of readings
+        execute("CREATE TABLE IF NOT EXISTS readings (uuid UUID NOT NULL, timestamp INTEGER NOT NULL, value FLOAT8, PRIMARY KEY(uuid, timestamp)) PARTITION BY RANGE (timestamp)");
+        execute("CREATE INDEX IF NOT EXISTS readings_timestamp_idx ON readings USING BRIN (timestamp)");
+
+    } else {
+        execute("CREATE TABLE IF NOT EXISTS readings (uuid VARCHAR(36), timestamp INTEGER, value FLOAT8, PRIMARY KEY(uuid, timestamp))");
+    }
 }
 
 void PostgreSQLStore::prepare() {
@@ -123,19 +173,78 @@ void PostgreSQLStore::prepare() {
 
 void PostgreSQLStore::dispose() {
 
+    stop_async_flush();
     execute("DROP TABLE readings");
     execute("DROP TABLE sensors");
+    _partitions.clear();
     close();
 }
 
+const unsigned int PostgreSQLStore::drop_partitions(const timestamp_t before) {
+
+    LOG("Dropping partitions of readings before " << before);
+
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+
+    if (!_partitioned) {
+        throw StoreException("The readings table is not partitioned.");
+    }
+
+    //Previous insertions
+    clear_results();
+
+    PGresult* result = PQexec(_connection,
+            "SELECT c.relname FROM pg_catalog.pg_inherits i "
+            "JOIN pg_catalog.pg_class c ON c.oid = i.inhrelid "
+            "JOIN pg_catalog.pg_class p ON p.oid = i.inhparent WHERE p.relname = 'readings'");
+    check(result, PGRES_TUPLES_OK);
+
+    std::vector<std::string> names;
+    const int num_rows = PQntuples(result);
+
+    for (int row = 0; row < num_rows; row++) {
+        names.push_back(get_string_value(result, row, 0));
+    }
+    clear(result);
+
+    const timestamp_t epoch = time_converter->convert_to_epoch(before);
+    unsigned int dropped = 0;
+
+    for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+
+        //Partitions are named after the month of their readings
+        int year, month;
+        if (sscanf((*it).c_str(), "readings_%4d%2d", &year, &month) != 2) {
+            continue;
+        }
+
+        if (get_month_start(year, month + 1) <= epoch) {
+            execute(("DROP TABLE " + *it).c_str());
+            _partitions.erase(get_month_start(year, month));
+            dropped++;
+        }
+    }
+
+    if (dropped > 0) {
+        clear_sensor_summaries();
+    }
+    return dropped;
+}
+
 Transaction::Ptr PostgreSQLStore::get_transaction_handler() {
 
     return _auto_commit ? create_transaction_handler() : _transaction;
 }
 
+void PostgreSQLStore::auto_commit_transaction(const Transaction::Ptr transaction) {
+
+    Store::auto_commit_transaction(transaction);
+    sync_pipeline();
+}
+
 PostgreSQLTransaction::Ptr PostgreSQLStore::create_transaction_handler() {
 
-    return PostgreSQLTransaction::Ptr(new PostgreSQLTransaction(_connection));
+    return PostgreSQLTransaction::Ptr(new PostgreSQLTransaction(_connection, _pipeline));
 }
 
 const bool PostgreSQLStore::has_table(const char* name) {
@@ -155,6 +264,22 @@ const bool PostgreSQLStore::has_table(const char* name) {
     }
 }
 
+const bool PostgreSQLStore::has_partitioned_table(const char* name) {
+
+    const char* params[1];
+    params[0] = name;
+
+    sync_pipeline();
+    PGresult* result = PQexecParams(_connection,
+            "SELECT 1 FROM pg_catalog.pg_class WHERE relname = $1 AND relkind = 'p'",
+            1, NULL, params, NULL, NULL, 0);
+    check(result, PGRES_TUPLES_OK);
+
+    const bool partitioned = PQntuples(result) > 0;
+    clear(result);
+    return partitioned;
+}
+
 const std::string PostgreSQLStore::str() {
 
     std::ostringstream oss;
@@ -234,14 +359,59 @@ readings_t_Ptr PostgreSQLStore::get_all_reading_records(const Sensor::Ptr sensor
 
 readings_t_Ptr PostgreSQLStore::get_timeframe_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
 
+    const std::string uuid = sensor->uuid_string();
+    const std::string begin_str = std::to_string(begin);
+    const std::string end_str = std::to_string(end);
+
     const char* params[3];
-    params[0] = sensor->uuid_string().c_str();
-    params[1] = std::to_string(begin).c_str();
-    params[2] = std::to_string(end).c_str();
+    params[0] = uuid.c_str();
+    params[1] = begin_str.c_str();
+    params[2] = end_str.c_str();
 
     return get_reading_records(SELECT_TIMEFRAME_READINGS_STMT, params, 3);
 }
 
+readings_t_Ptr PostgreSQLStore::get_aggregated_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+        const timestamp_t bucket, const aggregate_t function) {
+
+    const std::string uuid = sensor->uuid_string();
+    const std::string begin_str = std::to_string(begin);
+    const std::string end_str = std::to_string(end);
+    const std::string bucket_str = std::to_string(bucket);
+
+    const char* params[4];
+    params[0] = uuid.c_str();
+    params[1] = begin_str.c_str();
+    params[2] = end_str.c_str();
+    params[3] = bucket_str.c_str();
+
+    return get_reading_records(compose_aggregate_stmt(function).c_str(), params, 4);
+}
+
+ReadingsCursor::Ptr PostgreSQLStore::get_all_reading_records_cursor(const Sensor::Ptr sensor) {
+
+    const std::string uuid = sensor->uuid_string();
+
+    const char* params[1];
+    params[0] = uuid.c_str();
+
+    return get_reading_records_cursor(SELECT_READINGS_STMT, params, 1);
+}
+
+ReadingsCursor::Ptr PostgreSQLStore::get_timeframe_reading_records_cursor(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
+
+    const std::string uuid = sensor->uuid_string();
+    const std::string begin_str = std::to_string(begin);
+    const std::string end_str = std::to_string(end);
+
+    const char* params[3];
+    params[0] = uuid.c_str();
+    params[1] = begin_str.c_str();
+    params[2] = end_str.c_str();
+
+    return get_reading_records_cursor(SELECT_TIMEFRAME_READINGS_STMT, params, 3);
+}
+
 unsigned long int PostgreSQLStore::get_num_readings_value(const Sensor::Ptr sensor) {
 
     const char* params[1];
@@ -269,6 +439,34 @@ reading_t PostgreSQLStore::get_last_reading_record(const Sensor::Ptr sensor) {
     return *(get_reading_records(SELECT_LAST_READING_STMT, params, 1)->begin());
 }
 
+SensorSummary PostgreSQLStore::get_sensor_summary_record(const Sensor::Ptr sensor) {
+
+    const std::string uuid = sensor->uuid_string();
+    const char* params[1];
+    params[0] = uuid.c_str();
+
+    PGresult* result = NULL;
+    try {
+        result = execute(SELECT_SUMMARY_STMT, params, 1, PGRES_TUPLES_OK);
+        const unsigned long int num = get_long_value(result, 0, 0);
+
+        const SensorSummary summary = num == 0 ? SensorSummary() : SensorSummary(num,
+                time_converter->convert_from_epoch(get_long_value(result, 0, 1)),
+                time_converter->convert_from_epoch(get_long_value(result, 0, 2)),
+                get_double_value(result, 0, 6),
+                get_double_value(result, 0, 3),
+                get_double_value(result, 0, 4),
+                get_double_value(result, 0, 5));
+
+        clear(result);
+        return summary;
+
+    } catch (std::exception const& e) {
+        clear(result);
+        throw;
+    }
+}
+
 reading_t PostgreSQLStore::get_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp) {
 
     const char* params[2];
@@ -280,81 +478,336 @@ reading_t PostgreSQLStore::get_reading_record(const Sensor::Ptr sensor, const ti
 
 void PostgreSQLStore::add_single_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const bool ignore_errors) {
 
+    const std::string uuid = sensor->uuid_string();
     const std::string timestamp_str = std::to_string(time_converter->convert_to_epoch(timestamp));
     const std::string value_str = std::to_string(value);
 
     const char* params[3];
-    params[0] = sensor->uuid_string().c_str();
+    params[0] = uuid.c_str();
     params[1] = timestamp_str.c_str();
     params[2] = value_str.c_str();
 
-    try {
-        execute(INSERT_READING_STMT, params, 3);
+    //A month that was dropped by another store is created again, and the reading is written once more
+    for (bool retry = _partitioned; ; ) {
 
-    } catch (std::exception const& e) {
-        handle_reading_insertion_error(ignore_errors, timestamp, value);
+        try {
+            if (_partitioned) {
+                //Partitioned insertions are not queued, their result tells whether the month still exists
+                begin_write();
+                create_partition(time_converter->convert_to_epoch(timestamp));
+
+                PGresult* result = execute(INSERT_READING_STMT, params, 3, PGRES_COMMAND_OK);
+                clear(result);
+                end_write();
+
+            } else {
+                std::ostringstream description;
+                description << "Reading of sensor " << uuid << " at " << timestamp;
+                execute(INSERT_READING_STMT, params, 3, description.str(), ignore_errors);
+            }
+            return;
+
+        } catch (std::exception const& e) {
+            _partitions.clear();
+            const std::string state = _error_state;
+
+            if (!undo_write() || !retry_missing_partition(state, retry)) {
+                handle_reading_insertion_error(ignore_errors, timestamp, value);
+                return;
+            }
+        }
     }
 }
 
-void PostgreSQLStore::add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+void PostgreSQLStore::add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
 
-    std::ostringstream oss;
-    for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
-        oss << sensor->uuid_string() << "," <<
-                time_converter->convert_to_epoch((*it).first) << "," <<
-                (*it).second << std::endl;
+    add_batch_reading_records(sensors_readings_spans_t(1, sensor_readings_span_t(sensor, readings)), ignore_errors);
+}
+
+void PostgreSQLStore::add_batch_reading_records(const sensors_readings_spans_t& readings, const bool ignore_errors) {
+
+    //Previous insertions
+    clear_results();
+
+    bool skip_duplicates = false;
+    for (bool retry = _partitioned; ; ) {
+
+        try {
+            begin_write();
+
+            if (_partitioned) {
+                create_partitions(readings);
+            }
+
+            if (!skip_duplicates) {
+                //The readings of all sensors are sent in a single COPY
+                copy_readings(COPY_READINGS_SQL, readings);
+                end_write();
+                return;
+            }
+
+            //Readings that exist already are skipped, and reported once the others are written
+            const unsigned long int num_written = stage_readings(readings, INSERT_NEW_READINGS_STMT);
+            end_write();
+
+            unsigned long int num_readings = 0;
+            for (sensors_readings_spans_cit_t it = readings.begin(); it != readings.end(); ++it) {
+                num_readings += (*it).second.size();
+            }
+
+            if (num_written < num_readings) {
+                std::ostringstream oss;
+                oss << num_readings - num_written << " readings exist already";
+                handle_reading_insertion_error(ignore_errors, readings, oss.str());
+            }
+            return;
+
+        } catch (std::exception const& e) {
+            //Partitions that were created in a failed transaction are gone
+            _partitions.clear();
+            const std::string state = _error_state;
+
+            if (!undo_write()) {
+                handle_reading_insertion_error(ignore_errors, readings, e.what());
+                return;
+            }
+
+            //A single existing reading of any sensor aborts the whole COPY
+            if (!skip_duplicates && state == DUPLICATE_KEY_STATE) {
+                skip_duplicates = true;
+
+            } else if (!retry_missing_partition(state, retry)) {
+                handle_reading_insertion_error(ignore_errors, readings, e.what());
+                return;
+            }
+        }
     }
-    const std::string buffer = oss.str();
-    oss.clear();
+}
 
+void PostgreSQLStore::update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
+
+    //Previous insertions
     clear_results();
-    //FIXME
-    //check(result, PGRES_COMMAND_OK);
 
-    PGresult* result = NULL;
+    const sensors_readings_spans_t staged(1, sensor_readings_span_t(sensor, readings));
+
+    for (bool retry = _partitioned; ; ) {
+
+        try {
+            begin_write();
+
+            if (_partitioned) {
+                create_partitions(staged);
+            }
+
+            stage_readings(staged, UPSERT_READINGS_STMT);
+            end_write();
+            return;
+
+        } catch (std::exception const& e) {
+            _partitions.clear();
+            const std::string state = _error_state;
+
+            if (!undo_write() || !retry_missing_partition(state, retry)) {
+                handle_reading_insertion_error(ignore_errors, sensor);
+                return;
+            }
+        }
+    }
+}
+
+const unsigned long int PostgreSQLStore::stage_readings(const sensors_readings_spans_t& readings, const char* statement_name) {
+
+    //The readings are staged with COPY and merged into the table by a single statement
+    execute("TRUNCATE staged_readings");
+    copy_readings(COPY_STAGED_READINGS_SQL, readings);
+
+    PGresult* result = execute(statement_name, NULL, 0, PGRES_COMMAND_OK);
+    const unsigned long int num_rows = std::strtoul(PQcmdTuples(result), NULL, 10);
+    clear(result);
+    return num_rows;
+}
+
+void PostgreSQLStore::copy_readings(const char* statement, const sensors_readings_spans_t& readings) {
+
+    bool copying = false;
     try {
-        result = execute(COPY_READINGS_STMT, NULL, 0, PGRES_COPY_IN);
+        PGresult* result = PQexec(_connection, statement);
+        check(result, PGRES_COPY_IN);
         clear(result);
-        result = NULL;
+        copying = true;
 
-        int code = PQputCopyData(_connection, buffer.c_str(), buffer.length());
-        check(code);
+        //Tuples are sent in chunks of binary data
+        std::string buffer;
+        buffer.reserve(COPY_CHUNK_SIZE + PostgreSQLCodec::TUPLE_SIZE);
+        PostgreSQLCodec::append_copy_header(buffer);
 
-        code = PQputCopyEnd(_connection, NULL);
-        check(code);
+        for (sensors_readings_spans_cit_t it = readings.begin(); it != readings.end(); ++it) {
+
+            const std::string prefix = _partitioned ?
+                    PostgreSQLCodec::encode_copy_prefix((*it).first->uuid()) :
+                    PostgreSQLCodec::encode_copy_prefix((*it).first->uuid_string());
+            const ReadingsSpan& span = (*it).second;
+
+            for (size_t i = 0; i < span.size(); i++) {
+
+                PostgreSQLCodec::append_copy_reading(buffer, prefix,
+                        time_converter->convert_to_epoch(span.timestamp(i)), span.value(i));
+
+                if (buffer.size() >= COPY_CHUNK_SIZE) {
+                    put_copy_data(buffer);
+                    buffer.clear();
+                }
+            }
+        }
+        PostgreSQLCodec::append_copy_trailer(buffer);
+        put_copy_data(buffer);
+
+        copying = false;
+        end_copy();
 
     } catch (std::exception const& e) {
-        clear(result);
-        handle_reading_insertion_error(ignore_errors, sensor);
+
+        if (copying) {
+            PQputCopyEnd(_connection, "Readings could not be sent.");
+        }
+        clear_results();
+        throw;
     }
 }
 
-void PostgreSQLStore::update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+void PostgreSQLStore::create_partitions(const sensors_readings_spans_t& readings) {
 
-    const char* params[3];
-    params[0] = sensor->uuid_string().c_str();
+    for (sensors_readings_spans_cit_t it = readings.begin(); it != readings.end(); ++it) {
 
-    for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
+        //The readings are sorted, so the partition is only looked up when the month changes
+        const ReadingsSpan& span = (*it).second;
+        timestamp_t end = std::numeric_limits<timestamp_t>::min();
 
-        const std::string timestamp = std::to_string(time_converter->convert_to_epoch((*it).first));
-        const std::string value = std::to_string((*it).second);
+        for (size_t i = 0; i < span.size(); i++) {
 
-        params[1] = timestamp.c_str();
-        params[2] = value.c_str();
+            const timestamp_t epoch = time_converter->convert_to_epoch(span.timestamp(i));
+            if (epoch >= end) {
+                end = create_partition(epoch);
+            }
+        }
+    }
+}
 
-        try {
-            execute(UPDATE_READING_STMT, params, 3);
+void PostgreSQLStore::begin_write() {
 
-        } catch (std::exception const& e) {
-            handle_reading_insertion_error(ignore_errors, (*it).first, (*it).second);
-        }
+    //The transaction status is only known once queued statements were executed
+    sync_pipeline();
+    _error_state.clear();
+
+    //Inside a transaction, a failed write is only undone up to the savepoint, so that it can be written again
+    _savepoint = PQtransactionStatus(_connection) == PQTRANS_INTRANS;
+
+    if (_savepoint) {
+        execute("SAVEPOINT readings_write");
+    }
+}
+
+void PostgreSQLStore::end_write() {
+
+    if (_savepoint) {
+        _savepoint = false;
+        execute("RELEASE SAVEPOINT readings_write");
+    }
+}
+
+const bool PostgreSQLStore::undo_write() {
+
+    clear_results();
+
+    if (_savepoint) {
+        _savepoint = false;
+        execute("ROLLBACK TO SAVEPOINT readings_write");
+        execute("RELEASE SAVEPOINT readings_write");
+        return true;
+    }
+
+    //Without a savepoint, the failed write must not have aborted a transaction
+    return PQtransactionStatus(_connection) == PQTRANS_IDLE;
+}
+
+const bool PostgreSQLStore::retry_missing_partition(const std::string& state, bool& retry) {
+
+    //Other stores may have dropped a month that is still cached, its readings are not routed to any partition
+    if (!retry || state != NO_PARTITION_STATE) {
+        return false;
+    }
+
+    LOG("A partition of the readings is missing, the readings are written again.");
+    retry = false;
+    return true;
+}
+
+const timestamp_t PostgreSQLStore::create_partition(const timestamp_t epoch) {
+
+    const bg::date day = bpt::from_time_t(epoch).date();
+    const int year = day.year();
+    const int month = day.month();
+    const timestamp_t begin = get_month_start(year, month);
+    const timestamp_t end = get_month_start(year, month + 1);
+
+    if (_partitions.count(begin) == 0) {
+
+        std::ostringstream oss;
+        oss << "CREATE TABLE IF NOT EXISTS readings_" << year << std::setw(2) << std::setfill('0') << month <<
+                " PARTITION OF readings FOR VALUES FROM (" << begin << ") TO (" << end << ")";
+        execute(oss.str().c_str());
+        _partitions.insert(begin);
+    }
+    return end;
+}
+
+const timestamp_t PostgreSQLStore::get_month_start(const int year, const int month) {
+
+    static const bpt::ptime epoch(bg::date(1970, 1, 1));
+
+    const bpt::ptime start(month > 12 ? bg::date(year + 1, month - 12, 1) : bg::date(year, month, 1));
+    return (start - epoch).total_seconds();
+}
+
+const std::string PostgreSQLStore::compose_sensor_param(const char* param) {
+
+    return std::string(param) + (_partitioned ? "::uuid" : "::varchar");
+}
+
+const std::string PostgreSQLStore::compose_aggregate_stmt(const aggregate_t function) {
+
+    return std::string(SELECT_AGGREGATED_READINGS_STMT) + "_" + std::to_string(function);
+}
+
+const std::string PostgreSQLStore::compose_aggregate_sql(const aggregate_t function) {
+
+    //Results are decoded as doubles, so counts are cast as well
+    switch (function) {
+        case AGGREGATE_AVG:
+            return "AVG(value)";
+        case AGGREGATE_MIN:
+            return "MIN(value)";
+        case AGGREGATE_MAX:
+            return "MAX(value)";
+        case AGGREGATE_SUM:
+            return "SUM(value)";
+        case AGGREGATE_COUNT:
+            return "COUNT(*)::float8";
+        case AGGREGATE_FIRST:
+            return "(ARRAY_AGG(value ORDER BY timestamp))[1]";
+        default:
+            return "(ARRAY_AGG(value ORDER BY timestamp DESC))[1]";
     }
 }
 
 void PostgreSQLStore::prepare_statements() {
 
+    //An existing readings table keeps its layout
+    _partitioned = has_partitioned_table("readings");
+
     prepare_statement(HAS_TABLE_STMT,
-            "SELECT 1 FROM pg_catalog.pg_class WHERE relname = $1 AND relkind = 'r'", 1);
+            "SELECT 1 FROM pg_catalog.pg_class WHERE relname = $1 AND relkind IN ('r', 'p')", 1);
 
     prepare_statement(INSERT_SENSOR_STMT,
             "INSERT INTO sensors (uuid, external_id, name, description, unit, timezone, device_type_id) VALUES ($1::varchar, $2::varchar, $3::varchar, $4::varchar, $5::varchar, $6::varchar, $7::integer)", 7);
@@ -368,33 +821,55 @@ void PostgreSQLStore::prepare_statements() {
     prepare_statement(SELECT_SENSORS_STMT,
             "SELECT uuid, external_id, name, description, unit, timezone, device_type_id FROM sensors", 0);
 
+    const std::string sensor = compose_sensor_param("$1");
+
     prepare_statement(INSERT_READING_STMT,
-            "INSERT INTO readings (uuid, timestamp, value) VALUES ($1::varchar, $2::integer, $3::float8)", 3);
+            ("INSERT INTO readings (uuid, timestamp, value) VALUES (" + sensor + ", $2::integer, $3::float8)").c_str(), 3);
+
+    //Updated readings are staged in a temporary table of the session
+    execute("CREATE TEMPORARY TABLE IF NOT EXISTS staged_readings (LIKE readings INCLUDING DEFAULTS)");
 
-    prepare_statement(COPY_READINGS_STMT,
-            "COPY readings (uuid, timestamp, value) FROM STDIN (FORMAT csv, DELIMITER ',')", 0);
+    prepare_statement(UPSERT_READINGS_STMT,
+            "INSERT INTO readings (uuid, timestamp, value) SELECT uuid, timestamp, value FROM staged_readings "
+            "ON CONFLICT (uuid, timestamp) DO UPDATE SET value = EXCLUDED.value", 0);
 
-    prepare_statement(UPDATE_READING_STMT,
-            "UPDATE readings SET timestamp = $2::integer, value = $3::float8 WHERE uuid = $1::varchar", 3);
+    prepare_statement(INSERT_NEW_READINGS_STMT,
+            "INSERT INTO readings (uuid, timestamp, value) SELECT uuid, timestamp, value FROM staged_readings "
+            "ON CONFLICT (uuid, timestamp) DO NOTHING", 0);
 
     prepare_statement(SELECT_READINGS_STMT,
-            "SELECT timestamp, value FROM readings WHERE uuid = $1::varchar", 1);
+            ("SELECT timestamp, value FROM readings WHERE uuid = " + sensor + " ORDER BY timestamp").c_str(), 1);
 
     prepare_statement(SELECT_TIMEFRAME_READINGS_STMT,
-            "SELECT timestamp, value FROM readings WHERE uuid = $1::varchar AND timestamp BETWEEN $2::integer AND $3::integer", 3);
+            ("SELECT timestamp, value FROM readings WHERE uuid = " + sensor + " AND timestamp BETWEEN $2::integer AND $3::integer ORDER BY timestamp").c_str(), 3);
 
     prepare_statement(COUNT_READINGS_STMT,
-            "SELECT COUNT(*) FROM readings WHERE uuid = $1::varchar", 3);
+            ("SELECT COUNT(*) FROM readings WHERE uuid = " + sensor).c_str(), 3);
 
     prepare_statement(SELECT_LAST_READING_STMT,
-            "SELECT timestamp, value FROM readings WHERE uuid = $1::varchar ORDER BY timestamp DESC LIMIT 1", 1);
+            ("SELECT timestamp, value FROM readings WHERE uuid = " + sensor + " ORDER BY timestamp DESC LIMIT 1").c_str(), 1);
 
     prepare_statement(SELECT_READING_STMT,
-            "SELECT timestamp, value FROM readings WHERE uuid = $1::varchar AND timestamp = $2::integer", 1);
+            ("SELECT timestamp, value FROM readings WHERE uuid = " + sensor + " AND timestamp = $2::integer").c_str(), 1);
+
+    prepare_statement(SELECT_SUMMARY_STMT,
+            ("SELECT COUNT(*), MIN(timestamp), MAX(timestamp), MIN(value), MAX(value), SUM(value), "
+            "(SELECT value FROM readings WHERE uuid = " + sensor + " ORDER BY timestamp DESC LIMIT 1) "
+            "FROM readings WHERE uuid = " + sensor).c_str(), 1);
+
+    //Buckets start at multiples of $4, the modulo is corrected for timestamps before the epoch
+    for (int function = AGGREGATE_AVG; function <= AGGREGATE_LAST; function++) {
+
+        prepare_statement(compose_aggregate_stmt((aggregate_t) function).c_str(),
+                ("SELECT timestamp - ((timestamp % $4::integer) + $4::integer) % $4::integer AS bucket, " + compose_aggregate_sql((aggregate_t) function) +
+                " FROM readings WHERE uuid = " + sensor + " AND timestamp BETWEEN $2::integer AND $3::integer GROUP BY bucket ORDER BY bucket").c_str(), 4);
+    }
 }
 
 void PostgreSQLStore::prepare_statement(const char* statement_name, const char* statement, const int num_params) {
 
+    sync_pipeline();
+
     PGresult* result = NULL;
     try {
         result = PQprepare(_connection, statement_name, statement, num_params, NULL);
@@ -414,31 +889,51 @@ void PostgreSQLStore::finalize_statements() {
 
 readings_t_Ptr PostgreSQLStore::get_reading_records(const char* statement_name, const char* params[], const int num_params) {
 
-    //Previous insertions
-    clear_results();
+    //Only one batch of rows is held besides the readings, instead of the whole result
+    ReadingsCursor::Ptr cursor = get_reading_records_cursor(statement_name, params, num_params);
 
-    PGresult* result = NULL;
-    try {
-        result = execute(statement_name, params, num_params, PGRES_TUPLES_OK);
+    readings_t_Ptr readings(new readings_t());
+    reading_t reading;
 
-        readings_t_Ptr readings(new readings_t());
-        int num_rows = PQntuples(result);
+    //The rows are sorted by timestamp, so each reading is appended at the end
+    while (cursor->next(reading)) {
+        readings->insert(readings->end(), reading);
+    }
+    return readings;
+}
 
-        for (int row = 0; row < num_rows; row++) {
-            readings->insert(parse_reading(result, row));
-        }
+ReadingsCursor::Ptr PostgreSQLStore::get_reading_records_cursor(const char* statement_name, const char* params[], const int num_params) {
 
-        clear(result);
-        return readings;
+    //Previous insertions
+    clear_results();
 
-    } catch (std::exception const& e) {
-        clear(result);
-        throw e;
+    //Timestamps and values are decoded from binary results
+    if (!PQsendQueryPrepared(_connection, statement_name, num_params, params, NULL, NULL, 1)) {
+        std::ostringstream oss;
+        oss << "Can't execute SQL statement. Error: " << PQerrorMessage(_connection);
+        throw StoreException(oss.str());
     }
+
+    //The cursor takes care of the query results from now on
+    PostgreSQLReadingsCursor::Ptr cursor(new PostgreSQLReadingsCursor(_connection, time_converter));
+    _cursor = cursor;
+
+#ifdef LIBPQ_HAS_CHUNK_MODE
+    if (!PQsetChunkedRowsMode(_connection, FETCH_SIZE)) {
+#else
+    if (!PQsetSingleRowMode(_connection)) {
+#endif
+        std::ostringstream oss;
+        oss << "Can't fetch readings in batches. Error: " << PQerrorMessage(_connection);
+        throw StoreException(oss.str());
+    }
+    return cursor;
 }
 
 void PostgreSQLStore::execute(const char* statement) {
 
+    sync_pipeline();
+
     PGresult* result = NULL;
     try {
         result = PQexec(_connection, statement);
@@ -453,6 +948,11 @@ void PostgreSQLStore::execute(const char* statement) {
 
 void PostgreSQLStore::execute(const char* statement_name, const char* params[], const int num_params) {
 
+    execute(statement_name, params, num_params, statement_name, false);
+}
+
+void PostgreSQLStore::execute(const char* statement_name, const char* params[], const int num_params, const std::string& description, const bool ignore_errors) {
+
     if (_synchronous) {
 
         PGresult* result = NULL;
@@ -465,13 +965,17 @@ void PostgreSQLStore::execute(const char* statement_name, const char* params[],
             throw e;
         }
     } else {
-        int code = PQsendQueryPrepared(_connection, statement_name, num_params, params, NULL, NULL, 0);
-        check(code);
+        check_cursor();
+
+        //Results are reaped before the next statement that has to wait for them
+        _pipeline->send(statement_name, params, num_params, description, ignore_errors);
     }
 }
 
 PGresult* PostgreSQLStore::execute(const char* statement_name, const char* params[], const int num_params, const ExecStatusType expected_status) {
 
+    sync_pipeline();
+
     PGresult* result = PQexecPrepared(_connection, statement_name, num_params, params, NULL, NULL, 0);
     check(result, expected_status);
     return result;
@@ -485,6 +989,9 @@ void PostgreSQLStore::check(PGresult* result, const ExecStatusType expected_stat
 
         if (status != expected_status) {
 
+            const char* state = PQresultErrorField(result, PG_DIAG_SQLSTATE);
+            _error_state = state ? state : "";
+
             std::ostringstream oss;
             oss << "Can't execute SQL statement. Error: " << PQerrorMessage(_connection) << ", Error code: " << status;
             clear(result);
@@ -506,8 +1013,39 @@ void PostgreSQLStore::check(const int result) {
     }
 }
 
+void PostgreSQLStore::sync_pipeline() {
+
+    //Every statement passes here, it would discard the rows of the cursor
+    check_cursor();
+
+    if (_pipeline) {
+        _pipeline->sync();
+    }
+}
+
+void PostgreSQLStore::check_cursor() {
+
+    const PostgreSQLReadingsCursor::Ptr cursor = _cursor.lock();
+
+    if (cursor && !cursor->done()) {
+        throw StoreException("The connection is busy with the readings of an open cursor.");
+    }
+}
+
+void PostgreSQLStore::interrupt_cursor() {
+
+    const PostgreSQLReadingsCursor::Ptr cursor = _cursor.lock();
+
+    if (cursor) {
+        cursor->interrupt();
+    }
+    _cursor.reset();
+}
+
 void PostgreSQLStore::clear_results() {
 
+    sync_pipeline();
+
     PGresult* result = NULL;
     do {
         clear(result);
@@ -515,6 +1053,22 @@ void PostgreSQLStore::clear_results() {
     } while (result);
 }
 
+void PostgreSQLStore::put_copy_data(const std::string& buffer) {
+
+    check(PQputCopyData(_connection, buffer.data(), buffer.size()));
+}
+
+void PostgreSQLStore::end_copy() {
+
+    check(PQputCopyEnd(_connection, NULL));
+
+    //Errors in the copied rows, such as duplicate readings, are reported when the COPY ends
+    PGresult* result = PQgetResult(_connection);
+    check(result, PGRES_COMMAND_OK);
+    clear(result);
+    clear_results();
+}
+
 void PostgreSQLStore::clear(PGresult* result) {
 
     if (result) {
@@ -535,14 +1089,6 @@ Sensor::Ptr PostgreSQLStore::parse_sensor(PGresult* result, const int row) {
             );
 }
 
-reading_t PostgreSQLStore::parse_reading(PGresult* result, const int row) {
-
-    return std::pair<timestamp_t, double>(
-            time_converter->convert_from_epoch(get_long_value(result, row, 0)),
-            get_double_value(result, row, 1)
-            );
-}
-
 std::string PostgreSQLStore::get_string_value(PGresult* result, const int row, const int col) {
 
     return std::string(PQgetvalue(result, row, col));
@@ -24,11 +24,16 @@
 
 #ifdef ENABLE_POSTGRESQL
 
+#include <set>
 #include <stdio.h>
 #include <stdlib.h>
+#include <boost/weak_ptr.hpp>
 #include <postgresql/libpq-fe.h>
 #include <libklio/store.hpp>
 #include <libklio/postgresql/postgresql-transaction.hpp>
+#include <libklio/postgresql/postgresql-readings-cursor.hpp>
+#include <libklio/postgresql/postgresql-codec.hpp>
+#include <libklio/postgresql/postgresql-pipeline.hpp>
 
 
 namespace klio {
@@ -47,6 +52,31 @@ namespace klio {
         Store(auto_commit, auto_flush, flush_timeout, 10, 100000),
         _info(info),
         _synchronous(synchronous),
+        _partitioned(false),
+        _savepoint(false),
+        _connection(NULL) {
+        };
+
+        /**
+         * A partitioned store keeps the sensor ids of its readings as native
+         * uuids, and splits the readings table into monthly partitions with
+         * a BRIN index on the timestamps. Partitions are created when
+         * readings are flushed into them. An existing readings table is used
+         * with the layout it was created with.
+         */
+        PostgreSQLStore(
+                const std::string& info,
+                const bool auto_commit,
+                const bool auto_flush,
+                const timestamp_t flush_timeout,
+                const bool synchronous,
+                const bool partitioned
+                ) :
+        Store(auto_commit, auto_flush, flush_timeout, 10, 100000),
+        _info(info),
+        _synchronous(synchronous),
+        _partitioned(partitioned),
+        _savepoint(false),
         _connection(NULL) {
         };
 
@@ -58,6 +88,10 @@ namespace klio {
             return _info;
         };
 
+        const bool partitioned() const {
+            return _partitioned;
+        };
+
         void open();
         void close();
         void check_integrity();
@@ -67,25 +101,42 @@ namespace klio {
         void dispose();
         const std::string str();
 
+        /**
+         * Drops the monthly partitions of a partitioned store that only
+         * hold readings before the given time, and returns their number.
+         */
+        const unsigned int drop_partitions(const timestamp_t before);
+
         static const std::string DEFAULT_CONNECTION_INFO;
 
     protected:
         Transaction::Ptr get_transaction_handler();
 
+        //Queued statements are reaped, so that their errors reach the caller of the operation that queued them
+        void auto_commit_transaction(const Transaction::Ptr transaction);
+
         void add_sensor_record(const Sensor::Ptr sensor);
         void remove_sensor_record(const Sensor::Ptr sensor);
         void update_sensor_record(const Sensor::Ptr sensor);
         void add_single_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const bool ignore_errors);
-        void add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors);
-        void update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors);
+        void add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
+        void update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
+        void add_batch_reading_records(const sensors_readings_spans_t& readings, const bool ignore_errors);
 
         std::vector<Sensor::Ptr> get_sensor_records();
         readings_t_Ptr get_all_reading_records(const Sensor::Ptr sensor);
         readings_t_Ptr get_timeframe_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end);
+        ReadingsCursor::Ptr get_all_reading_records_cursor(const Sensor::Ptr sensor);
+        ReadingsCursor::Ptr get_timeframe_reading_records_cursor(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end);
         unsigned long int get_num_readings_value(const Sensor::Ptr sensor);
         reading_t get_last_reading_record(const Sensor::Ptr sensor);
+        SensorSummary get_sensor_summary_record(const Sensor::Ptr sensor);
         reading_t get_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp);
 
+        //The readings are aggregated by a prepared GROUP BY query per function
+        readings_t_Ptr get_aggregated_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+                const timestamp_t bucket, const aggregate_t function);
+
     private:
         PostgreSQLStore(const PostgreSQLStore& original);
         PostgreSQLStore& operator =(const PostgreSQLStore& rhs);
@@ -99,27 +150,52 @@ namespace klio {
         PostgreSQLTransaction::Ptr create_transaction_handler();
 
         const bool has_table(const char* name);
+        const bool has_partitioned_table(const char* name);
+        void create_partitions(const sensors_readings_spans_t& readings);
+        const timestamp_t create_partition(const timestamp_t epoch);
+        void begin_write();
+        void end_write();
+        const bool undo_write();
+        const bool retry_missing_partition(const std::string& state, bool& retry);
+        const timestamp_t get_month_start(const int year, const int month);
+        const std::string compose_sensor_param(const char* param);
+        const std::string compose_aggregate_stmt(const aggregate_t function);
+        const std::string compose_aggregate_sql(const aggregate_t function);
 
         readings_t_Ptr get_reading_records(const char* statement_name, const char* params[], const int num_params);
+        ReadingsCursor::Ptr get_reading_records_cursor(const char* statement_name, const char* params[], const int num_params);
 
         void execute(const char* statement);
         void execute(const char* statement_name, const char* params[], const int num_params);
+        void execute(const char* statement_name, const char* params[], const int num_params, const std::string& description, const bool ignore_errors);
         PGresult* execute(const char* statement_name, const char* params[], const int num_params, const ExecStatusType expected_status);
         void clear_results();
+        void sync_pipeline();
+        void check_cursor();
+        void interrupt_cursor();
+        void copy_readings(const char* statement, const sensors_readings_spans_t& readings);
+        const unsigned long int stage_readings(const sensors_readings_spans_t& readings, const char* statement_name);
+        void put_copy_data(const std::string& buffer);
+        void end_copy();
         void check(const int result);
         void check(PGresult* result, const ExecStatusType expected_status);
         void clear(PGresult* result);
 
         Sensor::Ptr parse_sensor(PGresult* result, const int row);
-        reading_t parse_reading(PGresult* result, const int row);
         std::string get_string_value(PGresult* result, const int row, const int col);
         unsigned long int get_long_value(PGresult* result, const int row, const int col);
         double get_double_value(PGresult* result, const int row, const int col);
 
         std::string _info;
         bool _synchronous;
+        bool _partitioned;
+        std::set<timestamp_t> _partitions;
+        bool _savepoint;
+        std::string _error_state;
         PGconn* _connection;
         PostgreSQLTransaction::Ptr _transaction;
+        PostgreSQLPipeline::Ptr _pipeline;
+        boost::weak_ptr<PostgreSQLReadingsCursor> _cursor;
 
         static const char* HAS_TABLE_STMT;
         static const char* INSERT_SENSOR_STMT;
@@ -127,13 +203,23 @@ namespace klio {
         static const char* UPDATE_SENSOR_STMT;
         static const char* SELECT_SENSORS_STMT;
         static const char* INSERT_READING_STMT;
-        static const char* COPY_READINGS_STMT;
-        static const char* UPDATE_READING_STMT;
+        static const char* UPSERT_READINGS_STMT;
+        static const char* INSERT_NEW_READINGS_STMT;
         static const char* SELECT_READINGS_STMT;
         static const char* SELECT_TIMEFRAME_READINGS_STMT;
         static const char* COUNT_READINGS_STMT;
         static const char* SELECT_LAST_READING_STMT;
         static const char* SELECT_READING_STMT;
+        static const char* SELECT_SUMMARY_STMT;
+        static const char* SELECT_AGGREGATED_READINGS_STMT;
+
+        static const char* COPY_READINGS_SQL;
+        static const char* COPY_STAGED_READINGS_SQL;
+        static const size_t COPY_CHUNK_SIZE;
+        static const size_t MAX_PENDING_STATEMENTS;
+        static const int FETCH_SIZE;
+        static const char* NO_PARTITION_STATE;
+        static const char* DUPLICATE_KEY_STATE;
     };
 };
 
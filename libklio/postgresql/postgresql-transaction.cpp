@@ -18,6 +18,10 @@ void PostgreSQLTransaction::start() {
     } else if (_pending) {
         LOG("Transaction is already started.");
 
+    } else if (_pipeline) {
+        _pipeline->send("BEGIN", false);
+        _pending = true;
+
     } else {
 
         PGresult *result = PQexec(_connection, "BEGIN");
@@ -40,6 +44,13 @@ void PostgreSQLTransaction::commit() {
         //FIXME: raise an exception
         LOG("Database is not open.");
 
+    } else if (_pending && _pipeline) {
+        _pipeline->send("COMMIT", false);
+        _pending = false;
+
+        //Statements of the transaction that failed are reported by the commit
+        _pipeline->sync();
+
     } else if (_pending) {
 
         PGresult *result = PQexec(_connection, "COMMIT");
@@ -65,6 +76,16 @@ void PostgreSQLTransaction::rollback() {
         //FIXME: raise an exception
         LOG("Database is not open.");
 
+    } else if (_pending && _pipeline) {
+        _pending = false;
+
+        try {
+            _pipeline->send("ROLLBACK", true);
+
+        } catch (std::exception const& e) {
+            LOG("Can't rollback transaction: " << e.what());
+        }
+
     } else if (_pending) {
 
         PGresult *result = PQexec(_connection, "ROLLBACK");
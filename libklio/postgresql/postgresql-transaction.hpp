@@ -22,6 +22,7 @@
 
 #include <postgresql/libpq-fe.h>
 #include <libklio/transaction.hpp>
+#include <libklio/postgresql/postgresql-pipeline.hpp>
 
 
 namespace klio {
@@ -35,6 +36,13 @@ namespace klio {
         _connection(connection) {
         }
 
+        //Transactions of asynchronous stores queue their statements in the pipeline
+        PostgreSQLTransaction(PGconn* connection, const PostgreSQLPipeline::Ptr pipeline) :
+        Transaction(),
+        _connection(connection),
+        _pipeline(pipeline) {
+        }
+
         virtual ~PostgreSQLTransaction() {
             rollback();
         }
@@ -52,6 +60,7 @@ namespace klio {
         PostgreSQLTransaction& operator=(const PostgreSQLTransaction& rhs);
 
         PGconn* _connection;
+        PostgreSQLPipeline::Ptr _pipeline;
     };
 };
 
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <libklio/readings-buffer.hpp>
+
+
+using namespace klio;
+
+const ReadingsSpan ReadingsSpan::sub(const size_t offset, const size_t length) const {
+
+    if (offset >= _size) {
+        return ReadingsSpan();
+    }
+    return ReadingsSpan(_timestamps + offset, _values + offset, std::min(length, _size - offset));
+}
+
+void ReadingsBuffer::insert(const timestamp_t timestamp, const double value) {
+
+    //Appending readings in strictly ascending order keeps the buffer compacted
+    if (_sorted && !_timestamps.empty() && timestamp <= _timestamps.back()) {
+        _sorted = false;
+    }
+    _timestamps.push_back(timestamp);
+    _values.push_back(value);
+}
+
+void ReadingsBuffer::insert(const readings_t& readings) {
+
+    _timestamps.reserve(_timestamps.size() + readings.size());
+    _values.reserve(_values.size() + readings.size());
+
+    for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
+        insert((*it).first, (*it).second);
+    }
+}
+
+struct timestamp_index_less {
+
+    timestamp_index_less(const std::vector<timestamp_t>& timestamps) :
+    _timestamps(timestamps) {
+    }
+
+    bool operator()(const size_t lhs, const size_t rhs) const {
+        return _timestamps[lhs] < _timestamps[rhs];
+    }
+
+    const std::vector<timestamp_t>& _timestamps;
+};
+
+void ReadingsBuffer::compact() {
+
+    if (_sorted) {
+        return;
+    }
+
+    const size_t num_readings = _timestamps.size();
+    std::vector<size_t> order(num_readings);
+
+    for (size_t i = 0; i < num_readings; i++) {
+        order[i] = i;
+    }
+
+    //A stable sort keeps the first buffered value of each timestamp in front
+    std::stable_sort(order.begin(), order.end(), timestamp_index_less(_timestamps));
+
+    std::vector<timestamp_t> timestamps;
+    std::vector<double> values;
+    timestamps.reserve(num_readings);
+    values.reserve(num_readings);
+
+    for (std::vector<size_t>::const_iterator it = order.begin(); it != order.end(); ++it) {
+
+        if (timestamps.empty() || timestamps.back() != _timestamps[*it]) {
+            timestamps.push_back(_timestamps[*it]);
+            values.push_back(_values[*it]);
+        }
+    }
+
+    _timestamps.swap(timestamps);
+    _values.swap(values);
+    _sorted = true;
+}
+
+void ReadingsBuffer::clear() {
+
+    _timestamps.clear();
+    _values.clear();
+    _sorted = true;
+}
+
+const ReadingsSpan ReadingsBuffer::span() const {
+
+    return span(0, _timestamps.size());
+}
+
+const ReadingsSpan ReadingsBuffer::span(const size_t offset, const size_t length) const {
+
+    if (_timestamps.empty()) {
+        return ReadingsSpan();
+    }
+    return ReadingsSpan(&_timestamps[0], &_values[0], _timestamps.size()).sub(offset, length);
+}
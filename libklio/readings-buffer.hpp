@@ -0,0 +1,143 @@
+/**
+ * This file is part of libklio.
+ *
+ * (c) Fraunhofer ITWM
+ *
+ * libklio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libklio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libklio. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKLIO_READINGS_BUFFER_HPP
+#define LIBKLIO_READINGS_BUFFER_HPP 1
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <libklio/common.hpp>
+#include <libklio/types.hpp>
+
+
+namespace klio {
+
+    /**
+     * Read-only view of a contiguous range of readings, stored as two
+     * parallel arrays of timestamps and values. A span does not own its
+     * data and is only valid as long as the buffer it was taken from is
+     * not modified.
+     */
+    class ReadingsSpan {
+    public:
+
+        ReadingsSpan() :
+        _timestamps(NULL),
+        _values(NULL),
+        _size(0) {
+        };
+
+        ReadingsSpan(const timestamp_t* timestamps, const double* values, const size_t size) :
+        _timestamps(timestamps),
+        _values(values),
+        _size(size) {
+        };
+
+        const size_t size() const {
+            return _size;
+        };
+
+        const bool empty() const {
+            return _size == 0;
+        };
+
+        const timestamp_t timestamp(const size_t index) const {
+            return _timestamps[index];
+        };
+
+        const double value(const size_t index) const {
+            return _values[index];
+        };
+
+        const reading_t reading(const size_t index) const {
+            return reading_t(_timestamps[index], _values[index]);
+        };
+
+        const timestamp_t* timestamps() const {
+            return _timestamps;
+        };
+
+        const double* values() const {
+            return _values;
+        };
+
+        const ReadingsSpan sub(const size_t offset, const size_t length) const;
+
+    private:
+        const timestamp_t* _timestamps;
+        const double* _values;
+        size_t _size;
+    };
+
+    //Readings of several sensors, written to the database in a single batch
+    typedef std::pair<Sensor::Ptr, ReadingsSpan> sensor_readings_span_t;
+    typedef std::vector<sensor_readings_span_t> sensors_readings_spans_t;
+    typedef std::vector<sensor_readings_span_t>::const_iterator sensors_readings_spans_cit_t;
+
+    /**
+     * Write buffer for readings. Readings are appended to a timestamp array
+     * and a value array, so buffering a reading does not allocate a node per
+     * sample. Sorting and the removal of duplicated timestamps are deferred
+     * until compact() is invoked, which happens once per flush.
+     *
+     * When a timestamp is buffered more than once, the first value is kept.
+     */
+    class ReadingsBuffer {
+    public:
+        typedef boost::shared_ptr<ReadingsBuffer> Ptr;
+
+        ReadingsBuffer() :
+        _sorted(true) {
+        };
+
+        virtual ~ReadingsBuffer() {
+        };
+
+        const size_t size() const {
+            return _timestamps.size();
+        };
+
+        const bool empty() const {
+            return _timestamps.empty();
+        };
+
+        //Estimated memory used by the buffered readings
+        const size_t bytes() const {
+            return _timestamps.size() * sizeof (timestamp_t) + _values.size() * sizeof (double);
+        };
+
+        void insert(const timestamp_t timestamp, const double value);
+        void insert(const readings_t& readings);
+        void compact();
+        void clear();
+
+        const ReadingsSpan span() const;
+        const ReadingsSpan span(const size_t offset, const size_t length) const;
+
+    private:
+        ReadingsBuffer(const ReadingsBuffer& original);
+        ReadingsBuffer& operator=(const ReadingsBuffer& rhs);
+
+        std::vector<timestamp_t> _timestamps;
+        std::vector<double> _values;
+        bool _sorted;
+    };
+};
+
+#endif /* LIBKLIO_READINGS_BUFFER_HPP */
@@ -0,0 +1,14 @@
+#include <libklio/readings-cursor.hpp>
+
+
+using namespace klio;
+
+bool MapReadingsCursor::next(reading_t& reading) {
+
+    if (_it == _readings->end()) {
+        return false;
+    }
+    reading = *_it;
+    ++_it;
+    return true;
+}
@@ -0,0 +1,86 @@
+/**
+ * This file is part of libklio.
+ *
+ * (c) Fraunhofer ITWM
+ *
+ * libklio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libklio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libklio. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKLIO_READINGS_CURSOR_HPP
+#define LIBKLIO_READINGS_CURSOR_HPP 1
+
+#include <boost/shared_ptr.hpp>
+#include <libklio/common.hpp>
+#include <libklio/types.hpp>
+
+
+namespace klio {
+
+    /**
+     * Forward-only cursor over the readings of a sensor. Readings are
+     * fetched from the store while the cursor advances, so only a small
+     * batch of them is held in memory at any time.
+     */
+    class ReadingsCursor {
+    public:
+        typedef boost::shared_ptr<ReadingsCursor> Ptr;
+
+        virtual ~ReadingsCursor() {
+        };
+
+        /**
+         * Fetches the next reading. Returns false when there are no more
+         * readings, in which case the argument is not modified.
+         */
+        virtual bool next(reading_t& reading) = 0;
+
+    protected:
+
+        ReadingsCursor() {
+        };
+
+    private:
+        ReadingsCursor(const ReadingsCursor& original);
+        ReadingsCursor& operator=(const ReadingsCursor& rhs);
+    };
+
+    /**
+     * Cursor over readings that are already loaded into memory. It is used
+     * by stores that can not fetch readings incrementally.
+     */
+    class MapReadingsCursor : public ReadingsCursor {
+    public:
+        typedef boost::shared_ptr<MapReadingsCursor> Ptr;
+
+        MapReadingsCursor(const readings_t_Ptr readings) :
+        ReadingsCursor(),
+        _readings(readings),
+        _it(readings->begin()) {
+        };
+
+        virtual ~MapReadingsCursor() {
+        };
+
+        bool next(reading_t& reading);
+
+    private:
+        MapReadingsCursor(const MapReadingsCursor& original);
+        MapReadingsCursor& operator=(const MapReadingsCursor& rhs);
+
+        readings_t_Ptr _readings;
+        readings_cit_t _it;
+    };
+};
+
+#endif /* LIBKLIO_READINGS_CURSOR_HPP */
@@ -0,0 +1,59 @@
+#include <libklio/config.h>
+
+#ifdef ENABLE_REDIS3M
+
+#include <sstream>
+#include <libklio/redis/redis-connection-pool.hpp>
+
+
+using namespace klio;
+
+redis3m::connection::ptr_t RedisConnectionPool::get() {
+
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+
+        //Connections that were closed by the server while they were idle are dropped
+        while (!_idle.empty()) {
+
+            const redis3m::connection::ptr_t connection = _idle.front();
+            _idle.pop_front();
+
+            if (connection->is_valid()) {
+                return connection;
+            }
+        }
+    }
+    return create_connection();
+}
+
+void RedisConnectionPool::put(const redis3m::connection::ptr_t connection) {
+
+    boost::mutex::scoped_lock lock(_mutex);
+
+    if (connection && connection->is_valid() && _idle.size() < _max_idle) {
+        _idle.push_back(connection);
+    }
+}
+
+const size_t RedisConnectionPool::idle() {
+
+    boost::mutex::scoped_lock lock(_mutex);
+    return _idle.size();
+}
+
+redis3m::connection::ptr_t RedisConnectionPool::create_connection() {
+
+    const redis3m::connection::ptr_t connection = redis3m::connection::create(_host, _port);
+
+    std::ostringstream index;
+    index << _db;
+    const redis3m::reply status = connection->run(redis3m::command("SELECT")(index.str()));
+
+    if (status.str() != "OK") {
+        throw StoreException("DB cannot be selected.");
+    }
+    return connection;
+}
+
+#endif /* ENABLE_REDIS3M */
@@ -0,0 +1,93 @@
+/**
+ * This file is part of libklio.
+ *
+ * (c) Fraunhofer ITWM
+ *
+ * libklio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libklio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libklio. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKLIO_REDIS_CONNECTION_POOL_HPP
+#define LIBKLIO_REDIS_CONNECTION_POOL_HPP 1
+
+#include <libklio/config.h>
+
+#ifdef ENABLE_REDIS3M
+
+#include <deque>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <redis3m/redis3m.hpp>
+#include <libklio/common.hpp>
+
+
+namespace klio {
+
+    /**
+     * Connections to one Redis database, shared by the stores of several
+     * threads. A store borrows a connection when it is opened and returns
+     * it when it is closed, so readers can open short-lived stores
+     * without connecting each time. At most max_idle connections are
+     * kept open while they are not borrowed.
+     */
+    class RedisConnectionPool {
+    public:
+        typedef boost::shared_ptr<RedisConnectionPool> Ptr;
+
+        RedisConnectionPool(const std::string& host,
+                const unsigned int port,
+                const unsigned int db,
+                const size_t max_idle) :
+        _host(host),
+        _port(port),
+        _db(db),
+        _max_idle(max_idle) {
+        };
+
+        virtual ~RedisConnectionPool() {
+        };
+
+        const std::string host() const {
+            return _host;
+        };
+
+        const unsigned int port() const {
+            return _port;
+        };
+
+        const unsigned int db() const {
+            return _db;
+        };
+
+        redis3m::connection::ptr_t get();
+        void put(const redis3m::connection::ptr_t connection);
+        const size_t idle();
+
+    private:
+        RedisConnectionPool(const RedisConnectionPool& original);
+        RedisConnectionPool& operator=(const RedisConnectionPool& rhs);
+
+        redis3m::connection::ptr_t create_connection();
+
+        std::string _host;
+        unsigned int _port;
+        unsigned int _db;
+        size_t _max_idle;
+        std::deque<redis3m::connection::ptr_t> _idle;
+        boost::mutex _mutex;
+    };
+};
+
+#endif /* ENABLE_REDIS3M */
+
+#endif /* LIBKLIO_REDIS_CONNECTION_POOL_HPP */
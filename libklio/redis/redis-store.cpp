@@ -2,6 +2,8 @@
 
 #ifdef ENABLE_REDIS3M
 
+#include <iomanip>
+#include <limits>
 #include <libklio/redis/redis-store.hpp>
 
 
@@ -15,6 +17,8 @@ const std::string RedisStore::OK = "OK";
 const std::string RedisStore::SENSORS_KEY = "libklio:sensors";
 const std::string RedisStore::SENSOR_KEY = "libklio:sensor:";
 const std::string RedisStore::READINGS_KEY = ":readings";
+const std::string RedisStore::LAYOUT_KEY = "libklio:layout";
+const std::string RedisStore::SORTED_SET_LAYOUT = "zset";
 
 const std::string RedisStore::SADD = "SADD";
 const std::string RedisStore::SMEMBERS = "SMEMBERS";
@@ -23,29 +27,88 @@ const std::string RedisStore::SREM = "SREM";
 const std::string RedisStore::HMSET = "HMSET";
 const std::string RedisStore::HMGET = "HMGET";
 const std::string RedisStore::HGETALL = "HGETALL";
-const std::string RedisStore::HGET = "HGET";
 const std::string RedisStore::HDEL = "HDEL";
-const std::string RedisStore::HKEYS = "HKEYS";
+
+const std::string RedisStore::ZADD = "ZADD";
+const std::string RedisStore::ZRANGEBYSCORE = "ZRANGEBYSCORE";
+const std::string RedisStore::ZREMRANGEBYSCORE = "ZREMRANGEBYSCORE";
+const std::string RedisStore::ZREVRANGE = "ZREVRANGE";
+const std::string RedisStore::ZCARD = "ZCARD";
+
+const std::string RedisStore::EVALSHA = "EVALSHA";
+const std::string RedisStore::SCRIPT = "SCRIPT";
+
+//Buckets the members "<timestamp>:<value>" of the readings between ARGV[1] and ARGV[2]
+//into intervals of ARGV[3] seconds and combines them with the function ARGV[4].
+//Values are returned as strings, since Redis truncates Lua numbers to integers.
+const std::string RedisStore::AGGREGATION_SCRIPT =
+        "local members = redis.call('ZRANGEBYSCORE', KEYS[1], ARGV[1], ARGV[2])\n"
+        "local size = tonumber(ARGV[3])\n"
+        "local fn = ARGV[4]\n"
+        "local result = {}\n"
+        "local interval, value, count\n"
+        "local function complete()\n"
+        "  if fn == 'avg' then value = value / count elseif fn == 'count' then value = count end\n"
+        "  result[#result + 1] = string.format('%d', interval)\n"
+        "  result[#result + 1] = string.format('%.17g', value)\n"
+        "end\n"
+        "for _, member in ipairs(members) do\n"
+        "  local separator = string.find(member, ':', 1, true)\n"
+        "  local timestamp = tonumber(string.sub(member, 1, separator - 1))\n"
+        "  local reading = tonumber(string.sub(member, separator + 1))\n"
+        "  local start = math.floor(timestamp / size) * size\n"
+        "  if start ~= interval then\n"
+        "    if interval then complete() end\n"
+        "    interval, value, count = start, reading, 1\n"
+        "  else\n"
+        "    count = count + 1\n"
+        "    if fn == 'avg' or fn == 'sum' then value = value + reading\n"
+        "    elseif fn == 'min' then value = math.min(value, reading)\n"
+        "    elseif fn == 'max' then value = math.max(value, reading)\n"
+        "    elseif fn == 'last' then value = reading end\n"
+        "  end\n"
+        "end\n"
+        "if interval then complete() end\n"
+        "return result\n";
 
 const std::string RedisStore::DEL = "DEL";
+const std::string RedisStore::GET = "GET";
+const std::string RedisStore::SET = "SET";
+const std::string RedisStore::RENAME = "RENAME";
 const std::string RedisStore::SELECT = "SELECT";
 const std::string RedisStore::FLUSHDB = "FLUSHDB";
 
 void RedisStore::open() {
 
     if (!_connection) {
-        _connection = connection::create(_host, _port);
-        run_select(_db);
+
+        if (_pool) {
+            _connection = _pool->get();
+
+        } else {
+            _connection = connection::create(_host, _port);
+            run_select(_db);
+        }
+        load_layout();
         _transaction = create_transaction_handler();
     }
 }
 
 void RedisStore::close() {
 
+    stop_async_flush();
+
     //FIXME: close connection
     if (_connection && _transaction) {
         _transaction->rollback();
     }
+
+    //Pooled connections are returned without a pending transaction
+    if (_connection && _pool) {
+        _transaction.reset();
+        _pool->put(_connection);
+        _connection.reset();
+    }
     clear_buffers();
 }
 
@@ -63,12 +126,33 @@ void RedisStore::initialize() {
 
 void RedisStore::dispose() {
 
+    stop_async_flush();
+
     if (_connection) {
         run_flushdb();
     }
     close();
 }
 
+void RedisStore::upgrade() {
+
+    LOG("Upgrading the readings layout of " << str());
+
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+
+    if (!_legacy_layout) {
+        return;
+    }
+
+    const std::vector<reply> keys = run_smembers(SENSORS_KEY);
+
+    for (std::vector<reply>::const_iterator key = keys.begin(); key != keys.end(); key++) {
+        upgrade_readings((*key).str());
+    }
+    run_set(LAYOUT_KEY, SORTED_SET_LAYOUT);
+    _legacy_layout = false;
+}
+
 Transaction::Ptr RedisStore::get_transaction_handler() {
 
     return _auto_commit ? create_transaction_handler() : _transaction;
@@ -90,24 +174,27 @@ void RedisStore::add_sensor_record(const Sensor::Ptr sensor) {
 
     const std::string key = check_sensor_existence(sensor, false);
 
-    run_hmset_sensor(key, sensor);
-    run_sadd(SENSORS_KEY, key);
+    append_hmset_sensor(key, sensor);
+    _connection->append(command(SADD)(SENSORS_KEY) (key));
+    check_replies(_connection->get_replies(2));
 }
 
 void RedisStore::remove_sensor_record(const Sensor::Ptr sensor) {
 
     const std::string key = check_sensor_existence(sensor, true);
 
-    run_hdel_sensor(key);
-    run_del_readings(sensor);
-    run_srem(SENSORS_KEY, key);
+    append_hdel_sensor(key);
+    _connection->append(command(DEL)(compose_readings_key(sensor)));
+    _connection->append(command(SREM)(SENSORS_KEY) (key));
+    check_replies(_connection->get_replies(3));
 }
 
 void RedisStore::update_sensor_record(const Sensor::Ptr sensor) {
 
     const std::string key = check_sensor_existence(sensor, true);
 
-    run_hmset_sensor(key, sensor);
+    append_hmset_sensor(key, sensor);
+    check_replies(_connection->get_replies(1));
 }
 
 std::vector<Sensor::Ptr> RedisStore::get_sensor_records() {
@@ -115,11 +202,16 @@ std::vector<Sensor::Ptr> RedisStore::get_sensor_records() {
     std::vector<Sensor::Ptr> sensors;
     const std::vector<reply> keys = run_smembers(SENSORS_KEY);
 
+    //The properties of all sensors are requested in one pipeline
     for (std::vector<reply>::const_iterator key = keys.begin(); key != keys.end(); key++) {
+        append_hmget_sensor((*key).str());
+    }
 
-        sensors.push_back(
-                run_hmget_sensor((*key).str())
-                );
+    const std::vector<reply> replies = _connection->get_replies(keys.size());
+    check_replies(replies);
+
+    for (std::vector<reply>::const_iterator it = replies.begin(); it != replies.end(); ++it) {
+        sensors.push_back(create_sensor(*it));
     }
     return sensors;
 }
@@ -128,58 +220,45 @@ readings_t_Ptr RedisStore::get_all_reading_records(const Sensor::Ptr sensor) {
 
     check_sensor_existence(sensor, true);
 
-    return run_hget_readings(sensor);
+    return run_zrangebyscore(sensor, std::numeric_limits<timestamp_t>::min(), std::numeric_limits<timestamp_t>::max());
 }
 
 readings_t_Ptr RedisStore::get_timeframe_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
 
-    //TODO: make this method more efficient
     check_sensor_existence(sensor, true);
 
-    readings_t_Ptr selected(new readings_t());
-    readings_t_Ptr readings = run_hget_readings(sensor);
-
-    for (readings_cit_t reading = readings->begin(); reading != readings->end(); ++reading) {
-
-        if ((*reading).first >= begin && (*reading).first <= end) {
-
-            selected->insert(*reading);
-        }
-    }
-    return selected;
+    return run_zrangebyscore(sensor, begin, end);
 }
 
 unsigned long int RedisStore::get_num_readings_value(const Sensor::Ptr sensor) {
 
-    //TODO: make this method more efficient
-    return get_all_readings(sensor)->size();
+    check_sensor_existence(sensor, true);
+
+    return run_zcard(sensor);
 }
 
 reading_t RedisStore::get_last_reading_record(const Sensor::Ptr sensor) {
 
-    //TODO: make this method more efficient
-    readings_t_Ptr readings = get_all_readings(sensor);
+    check_sensor_existence(sensor, true);
+
+    const readings_t_Ptr readings = run_zrevrange(sensor, 0, 0);
+    return readings->empty() ? reading_t(0, 0) : reading_t(*readings->begin());
+}
 
-    if (readings->size() > 0) {
-        return *(readings->end());
+readings_t_Ptr RedisStore::get_aggregated_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+        const timestamp_t bucket, const aggregate_t function) {
 
-    } else {
-        return std::pair<timestamp_t, double>(0, 0);
-    }
+    check_sensor_existence(sensor, true);
+
+    return run_evalsha_aggregation(sensor, begin, end, bucket, function);
 }
 
 reading_t RedisStore::get_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp) {
 
     check_sensor_existence(sensor, true);
 
-    std::pair<timestamp_t, double> reading = std::pair<timestamp_t, double>(0, 0);
-    const std::string value = run_hget(compose_readings_key(sensor), std::to_string(timestamp));
-
-    if (value.length() > 0) {
-        reading.first = timestamp;
-        reading.second = atof(value.c_str());
-    }
-    return reading;
+    const readings_t_Ptr readings = run_zrangebyscore(sensor, timestamp, timestamp);
+    return readings->empty() ? reading_t(0, 0) : reading_t(*readings->begin());
 }
 
 void RedisStore::add_single_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const bool ignore_errors) {
@@ -187,32 +266,50 @@ void RedisStore::add_single_reading_record(const Sensor::Ptr sensor, const times
     check_sensor_existence(sensor, true);
 
     try {
-        run_hmset_reading(sensor, timestamp, value);
+        run_zadd_readings(sensor, ReadingsSpan(&timestamp, &value, 1));
 
     } catch (std::exception const& e) {
         handle_reading_insertion_error(ignore_errors, timestamp, value);
     }
 }
 
-void RedisStore::add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+void RedisStore::add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
 
     check_sensor_existence(sensor, true);
 
     try {
-        run_hmset_readings(sensor, readings);
+        run_zadd_readings(sensor, readings);
 
     } catch (std::exception const& e) {
         handle_reading_insertion_error(ignore_errors, sensor);
     }
 }
 
-void RedisStore::update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+void RedisStore::add_batch_reading_records(const sensors_readings_spans_t& readings, const bool ignore_errors) {
+
+    for (sensors_readings_spans_cit_t it = readings.begin(); it != readings.end(); ++it) {
+        check_sensor_existence((*it).first, true);
+    }
+
+    try {
+        run_zadd_readings(readings);
+
+    } catch (std::exception const& e) {
+        handle_reading_insertion_error(ignore_errors, readings, e.what());
+    }
+}
+
+void RedisStore::update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
 
     add_bulk_reading_records(sensor, readings, ignore_errors);
 }
 
 const std::string RedisStore::check_sensor_existence(const Sensor::Ptr sensor, const bool should_exist) {
 
+    if (_legacy_layout) {
+        throw StoreException("The readings of this Redis store are kept in the hashes of an older version, the store must be upgraded.");
+    }
+
     //sensor exists
     if (_sensors_buffer.count(sensor->uuid()) > 0) {
 
@@ -228,16 +325,62 @@ const std::string RedisStore::check_sensor_existence(const Sensor::Ptr sensor, c
     return compose_sensor_key(sensor);
 }
 
-void RedisStore::run_del_readings(const Sensor::Ptr sensor) {
+void RedisStore::load_layout() {
+
+    //New stores use sorted sets, stores with sensors but without a layout are older ones
+    if (run_get(LAYOUT_KEY) == SORTED_SET_LAYOUT) {
+        _legacy_layout = false;
+
+    } else if (run_smembers(SENSORS_KEY).empty()) {
+        run_set(LAYOUT_KEY, SORTED_SET_LAYOUT);
+        _legacy_layout = false;
+
+    } else {
+        _legacy_layout = true;
+    }
+}
+
+void RedisStore::upgrade_readings(const std::string& sensor_key) {
+
+    const std::string key = sensor_key + READINGS_KEY;
+    const std::string upgrade_key = key + ":upgrade";
+    const reply fields = _connection->run(command(HGETALL)(key));
+
+    //The readings of this sensor were already moved by an interrupted upgrade
+    if (fields.type() == reply::type_t::ERROR || fields.elements().empty()) {
+        return;
+    }
+
+    _connection->run(command(DEL)(upgrade_key));
+    const std::vector<reply>& elements = fields.elements();
+    unsigned int num_commands = 0;
+
+    //The sorted set is built under another key, and then replaces the hash at once
+    for (size_t i = 0; i + 1 < elements.size(); i += 2000) {
 
-    command del = command(DEL);
-    del << compose_readings_key(sensor);
-    _connection->run(del);
+        command zadd = command(ZADD);
+        zadd << upgrade_key;
+
+        for (size_t j = i; j + 1 < elements.size() && j < i + 2000; j += 2) {
+
+            const timestamp_t timestamp = atol(elements.at(j).str().c_str());
+            zadd << timestamp << compose_member(timestamp, atof(elements.at(j + 1).str().c_str()));
+        }
+        _connection->append(zadd);
+        num_commands++;
+    }
+    check_replies(_connection->get_replies(num_commands));
+
+    const reply renamed = _connection->run(command(RENAME)(upgrade_key)(key));
+
+    if (renamed.type() == reply::type_t::ERROR) {
+        throw StoreException(renamed.str());
+    }
 }
 
-void RedisStore::run_hmset_sensor(const std::string& key, const Sensor::Ptr sensor) {
+void RedisStore::append_hmset_sensor(const std::string& key, const Sensor::Ptr sensor) {
 
-    _connection->run(command(HMSET)(key)
+    _connection->append(command(HMSET)(key)
             ("uuid") (sensor->uuid_string())
             ("external_id") (sensor->external_id())
             ("name") (sensor->name())
@@ -247,12 +390,17 @@ void RedisStore::run_hmset_sensor(const std::string& key, const Sensor::Ptr sens
             );
 }
 
-const Sensor::Ptr RedisStore::run_hmget_sensor(const std::string& key) {
+void RedisStore::append_hmget_sensor(const std::string& key) {
 
-    const std::vector<reply> replies = _connection->run(command(HMGET)(key)
+    _connection->append(command(HMGET)(key)
             ("uuid") ("external_id")
             ("name") ("description")
-            ("unit") ("timezone")).elements();
+            ("unit") ("timezone"));
+}
+
+const Sensor::Ptr RedisStore::create_sensor(const reply& fields) {
+
+    const std::vector<reply>& replies = fields.elements();
 
     return sensor_factory->createSensor(
             replies.at(0).str(),
@@ -264,84 +412,112 @@ const Sensor::Ptr RedisStore::run_hmget_sensor(const std::string& key) {
             );
 }
 
-void RedisStore::run_hmset_readings(const Sensor::Ptr sensor, const readings_t& readings) {
+void RedisStore::run_zadd_readings(const Sensor::Ptr sensor, const ReadingsSpan& readings) {
 
-    command hmset = command(HMSET);
-    hmset << compose_readings_key(sensor);
+    const unsigned int num_commands = append_zadd_readings(compose_readings_key(sensor), readings);
+    check_replies(_connection->get_replies(num_commands));
+}
 
-    for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
+void RedisStore::run_zadd_readings(const sensors_readings_spans_t& readings) {
 
-        hmset << (*it).first;
-        hmset << (*it).second;
+    //One pipeline for all sensors: the commands are sent before any reply is read
+    unsigned int num_commands = 0;
+
+    for (sensors_readings_spans_cit_t it = readings.begin(); it != readings.end(); ++it) {
+        num_commands += append_zadd_readings(compose_readings_key((*it).first), (*it).second);
     }
-    _connection->run(hmset);
+    check_replies(_connection->get_replies(num_commands));
 }
 
-void RedisStore::run_hmset_reading(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value) {
+const unsigned int RedisStore::append_zadd_readings(const std::string& key, const ReadingsSpan& readings) {
+
+    if (readings.empty()) {
+        return 0;
+    }
+
+    //Members contain the value, so the member of a replaced reading is removed by its score first
+    for (size_t i = 0; i < readings.size(); i++) {
+        _connection->append(command(ZREMRANGEBYSCORE)(key) (readings.timestamp(i)) (readings.timestamp(i)));
+    }
+
+    command zadd = command(ZADD);
+    zadd << key;
 
-    command hmset = command(HMSET);
-    hmset << compose_readings_key(sensor) << timestamp << value;
-    _connection->run(hmset);
+    for (size_t i = 0; i < readings.size(); i++) {
+        zadd << readings.timestamp(i);
+        zadd << compose_member(readings.timestamp(i), readings.value(i));
+    }
+    _connection->append(zadd);
+
+    return readings.size() + 1;
 }
 
-readings_t_Ptr RedisStore::run_hget_readings(const Sensor::Ptr sensor) {
+readings_t_Ptr RedisStore::run_zrangebyscore(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
 
-    const std::vector<reply> replies = _connection->run(
-            command(HGETALL)
+    return parse_readings(_connection->run(command(ZRANGEBYSCORE)
             (compose_readings_key(sensor))
-            ).elements();
+            (compose_score(begin))
+            (compose_score(end))).elements());
+}
 
-    readings_t_Ptr readings = readings_t_Ptr(new readings_t());
-    timestamp_t timestamp;
-    double value;
+readings_t_Ptr RedisStore::run_zrevrange(const Sensor::Ptr sensor, const long int start, const long int stop) {
 
-    std::vector<reply>::const_iterator it = replies.begin();
-    while (it != replies.end()) {
+    return parse_readings(_connection->run(command(ZREVRANGE)(compose_readings_key(sensor)) (start) (stop)).elements());
+}
 
-        timestamp = atol((*it++).str().c_str());
-        value = atof((*it++).str().c_str());
+const unsigned long int RedisStore::run_zcard(const Sensor::Ptr sensor) {
 
-        readings->insert(
-                std::pair<timestamp_t, double>(
-                timestamp,
-                value
-                ));
-    }
-    return readings;
+    return _connection->run(command(ZCARD)(compose_readings_key(sensor))).integer();
 }
 
-void RedisStore::run_hdel_sensor(const std::string& key) {
+void RedisStore::append_hdel_sensor(const std::string& key) {
 
-    _connection->run(command(HDEL)(key)
+    _connection->append(command(HDEL)(key)
             ("uuid") ("external_id")
             ("name") ("description")
             ("unit") ("timezone")
             );
 }
 
-const std::vector<reply> RedisStore::run_hkeys(const std::string& key) {
+void RedisStore::check_replies(const std::vector<reply>& replies) {
 
-    return _connection->run(command(HKEYS)(key)).elements();
+    for (std::vector<reply>::const_iterator it = replies.begin(); it != replies.end(); ++it) {
+
+        if ((*it).type() == reply::type_t::ERROR) {
+            throw StoreException((*it).str());
+        }
+    }
 }
 
-const std::string RedisStore::run_hget(const std::string& key, const std::string& field) {
+readings_t_Ptr RedisStore::parse_readings(const std::vector<reply>& members) {
 
-    return _connection->run(command(HGET)(key) (field)).str();
-}
+    readings_t_Ptr readings = readings_t_Ptr(new readings_t());
 
-void RedisStore::run_sadd(const std::string& key, const std::string& value) {
+    for (std::vector<reply>::const_iterator it = members.begin(); it != members.end(); ++it) {
 
-    _connection->run(command(SADD)(key) (value));
+        const std::string& member = (*it).str();
+        const size_t separator = member.find(':');
+
+        if (separator != std::string::npos) {
+            readings->insert(readings->end(), reading_t(
+                    atol(member.substr(0, separator).c_str()),
+                    atof(member.substr(separator + 1).c_str())
+                    ));
+        }
+    }
+    return readings;
 }
 
-const std::vector<reply> RedisStore::run_smembers(const std::string& key) {
+const std::string RedisStore::compose_member(const timestamp_t timestamp, const double value) {
 
-    return _connection->run(command(SMEMBERS)(key)).elements();
+    std::ostringstream oss;
+    oss << timestamp << ":" << std::setprecision(17) << value;
+    return oss.str();
 }
 
-void RedisStore::run_srem(const std::string& key, const std::string& value) {
+const std::vector<reply> RedisStore::run_smembers(const std::string& key) {
 
-    _connection->run(command(SREM)(key) (value));
+    return _connection->run(command(SMEMBERS)(key)).elements();
 }
 
 void RedisStore::run_select(const unsigned int index) {
@@ -357,6 +533,97 @@ void RedisStore::run_flushdb() {
     _connection->run(command(FLUSHDB));
 }
 
+readings_t_Ptr RedisStore::run_evalsha_aggregation(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+        const timestamp_t bucket, const aggregate_t function) {
+
+    if (_aggregation_sha.empty()) {
+        _aggregation_sha = run_script_load(AGGREGATION_SCRIPT);
+    }
+
+    command evalsha = command(EVALSHA)(_aggregation_sha)(1)
+            (compose_readings_key(sensor))
+            (compose_score(begin))
+            (compose_score(end))
+            (bucket)
+            (compose_aggregate(function));
+
+    reply result = _connection->run(evalsha);
+
+    //The script cache of the server is empty after a restart or SCRIPT FLUSH, the digest stays the same
+    if (result.type() == reply::type_t::ERROR && result.str().compare(0, 8, "NOSCRIPT") == 0) {
+        run_script_load(AGGREGATION_SCRIPT);
+        result = _connection->run(evalsha);
+    }
+
+    if (result.type() == reply::type_t::ERROR) {
+        throw StoreException(result.str());
+    }
+
+    readings_t_Ptr aggregated = readings_t_Ptr(new readings_t());
+    const std::vector<reply>& elements = result.elements();
+
+    for (size_t i = 0; i + 1 < elements.size(); i += 2) {
+        aggregated->insert(aggregated->end(), reading_t(
+                atol(elements[i].str().c_str()),
+                atof(elements[i + 1].str().c_str())
+                ));
+    }
+    return aggregated;
+}
+
+const std::string RedisStore::run_script_load(const std::string& script) {
+
+    const reply result = _connection->run(command(SCRIPT)("LOAD")(script));
+
+    if (result.type() == reply::type_t::ERROR) {
+        throw StoreException(result.str());
+    }
+    return result.str();
+}
+
+const std::string RedisStore::run_get(const std::string& key) {
+
+    return _connection->run(command(GET)(key)).str();
+}
+
+void RedisStore::run_set(const std::string& key, const std::string& value) {
+
+    _connection->run(command(SET)(key) (value));
+}
+
+const std::string RedisStore::compose_aggregate(const aggregate_t function) {
+
+    switch (function) {
+        case AGGREGATE_AVG:
+            return "avg";
+        case AGGREGATE_MIN:
+            return "min";
+        case AGGREGATE_MAX:
+            return "max";
+        case AGGREGATE_SUM:
+            return "sum";
+        case AGGREGATE_COUNT:
+            return "count";
+        case AGGREGATE_FIRST:
+            return "first";
+        default:
+            return "last";
+    }
+}
+
+const std::string RedisStore::compose_score(const timestamp_t timestamp) {
+
+    if (timestamp == std::numeric_limits<timestamp_t>::min()) {
+        return "-inf";
+
+    } else if (timestamp == std::numeric_limits<timestamp_t>::max()) {
+        return "+inf";
+    }
+    std::ostringstream score;
+    score << timestamp;
+    return score.str();
+}
+
 const std::string RedisStore::compose_sensor_key(const Sensor::Ptr sensor) {
 
     std::ostringstream oss;
@@ -28,11 +28,19 @@
 #include <redis3m/redis3m.hpp>
 #include <libklio/store.hpp>
 #include <libklio/redis/redis-transaction.hpp>
+#include <libklio/redis/redis-connection-pool.hpp>
 
 using namespace redis3m;
 
 namespace klio {
 
+    /**
+     * The readings of each sensor are kept in a sorted set, scored by
+     * timestamp, so that time ranges, counts and the last reading are
+     * answered by Redis. Members are the timestamp and the value,
+     * separated by a colon. Stores of older versions, which kept the
+     * readings in hashes, must be migrated with upgrade().
+     */
     class RedisStore : public Store {
     public:
         typedef boost::shared_ptr<RedisStore> Ptr;
@@ -46,7 +54,21 @@ namespace klio {
         Store(auto_commit, auto_flush, flush_timeout, 10, 10000),
         _host(host),
         _port(port),
-        _db(db) {
+        _db(db),
+        _legacy_layout(false) {
+        };
+
+        //The store borrows a connection of the pool while it is open
+        RedisStore(const RedisConnectionPool::Ptr pool,
+                const bool auto_commit,
+                const bool auto_flush,
+                const timestamp_t flush_timeout) :
+        Store(auto_commit, auto_flush, flush_timeout, 10, 10000),
+        _host(pool->host()),
+        _port(pool->port()),
+        _db(pool->db()),
+        _pool(pool),
+        _legacy_layout(false) {
         };
 
         virtual ~RedisStore() {
@@ -72,6 +94,9 @@ namespace klio {
         void dispose();
         const std::string str();
 
+        //Moves the readings of all sensors from hashes to sorted sets
+        void upgrade();
+
         static const std::string DEFAULT_REDIS_HOST;
         static const unsigned int DEFAULT_REDIS_PORT;
         static const unsigned int DEFAULT_REDIS_DB;
@@ -84,8 +109,9 @@ namespace klio {
         void remove_sensor_record(const Sensor::Ptr sensor);
         void update_sensor_record(const Sensor::Ptr sensor);
         void add_single_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const bool ignore_errors);
-        void add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors);
-        void update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors);
+        void add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
+        void update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
+        void add_batch_reading_records(const sensors_readings_spans_t& readings, const bool ignore_errors);
 
         std::vector<Sensor::Ptr> get_sensor_records();
         readings_t_Ptr get_all_reading_records(const Sensor::Ptr sensor);
@@ -94,6 +120,10 @@ namespace klio {
         reading_t get_last_reading_record(const Sensor::Ptr sensor);
         reading_t get_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp);
 
+        //The readings are aggregated on the server by a cached Lua script
+        readings_t_Ptr get_aggregated_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+                const timestamp_t bucket, const aggregate_t function);
+
     private:
         RedisStore(const RedisStore& original);
         RedisStore& operator =(const RedisStore& rhs);
@@ -101,24 +131,36 @@ namespace klio {
         RedisTransaction::Ptr create_transaction_handler();
 
         const std::string check_sensor_existence(const Sensor::Ptr sensor, const bool should_exist);
+        void load_layout();
+        void upgrade_readings(const std::string& sensor_key);
+
+
+        void append_hmset_sensor(const std::string& key, const Sensor::Ptr sensor);
+        void append_hmget_sensor(const std::string& key);
+        const Sensor::Ptr create_sensor(const reply& fields);
+        void run_zadd_readings(const Sensor::Ptr sensor, const ReadingsSpan& readings);
+        void run_zadd_readings(const sensors_readings_spans_t& readings);
+        const unsigned int append_zadd_readings(const std::string& key, const ReadingsSpan& readings);
+        readings_t_Ptr run_zrangebyscore(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end);
+        readings_t_Ptr run_zrevrange(const Sensor::Ptr sensor, const long int start, const long int stop);
+        const unsigned long int run_zcard(const Sensor::Ptr sensor);
+        readings_t_Ptr run_evalsha_aggregation(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+                const timestamp_t bucket, const aggregate_t function);
+        const std::string run_script_load(const std::string& script);
+        void append_hdel_sensor(const std::string& key);
+
+        void check_replies(const std::vector<reply>& replies);
+        readings_t_Ptr parse_readings(const std::vector<reply>& members);
+        const std::string compose_aggregate(const aggregate_t function);
+        const std::string compose_score(const timestamp_t timestamp);
+        const std::string compose_member(const timestamp_t timestamp, const double value);
 
-        void run_del_readings(const Sensor::Ptr sensor);
-
-        void run_hmset_sensor(const std::string& key, const Sensor::Ptr sensor);
-        const Sensor::Ptr run_hmget_sensor(const std::string& key);
-        void run_hmset_reading(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value);
-        void run_hmset_readings(const Sensor::Ptr sensor, const readings_t& readings);
-        readings_t_Ptr run_hget_readings(const Sensor::Ptr sensor);
-        void run_hdel_sensor(const std::string& key);
-        const std::vector<reply> run_hkeys(const std::string& key);
-        const std::string run_hget(const std::string& key, const std::string& field);
-
-        void run_sadd(const std::string& key, const std::string& value);
         const std::vector<reply> run_smembers(const std::string& key);
-        void run_srem(const std::string& key, const std::string& value);
 
         void run_select(const unsigned int index);
         void run_flushdb();
+        const std::string run_get(const std::string& key);
+        void run_set(const std::string& key, const std::string& value);
 
         const std::string compose_sensor_key(const Sensor::Ptr sensor);
         const std::string compose_readings_key(const Sensor::Ptr sensor);
@@ -127,11 +169,16 @@ namespace klio {
         unsigned int _port;
         unsigned int _db;
         redis3m::connection::ptr_t _connection;
+        RedisConnectionPool::Ptr _pool;
         RedisTransaction::Ptr _transaction;
+        bool _legacy_layout;
+        std::string _aggregation_sha;
 
         static const std::string SENSORS_KEY;
         static const std::string SENSOR_KEY;
         static const std::string READINGS_KEY;
+        static const std::string LAYOUT_KEY;
+        static const std::string SORTED_SET_LAYOUT;
 
         static const std::string SADD;
         static const std::string SMEMBERS;
@@ -140,11 +187,22 @@ namespace klio {
         static const std::string HMSET;
         static const std::string HMGET;
         static const std::string HGETALL;
-        static const std::string HGET;
         static const std::string HDEL;
-        static const std::string HKEYS;
+
+        static const std::string ZADD;
+        static const std::string ZRANGEBYSCORE;
+        static const std::string ZREMRANGEBYSCORE;
+        static const std::string ZREVRANGE;
+        static const std::string ZCARD;
+
+        static const std::string EVALSHA;
+        static const std::string SCRIPT;
+        static const std::string AGGREGATION_SCRIPT;
 
         static const std::string DEL;
+        static const std::string GET;
+        static const std::string SET;
+        static const std::string RENAME;
         static const std::string SELECT;
         static const std::string FLUSHDB;
     };
@@ -0,0 +1,102 @@
+#include <libklio/config.h>
+
+#ifdef ENABLE_ROCKSDB
+
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <stdint.h>
+#include <libklio/rocksdb/rocksdb-codec.hpp>
+
+
+using namespace klio;
+
+static const uint64_t SIGN_BIT = 0x8000000000000000ULL;
+
+const std::string RocksDBCodec::encode_sensor(const Sensor::uuid_t& uuid) {
+
+    return std::string(uuid.begin(), uuid.end());
+}
+
+const Sensor::uuid_t RocksDBCodec::decode_sensor(const rocksdb::Slice& key) {
+
+    Sensor::uuid_t uuid;
+    std::memcpy(uuid.data, key.data(), SENSOR_SIZE);
+    return uuid;
+}
+
+const std::string RocksDBCodec::encode_reading(const Sensor::uuid_t& uuid, const timestamp_t timestamp) {
+
+    return encode_sensor(uuid) + encode_timestamp(timestamp);
+}
+
+const std::string RocksDBCodec::encode_timestamp(const timestamp_t timestamp) {
+
+    const uint64_t bits = static_cast<uint64_t> (timestamp) ^ SIGN_BIT;
+    char key[TIMESTAMP_SIZE];
+
+    for (size_t i = 0; i < TIMESTAMP_SIZE; i++) {
+        key[i] = static_cast<char> ((bits >> (8 * (TIMESTAMP_SIZE - 1 - i))) & 0xff);
+    }
+    return std::string(key, TIMESTAMP_SIZE);
+}
+
+const timestamp_t RocksDBCodec::decode_timestamp(const rocksdb::Slice& key) {
+
+    //The timestamp is at the end of the key, after the sensor if there is one
+    const size_t offset = key.size() > TIMESTAMP_SIZE ? key.size() - TIMESTAMP_SIZE : 0;
+    uint64_t bits = 0;
+
+    for (size_t i = offset; i < key.size(); i++) {
+        bits = (bits << 8) | static_cast<unsigned char> (key[i]);
+    }
+    return static_cast<timestamp_t> (bits ^ SIGN_BIT);
+}
+
+const std::string RocksDBCodec::encode_value(const double value) {
+
+    return std::string(reinterpret_cast<const char*> (&value), VALUE_SIZE);
+}
+
+const double RocksDBCodec::decode_value(const rocksdb::Slice& value) {
+
+    double decoded = 0;
+
+    if (value.size() == VALUE_SIZE) {
+        std::memcpy(&decoded, value.data(), VALUE_SIZE);
+    }
+    return decoded;
+}
+
+const std::string RocksDBCodec::encode_summary(const SensorSummary& summary) {
+
+    std::ostringstream oss;
+    oss << std::setprecision(17) <<
+            summary.num_readings() << " " <<
+            summary.first_timestamp() << " " <<
+            summary.last_timestamp() << " " <<
+            summary.last_value() << " " <<
+            summary.min_value() << " " <<
+            summary.max_value() << " " <<
+            summary.sum();
+
+    return oss.str();
+}
+
+const bool RocksDBCodec::decode_summary(const rocksdb::Slice& value, SensorSummary& summary) {
+
+    unsigned long int num_readings;
+    timestamp_t first_timestamp, last_timestamp;
+    double last_value, min_value, max_value, sum;
+
+    std::istringstream iss(value.ToString());
+    iss >> num_readings >> first_timestamp >> last_timestamp >> last_value >> min_value >> max_value >> sum;
+
+    if (iss.fail()) {
+        return false;
+    }
+    summary = SensorSummary(num_readings, first_timestamp, last_timestamp, last_value, min_value, max_value, sum);
+    return true;
+}
+
+#endif /* ENABLE_ROCKSDB */
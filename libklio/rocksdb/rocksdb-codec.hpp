@@ -0,0 +1,68 @@
+/**
+ * This file is part of libklio.
+ *
+ * (c) Fraunhofer ITWM
+ *
+ * libklio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libklio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libklio. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKLIO_ROCKSDB_CODEC_HPP
+#define LIBKLIO_ROCKSDB_CODEC_HPP 1
+
+#include <libklio/config.h>
+
+#ifdef ENABLE_ROCKSDB
+
+#include <string>
+#include <rocksdb/slice.h>
+#include <libklio/types.hpp>
+#include <libklio/sensor-summary.hpp>
+
+
+namespace klio {
+
+    /**
+     * Binary encoding of the readings stored in RocksDB. Keys start with
+     * the 16 bytes of the sensor uuid. Timestamps follow as fixed-width
+     * big-endian integers with the sign bit flipped, so that the bytewise
+     * order of the keys of a sensor is the order of the timestamps.
+     * Values are the eight bytes of the double.
+     */
+    class RocksDBCodec {
+    public:
+        static const size_t SENSOR_SIZE = 16;
+        static const size_t TIMESTAMP_SIZE = 8;
+        static const size_t VALUE_SIZE = sizeof (double);
+
+        static const std::string encode_sensor(const Sensor::uuid_t& uuid);
+        static const Sensor::uuid_t decode_sensor(const rocksdb::Slice& key);
+        static const std::string encode_reading(const Sensor::uuid_t& uuid, const timestamp_t timestamp);
+
+        static const std::string encode_timestamp(const timestamp_t timestamp);
+        static const timestamp_t decode_timestamp(const rocksdb::Slice& key);
+        static const std::string encode_value(const double value);
+        static const double decode_value(const rocksdb::Slice& value);
+
+        //Summaries and rollups are stored as decimal strings, with all digits of the doubles
+        static const std::string encode_summary(const SensorSummary& summary);
+        static const bool decode_summary(const rocksdb::Slice& value, SensorSummary& summary);
+
+    private:
+        RocksDBCodec();
+    };
+};
+
+#endif /* ENABLE_ROCKSDB */
+
+#endif /* LIBKLIO_ROCKSDB_CODEC_HPP */
@@ -0,0 +1,26 @@
+#include <libklio/config.h>
+
+#ifdef ENABLE_ROCKSDB
+
+#include <libklio/rocksdb/rocksdb-readings-cursor.hpp>
+
+
+using namespace klio;
+
+bool RocksDBReadingsCursor::next(reading_t& reading) {
+
+    if (_iterator->Valid() && _iterator->key().starts_with(_sensor)) {
+
+        reading.first = _time_converter->convert_from_epoch(RocksDBCodec::decode_timestamp(_iterator->key()));
+        reading.second = RocksDBCodec::decode_value(_iterator->value());
+        _iterator->Next();
+        return true;
+    }
+
+    if (!_iterator->status().ok()) {
+        throw StoreException(_iterator->status().ToString());
+    }
+    return false;
+}
+
+#endif /* ENABLE_ROCKSDB */
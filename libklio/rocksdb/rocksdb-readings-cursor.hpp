@@ -0,0 +1,85 @@
+/**
+ * This file is part of libklio.
+ *
+ * (c) Fraunhofer ITWM
+ *
+ * libklio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libklio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libklio. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKLIO_ROCKSDB_READINGS_CURSOR_HPP
+#define LIBKLIO_ROCKSDB_READINGS_CURSOR_HPP 1
+
+#include <libklio/config.h>
+
+#ifdef ENABLE_ROCKSDB
+
+#include <limits>
+#include <rocksdb/db.h>
+#include <libklio/readings-cursor.hpp>
+#include <libklio/rocksdb/rocksdb-codec.hpp>
+#include <libklio/time.hpp>
+
+
+namespace klio {
+
+    /**
+     * Walks the readings of a sensor from begin to end. The keys of a
+     * sensor are ordered by timestamp, so the iterator seeks to begin and
+     * stops at the upper bound or at the end of the sensor prefix. The
+     * cursor must be destroyed before the database is closed.
+     */
+    class RocksDBReadingsCursor : public ReadingsCursor {
+    public:
+        typedef boost::shared_ptr<RocksDBReadingsCursor> Ptr;
+
+        RocksDBReadingsCursor(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* family, const std::string& sensor,
+                const TimeConverter::Ptr time_converter, const timestamp_t begin, const timestamp_t end) :
+        ReadingsCursor(),
+        _time_converter(time_converter),
+        _sensor(sensor) {
+
+            rocksdb::ReadOptions options;
+            options.prefix_same_as_start = true;
+
+            //The upper bound is exclusive, and it must outlive the iterator
+            if (end < std::numeric_limits<timestamp_t>::max()) {
+                _upper_bound = _sensor + RocksDBCodec::encode_timestamp(end + 1);
+                _upper_bound_slice = rocksdb::Slice(_upper_bound);
+                options.iterate_upper_bound = &_upper_bound_slice;
+            }
+            _iterator = db->NewIterator(options, family);
+            _iterator->Seek(_sensor + RocksDBCodec::encode_timestamp(begin));
+        };
+
+        virtual ~RocksDBReadingsCursor() {
+            delete _iterator;
+        };
+
+        bool next(reading_t& reading);
+
+    private:
+        RocksDBReadingsCursor(const RocksDBReadingsCursor& original);
+        RocksDBReadingsCursor& operator=(const RocksDBReadingsCursor& rhs);
+
+        TimeConverter::Ptr _time_converter;
+        std::string _sensor;
+        std::string _upper_bound;
+        rocksdb::Slice _upper_bound_slice;
+        rocksdb::Iterator* _iterator;
+    };
+};
+
+#endif /* ENABLE_ROCKSDB */
+
+#endif /* LIBKLIO_ROCKSDB_READINGS_CURSOR_HPP */
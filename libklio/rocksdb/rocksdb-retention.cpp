@@ -0,0 +1,158 @@
+#include <libklio/config.h>
+
+#ifdef ENABLE_ROCKSDB
+
+#include <limits>
+#include <libklio/time.hpp>
+#include <libklio/rocksdb/rocksdb-retention.hpp>
+
+
+using namespace klio;
+
+void RocksDBRetentionFilter::set_policy(const std::string& sensor, const timestamp_t time_to_live, const timestamp_t rollup_resolution) {
+
+    boost::mutex::scoped_lock lock(_mutex);
+    policy_t policy;
+    policy.time_to_live = time_to_live;
+    policy.rollup_resolution = rollup_resolution;
+    _policies[sensor] = policy;
+}
+
+void RocksDBRetentionFilter::remove_policy(const std::string& sensor) {
+
+    boost::mutex::scoped_lock lock(_mutex);
+    _policies.erase(sensor);
+}
+
+const bool RocksDBRetentionFilter::has_policy(const std::string& sensor) const {
+
+    boost::mutex::scoped_lock lock(_mutex);
+    return _policies.count(sensor) > 0;
+}
+
+const timestamp_t RocksDBRetentionFilter::get_cutoff(const std::string& sensor) const {
+
+    boost::mutex::scoped_lock lock(_mutex);
+    const std::map<std::string, policy_t>::const_iterator found = _policies.find(sensor);
+
+    if (found == _policies.end()) {
+        return std::numeric_limits<timestamp_t>::min();
+    }
+    TimeConverter tc;
+    return tc.get_timestamp() - found->second.time_to_live;
+}
+
+void RocksDBRetentionFilter::take_rollups(pending_rollups_t& rollups) {
+
+    boost::mutex::scoped_lock lock(_mutex);
+    rollups.swap(_rollups);
+    _rollups.clear();
+}
+
+void RocksDBRetentionFilter::take_expiring_sensors(std::set<std::string>& sensors) {
+
+    boost::mutex::scoped_lock lock(_mutex);
+    sensors.swap(_expired_sensors);
+    _expired_sensors.clear();
+
+    for (std::map<std::string, policy_t>::const_iterator it = _policies.begin(); it != _policies.end(); ++it) {
+        sensors.insert(it->first);
+    }
+}
+
+bool RocksDBRetentionFilter::Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& existing_value,
+        std::string* new_value, bool* value_changed) const {
+
+    if (key.size() != RocksDBCodec::SENSOR_SIZE + RocksDBCodec::TIMESTAMP_SIZE) {
+        return false;
+    }
+
+    const std::string sensor(key.data(), RocksDBCodec::SENSOR_SIZE);
+
+    boost::mutex::scoped_lock lock(_mutex);
+    const std::map<std::string, policy_t>::const_iterator found = _policies.find(sensor);
+
+    if (found == _policies.end()) {
+        return false;
+    }
+
+    TimeConverter tc;
+    const timestamp_t timestamp = RocksDBCodec::decode_timestamp(key);
+
+    if (timestamp >= tc.get_timestamp() - found->second.time_to_live) {
+        return false;
+    }
+    _expired_sensors.insert(sensor);
+    const timestamp_t resolution = found->second.rollup_resolution;
+
+    if (resolution > 0) {
+
+        //Intervals start at multiples of the resolution, also for timestamps before the epoch
+        timestamp_t interval = timestamp - timestamp % resolution;
+        if (timestamp % resolution < 0) {
+            interval -= resolution;
+        }
+        _rollups[sensor + RocksDBCodec::encode_timestamp(interval)].add(timestamp, RocksDBCodec::decode_value(existing_value));
+    }
+    return true;
+}
+
+bool RocksDBRollupMergeOperator::Merge(const rocksdb::Slice& key, const rocksdb::Slice* existing_value, const rocksdb::Slice& value,
+        std::string* new_value, rocksdb::Logger* logger) const {
+
+    SensorSummary rollup;
+    SensorSummary added;
+
+    if (!RocksDBCodec::decode_summary(value, added)) {
+        return false;
+    }
+
+    if (existing_value && !RocksDBCodec::decode_summary(*existing_value, rollup)) {
+        return false;
+    }
+    rollup.add(added);
+    *new_value = RocksDBCodec::encode_summary(rollup);
+    return true;
+}
+
+void RocksDBRetentionListener::set_family(rocksdb::ColumnFamilyHandle* family) {
+
+    boost::mutex::scoped_lock lock(_mutex);
+    _family = family;
+}
+
+void RocksDBRetentionListener::write_rollups(rocksdb::DB* db) {
+
+    boost::mutex::scoped_lock lock(_mutex);
+
+    if (!_family) {
+        return;
+    }
+
+    pending_rollups_t rollups;
+    _filter->take_rollups(rollups);
+
+    if (rollups.empty()) {
+        return;
+    }
+
+    rocksdb::WriteBatch batch;
+
+    for (pending_rollups_t::const_iterator it = rollups.begin(); it != rollups.end(); ++it) {
+        batch.Merge(_family, it->first, RocksDBCodec::encode_summary(it->second));
+    }
+
+    //The readings are already gone, so the rollups are written to the log even if the store is not synchronous
+    const rocksdb::Status status = db->Write(rocksdb::WriteOptions(), &batch);
+
+    if (!status.ok()) {
+        LOG("Rollups could not be written: " << status.ToString());
+    }
+}
+
+void RocksDBRetentionListener::OnCompactionCompleted(rocksdb::DB* db, const rocksdb::CompactionJobInfo& info) {
+
+    write_rollups(db);
+}
+
+#endif /* ENABLE_ROCKSDB */
@@ -0,0 +1,144 @@
+/**
+ * This file is part of libklio.
+ *
+ * (c) Fraunhofer ITWM
+ *
+ * libklio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libklio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libklio. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKLIO_ROCKSDB_RETENTION_HPP
+#define LIBKLIO_ROCKSDB_RETENTION_HPP 1
+
+#include <libklio/config.h>
+
+#ifdef ENABLE_ROCKSDB
+
+#include <map>
+#include <set>
+#include <vector>
+#include <memory>
+#include <boost/thread/mutex.hpp>
+#include <rocksdb/db.h>
+#include <rocksdb/compaction_filter.h>
+#include <rocksdb/merge_operator.h>
+#include <rocksdb/listener.h>
+#include <libklio/sensor-summary.hpp>
+#include <libklio/rocksdb/rocksdb-codec.hpp>
+
+
+namespace klio {
+
+    //Statistics of the expired readings of one rollup interval, by sensor prefix and interval start
+    typedef std::map<std::string, SensorSummary> pending_rollups_t;
+
+    /**
+     * Drops the readings of sensors with a retention policy once they are
+     * older than the policy's time to live. The filter runs on the
+     * compaction threads of RocksDB, so expired readings are removed
+     * without any foreground reads or writes. When the policy has a
+     * rollup resolution, the dropped readings are aggregated per interval
+     * until the RocksDBRetentionListener writes them to the rollups.
+     */
+    class RocksDBRetentionFilter : public rocksdb::CompactionFilter {
+    public:
+
+        RocksDBRetentionFilter() {
+        };
+
+        virtual ~RocksDBRetentionFilter() {
+        };
+
+        void set_policy(const std::string& sensor, const timestamp_t time_to_live, const timestamp_t rollup_resolution);
+        void remove_policy(const std::string& sensor);
+        const bool has_policy(const std::string& sensor) const;
+
+        //Epoch of the oldest reading of a sensor that has not expired
+        const timestamp_t get_cutoff(const std::string& sensor) const;
+
+        void take_rollups(pending_rollups_t& rollups);
+
+        //Sensors whose readings expire, and those whose readings were dropped by compactions since the last call
+        void take_expiring_sensors(std::set<std::string>& sensors);
+
+        bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& existing_value,
+                std::string* new_value, bool* value_changed) const;
+
+        const char* Name() const {
+            return "klio.RetentionFilter";
+        };
+
+    private:
+        RocksDBRetentionFilter(const RocksDBRetentionFilter& original);
+        RocksDBRetentionFilter& operator=(const RocksDBRetentionFilter& rhs);
+
+        typedef struct {
+            timestamp_t time_to_live;
+            timestamp_t rollup_resolution;
+        } policy_t;
+
+        mutable boost::mutex _mutex;
+        std::map<std::string, policy_t> _policies;
+        mutable pending_rollups_t _rollups;
+        mutable std::set<std::string> _expired_sensors;
+    };
+
+    /**
+     * Merges rollups of the same interval, which may be produced by
+     * several compactions.
+     */
+    class RocksDBRollupMergeOperator : public rocksdb::AssociativeMergeOperator {
+    public:
+
+        bool Merge(const rocksdb::Slice& key, const rocksdb::Slice* existing_value, const rocksdb::Slice& value,
+                std::string* new_value, rocksdb::Logger* logger) const;
+
+        const char* Name() const {
+            return "klio.RollupMergeOperator";
+        };
+    };
+
+    /**
+     * Writes the rollups collected by the retention filter after each
+     * compaction. Rollups of compactions that run while the database is
+     * being opened are kept until the family is known.
+     */
+    class RocksDBRetentionListener : public rocksdb::EventListener {
+    public:
+
+        RocksDBRetentionListener(const std::shared_ptr<RocksDBRetentionFilter>& filter) :
+        _filter(filter),
+        _family(NULL) {
+        };
+
+        virtual ~RocksDBRetentionListener() {
+        };
+
+        void set_family(rocksdb::ColumnFamilyHandle* family);
+        void write_rollups(rocksdb::DB* db);
+
+        void OnCompactionCompleted(rocksdb::DB* db, const rocksdb::CompactionJobInfo& info);
+
+    private:
+        RocksDBRetentionListener(const RocksDBRetentionListener& original);
+        RocksDBRetentionListener& operator=(const RocksDBRetentionListener& rhs);
+
+        std::shared_ptr<RocksDBRetentionFilter> _filter;
+        rocksdb::ColumnFamilyHandle* _family;
+        boost::mutex _mutex;
+    };
+};
+
+#endif /* ENABLE_ROCKSDB */
+
+#endif /* LIBKLIO_ROCKSDB_RETENTION_HPP */
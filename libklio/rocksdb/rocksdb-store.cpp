@@ -3,71 +3,75 @@
 #ifdef ENABLE_ROCKSDB
 
 #include <iostream>
+#include <algorithm>
 #include <sstream>
 #include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <iomanip>
+#include <boost/lexical_cast.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/slice_transform.h>
+#include <rocksdb/table.h>
+#include <rocksdb/convenience.h>
 #include <libklio/rocksdb/rocksdb-store.hpp>
 
 
 using namespace klio;
 
-void RocksDBStore::open() {
+const std::string RocksDBStore::BLOCK_CACHE_SIZE = "block_cache_size";
+const std::string RocksDBStore::WRITE_BUFFER_MANAGER_SIZE = "write_buffer_manager_size";
+const std::string RocksDBStore::BLOOM_FILTER_BITS_PER_KEY = "bloom_filter_bits_per_key";
 
-    if (bfs::exists(_path) && bfs::is_directory(_path) && _db_buffer.empty()) {
+static const std::string SENSORS_FAMILY = "sensors";
+static const std::string READINGS_FAMILY = "readings";
+static const std::string ROLLUPS_FAMILY = "rollups";
 
-        const std::vector<Sensor::uuid_t> uuids = get_sensor_uuids();
+//Properties of each sensor, keyed by the sensor prefix and the property name
+static const char* SENSOR_PROPERTIES[] = {"external_id", "name", "description", "unit", "timezone"};
+static const std::string SUMMARY_KEY = "summary";
+static const std::string RETENTION_KEY = "retention";
 
-        for (std::vector<Sensor::uuid_t>::const_iterator uuid = uuids.begin(); uuid != uuids.end(); uuid++) {
+//Smaller loads are written through the memtable, like regular flushes
+static const size_t MIN_INGESTED_READINGS = 10000;
 
-            const std::string uuid_str = boost::uuids::to_string(*uuid);
-            open_db(false, false, compose_sensor_properties_path(uuid_str));
-            open_db(true, false, compose_sensor_readings_path(uuid_str));
-        }
-    }
+//Sensor databases of older versions are migrated in batches of this size
+static const int MIGRATION_BATCH_SIZE = 10000;
+static const std::string MIGRATED_EXTENSION = ".migrated";
+
+void RocksDBStore::open() {
+
+    //The database is opened when it is first accessed
+    check_layout();
 }
 
 void RocksDBStore::close() {
 
-    for (std::map<std::string, rocksdb::DB*>::const_iterator it = _db_buffer.begin(); it != _db_buffer.end(); ++it) {
-        delete (*it).second;
-    }
+    stop_async_flush();
+    close_db();
     clear_buffers();
 }
 
 void RocksDBStore::check_integrity() {
 
-    const std::string path = compose_sensors_path();
+    check_layout();
 
-    if (!bfs::exists(path)) {
+    if (!bfs::exists(compose_db_path())) {
         std::ostringstream oss;
         oss << "The database path is incomplete.";
         throw StoreException(oss.str());
     }
-
-    const bfs::directory_iterator end;
-
-    for (bfs::directory_iterator it(path); it != end; it++) {
-
-        try {
-            boost::uuids::uuid uuid;
-            std::stringstream ss;
-            ss << it->path().filename().string();
-            ss >> uuid;
-
-        } catch (std::exception e) {
-            std::ostringstream oss;
-            oss << "The database path contains invalid subdirectories.";
-            throw StoreException(oss.str());
-        }
-    }
+    open_db(false);
 }
 
 void RocksDBStore::initialize() {
 
+    close_db();
     bfs::remove_all(_path);
     create_directory(_path.string());
-    create_directory(compose_sensors_path());
+    open_db(true);
 }
 
 void RocksDBStore::dispose() {
@@ -76,6 +80,18 @@ void RocksDBStore::dispose() {
     bfs::remove_all(_path);
 }
 
+void RocksDBStore::upgrade() {
+
+    LOG("Upgrading the layout of " << str());
+
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+
+    //An interrupted upgrade is resumed with the sensors that are still left
+    if (bfs::exists(compose_sensors_path())) {
+        migrate_sensor_databases();
+    }
+}
+
 const std::string RocksDBStore::str() {
 
     std::ostringstream oss;
@@ -83,290 +99,727 @@ const std::string RocksDBStore::str() {
     return oss.str();
 }
 
-void RocksDBStore::add_sensor_record(const Sensor::Ptr sensor) {
+void RocksDBStore::set_retention(const Sensor::Ptr sensor, const timestamp_t time_to_live, const timestamp_t rollup_resolution) {
 
-    const std::string uuid = sensor->uuid_string();
-    create_directory(compose_sensor_path(uuid));
-    create_directory(compose_sensor_properties_path(uuid));
-    create_directory(compose_sensor_readings_path(uuid));
-    put_sensor(true, sensor);
-}
+    LOG("Setting retention of sensor " << sensor->str() << " to " << time_to_live << " seconds");
 
-void RocksDBStore::remove_sensor_record(const Sensor::Ptr sensor) {
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    get_sensor(sensor->uuid());
+    open_db(false);
 
-    remove_db(compose_sensor_properties_path(sensor->uuid_string()));
-    remove_db(compose_sensor_readings_path(sensor->uuid_string()));
-    bfs::remove_all(compose_sensor_path(sensor->uuid_string()));
-}
+    const std::string key = RocksDBCodec::encode_sensor(sensor->uuid());
+    std::ostringstream oss;
+    oss << time_to_live << " " << rollup_resolution;
 
-void RocksDBStore::update_sensor_record(const Sensor::Ptr sensor) {
+    //The summary of a sensor with a retention policy is always computed from the retained readings
+    rocksdb::WriteBatch batch;
+    batch.Put(_sensors_family, key + RETENTION_KEY, oss.str());
+    batch.Delete(_sensors_family, key + SUMMARY_KEY);
+    write_batch(batch);
 
-    put_sensor(false, sensor);
+    _retention_filter->set_policy(key, time_to_live, rollup_resolution);
+    clear_sensor_summary(sensor->uuid());
 }
 
-std::vector<Sensor::Ptr> RocksDBStore::get_sensor_records() {
+void RocksDBStore::remove_retention(const Sensor::Ptr sensor) {
 
-    std::vector<Sensor::Ptr> sensors;
-    const bfs::directory_iterator end;
+    LOG("Removing retention of sensor " << sensor->str());
 
-    for (bfs::directory_iterator it(compose_sensors_path()); it != end; it++) {
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    get_sensor(sensor->uuid());
+    open_db(false);
 
-        boost::uuids::uuid uuid;
-        std::stringstream ss;
-        ss << it->path().filename().string();
-        ss >> uuid;
+    const std::string key = RocksDBCodec::encode_sensor(sensor->uuid());
+    _retention_filter->remove_policy(key);
 
-        const std::string uuid_str = boost::uuids::to_string(uuid);
-        const std::string db_path = compose_sensor_properties_path(uuid_str);
-        rocksdb::DB* db = _db_buffer[db_path];
+    rocksdb::WriteBatch batch;
+    batch.Delete(_sensors_family, key + RETENTION_KEY);
+    write_batch(batch);
+    clear_sensor_summary(sensor->uuid());
+}
 
-        if (db) {
-            const SensorFactory::Ptr factory(new SensorFactory());
-            Sensor::Ptr sensor = factory->createSensor(uuid,
-                    get_value(db, "external_id"),
-                    get_value(db, "name"),
-                    get_value(db, "description"),
-                    get_value(db, "unit"),
-                    get_value(db, "timezone"));
+rollups_t_Ptr RocksDBStore::get_rollups(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
 
-            sensors.push_back(sensor);
+    LOG("Retrieving rollups of sensor " << sensor->str() << " between " << begin << " and " << end);
 
-        } else {
-            std::ostringstream err;
-            err << "Sensor " << uuid_str << " could not be found.";
-            throw StoreException(err.str());
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    open_db(false);
+
+    const std::string key = RocksDBCodec::encode_sensor(sensor->uuid());
+    const std::string first = key + RocksDBCodec::encode_timestamp(time_converter->convert_to_epoch(begin));
+    const std::string last = key + RocksDBCodec::encode_timestamp(time_converter->convert_to_epoch(end));
+
+    rollups_t_Ptr rollups(new rollups_t());
+    rocksdb::ReadOptions options;
+    options.prefix_same_as_start = true;
+    rocksdb::Iterator* it = _db->NewIterator(options, _rollups_family);
+
+    for (it->Seek(first); it->Valid() && it->key().compare(last) <= 0; it->Next()) {
+
+        SensorSummary rollup;
+        if (RocksDBCodec::decode_summary(it->value(), rollup)) {
+            rollups->insert(rollups_t::value_type(time_converter->convert_from_epoch(RocksDBCodec::decode_timestamp(it->key())), rollup));
         }
     }
-    return sensors;
+
+    const rocksdb::Status status = it->status();
+    delete it;
+
+    if (!status.ok()) {
+        throw StoreException(status.ToString());
+    }
+    return rollups;
 }
 
-readings_t_Ptr RocksDBStore::get_all_reading_records(const Sensor::Ptr sensor) {
+void RocksDBStore::add_sensor_record(const Sensor::Ptr sensor) {
 
-    readings_t_Ptr readings(new readings_t());
+    open_db(false);
+    const std::string key = RocksDBCodec::encode_sensor(sensor->uuid());
+    std::string value;
 
-    rocksdb::DB* db = open_db(true, false,
-            compose_sensor_readings_path(sensor->uuid_string()));
+    if (get_value(_sensors_family, key + SENSOR_PROPERTIES[1], value)) {
+        std::ostringstream err;
+        err << "Sensor " << sensor->uuid_string() << " already exists.";
+        throw StoreException(err.str());
+    }
 
-    rocksdb::Iterator* it = db->NewIterator(rocksdb::ReadOptions());
+    rocksdb::WriteBatch batch;
+    put_sensor(batch, sensor);
+    batch.Put(_sensors_family, key + SUMMARY_KEY, RocksDBCodec::encode_summary(SensorSummary()));
+    write_batch(batch);
+}
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+void RocksDBStore::remove_sensor_record(const Sensor::Ptr sensor) {
+
+    open_db(false);
+    const std::string key = RocksDBCodec::encode_sensor(sensor->uuid());
+    rocksdb::WriteBatch batch;
 
-        std::string epoch = it->key().ToString();
-        std::string value = it->value().ToString();
+    rocksdb::Iterator* it = _db->NewIterator(rocksdb::ReadOptions(), _sensors_family);
 
-        readings->insert(
-                std::pair<timestamp_t, double>(
-                time_converter->convert_from_epoch(atol(epoch.c_str())),
-                atof(value.c_str())
-                ));
+    for (it->Seek(key); it->Valid() && it->key().starts_with(key); it->Next()) {
+        batch.Delete(_sensors_family, it->key());
     }
     delete it;
-    return readings;
+
+    //The upper end of a range deletion is exclusive
+    const timestamp_t last = std::numeric_limits<timestamp_t>::max();
+    batch.DeleteRange(_readings_family,
+            RocksDBCodec::encode_reading(sensor->uuid(), std::numeric_limits<timestamp_t>::min()),
+            RocksDBCodec::encode_reading(sensor->uuid(), last));
+    batch.Delete(_readings_family, RocksDBCodec::encode_reading(sensor->uuid(), last));
+
+    batch.DeleteRange(_rollups_family,
+            RocksDBCodec::encode_reading(sensor->uuid(), std::numeric_limits<timestamp_t>::min()),
+            RocksDBCodec::encode_reading(sensor->uuid(), last));
+    batch.Delete(_rollups_family, RocksDBCodec::encode_reading(sensor->uuid(), last));
+
+    write_batch(batch);
+    _retention_filter->remove_policy(key);
 }
 
-readings_t_Ptr RocksDBStore::get_timeframe_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
+void RocksDBStore::update_sensor_record(const Sensor::Ptr sensor) {
 
-    readings_t_Ptr readings(new readings_t());
+    open_db(false);
+    rocksdb::WriteBatch batch;
+    put_sensor(batch, sensor);
+    write_batch(batch);
+}
 
-    rocksdb::DB* db = open_db(true, false,
-            compose_sensor_readings_path(sensor->uuid_string()));
+std::vector<Sensor::Ptr> RocksDBStore::get_sensor_records() {
 
-    rocksdb::Iterator* it = db->NewIterator(rocksdb::ReadOptions());
+    open_db(false);
+    std::vector<Sensor::Ptr> sensors;
+    std::map<std::string, std::string> properties;
+    std::string current;
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    //The properties of each sensor are adjacent, since their keys share the sensor prefix
+    rocksdb::Iterator* it = _db->NewIterator(rocksdb::ReadOptions(), _sensors_family);
 
-        const char* epoch = it->key().ToString().c_str();
-        const char* value = it->value().ToString().c_str();
-        const long timestamp = time_converter->convert_from_epoch(atol(epoch));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
 
-        if (timestamp >= begin && timestamp <= end) {
+        const std::string key = it->key().ToString();
+        const std::string sensor = key.substr(0, RocksDBCodec::SENSOR_SIZE);
 
-            readings->insert(
-                    std::pair<timestamp_t, double>(
-                    timestamp,
-                    atof(value)
-                    ));
+        if (sensor != current && !current.empty()) {
+            sensors.push_back(create_sensor(current, properties));
+            properties.clear();
         }
+        current = sensor;
+        properties[key.substr(RocksDBCodec::SENSOR_SIZE)] = it->value().ToString();
     }
+
+    const rocksdb::Status status = it->status();
     delete it;
+
+    if (!status.ok()) {
+        throw StoreException(status.ToString());
+    }
+
+    if (!current.empty()) {
+        sensors.push_back(create_sensor(current, properties));
+    }
+    return sensors;
+}
+
+readings_t_Ptr RocksDBStore::get_all_reading_records(const Sensor::Ptr sensor) {
+
+    return get_timeframe_reading_records(sensor,
+            std::numeric_limits<timestamp_t>::min(), std::numeric_limits<timestamp_t>::max());
+}
+
+readings_t_Ptr RocksDBStore::get_timeframe_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
+
+    readings_t_Ptr readings(new readings_t());
+    const ReadingsCursor::Ptr cursor = get_timeframe_reading_records_cursor(sensor, begin, end);
+    reading_t reading;
+
+    while (cursor->next(reading)) {
+        readings->insert(readings->end(), reading);
+    }
     return readings;
 }
 
+ReadingsCursor::Ptr RocksDBStore::get_all_reading_records_cursor(const Sensor::Ptr sensor) {
+
+    return get_timeframe_reading_records_cursor(sensor,
+            std::numeric_limits<timestamp_t>::min(), std::numeric_limits<timestamp_t>::max());
+}
+
+ReadingsCursor::Ptr RocksDBStore::get_timeframe_reading_records_cursor(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
+
+    open_db(false);
+    const std::string key = RocksDBCodec::encode_sensor(sensor->uuid());
+
+    //Expired readings are hidden, even before a compaction drops them
+    const timestamp_t cutoff = time_converter->convert_from_epoch(_retention_filter->get_cutoff(key));
+
+    return ReadingsCursor::Ptr(new RocksDBReadingsCursor(_db, _readings_family,
+            key, time_converter, std::max(begin, cutoff), end));
+}
+
 unsigned long int RocksDBStore::get_num_readings_value(const Sensor::Ptr sensor) {
 
-    //TODO: make this method more efficient
-    return get_all_readings(sensor)->size();
+    return get_sensor_summary_record(sensor).num_readings();
 }
 
 reading_t RocksDBStore::get_last_reading_record(const Sensor::Ptr sensor) {
 
-    rocksdb::DB* db = open_db(true, false,
-            compose_sensor_readings_path(sensor->uuid_string()));
+    return get_sensor_summary_record(sensor).last_reading();
+}
+
+SensorSummary RocksDBStore::get_sensor_summary_record(const Sensor::Ptr sensor) {
+
+    open_db(false);
+    const std::string key = RocksDBCodec::encode_sensor(sensor->uuid());
+    SensorSummary summary;
 
-    rocksdb::Iterator* it = db->NewIterator(rocksdb::ReadOptions());
-    it->SeekToLast();
+    if (_retention_filter->has_policy(key)) {
+        return Store::get_sensor_summary_record(sensor);
+    }
 
-    const char* epoch = it->key().ToString().c_str();
-    const char* value = it->value().ToString().c_str();
+    //Sensors migrated from older versions have no summary until it is computed once
+    if (!get_summary(key, summary)) {
+        summary = Store::get_sensor_summary_record(sensor);
+        put_value(_sensors_family, key + SUMMARY_KEY, RocksDBCodec::encode_summary(summary));
+    }
+    return summary;
+}
 
-    return std::pair<timestamp_t, double>(
-            time_converter->convert_from_epoch(atol(epoch)),
-            atof(value)
-            );
+void RocksDBStore::refresh_sensor_summaries() {
+
+    if (!_retention_filter) {
+        return;
+    }
+
+    std::set<std::string> sensors;
+    _retention_filter->take_expiring_sensors(sensors);
+
+    for (std::set<std::string>::const_iterator it = sensors.begin(); it != sensors.end(); ++it) {
+        clear_sensor_summary(RocksDBCodec::decode_sensor(*it));
+    }
 }
 
 reading_t RocksDBStore::get_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp) {
 
-    //FIXME: make this method more efficient
-    klio::readings_t_Ptr readings = get_all_readings(sensor);
+    open_db(false);
+    const timestamp_t epoch = time_converter->convert_to_epoch(timestamp);
+    std::string value;
 
-    std::pair<timestamp_t, double> reading = std::pair<timestamp_t, double>(0, 0);
+    if (epoch >= _retention_filter->get_cutoff(RocksDBCodec::encode_sensor(sensor->uuid())) &&
+            get_value(_readings_family, RocksDBCodec::encode_reading(sensor->uuid(), epoch), value)) {
+        return std::pair<timestamp_t, double>(timestamp, RocksDBCodec::decode_value(value));
 
-    if (readings->count(timestamp)) {
-        reading.first = timestamp;
-        reading.second = readings->at(timestamp);
+    } else {
+        return std::pair<timestamp_t, double>(0, 0);
     }
-    return reading;
 }
 
 void RocksDBStore::add_single_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const bool ignore_errors) {
 
-    rocksdb::DB* db = open_db(true, false,
-            compose_sensor_readings_path(sensor->uuid_string()));
+    add_bulk_reading_records(sensor, ReadingsSpan(&timestamp, &value, 1), ignore_errors);
+}
 
-    try {
-        put_value(db, std::to_string(timestamp), std::to_string(value));
+void RocksDBStore::add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
 
-    } catch (std::exception const& e) {
-        handle_reading_insertion_error(ignore_errors, timestamp, value);
-    }
+    sensors_readings_spans_t spans;
+    spans.push_back(sensor_readings_span_t(sensor, readings));
+    add_batch_reading_records(spans, ignore_errors);
 }
 
-void RocksDBStore::add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+void RocksDBStore::add_batch_reading_records(const sensors_readings_spans_t& readings, const bool ignore_errors) {
 
-    rocksdb::DB* db = open_db(true, false,
-            compose_sensor_readings_path(sensor->uuid_string()));
+    open_db(false);
 
+    //The readings of all sensors and their summaries are written atomically
     rocksdb::WriteBatch batch;
+    batch_summaries_t summaries;
+
+    try {
+        for (sensors_readings_spans_cit_t it = readings.begin(); it != readings.end(); ++it) {
 
-    for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
-        try {
-            batch.Put(std::to_string((*it).first), std::to_string((*it).second));
+            const Sensor::uuid_t& uuid = (*it).first->uuid();
+            const ReadingsSpan& span = (*it).second;
 
-        } catch (std::exception const& e) {
-            handle_reading_insertion_error(ignore_errors, (*it).first, (*it).second);
+            for (size_t i = 0; i < span.size(); i++) {
+                batch.Put(_readings_family,
+                        RocksDBCodec::encode_reading(uuid, time_converter->convert_to_epoch(span.timestamp(i))),
+                        RocksDBCodec::encode_value(span.value(i)));
+            }
+            stage_summary(batch, summaries, (*it).first, span);
         }
+        write_batch(batch);
+
+    } catch (std::exception const& e) {
+        handle_reading_insertion_error(ignore_errors, readings, e.what());
+    }
+}
+
+void RocksDBStore::update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
+
+    //Writing a key replaces its value
+    add_bulk_reading_records(sensor, readings, ignore_errors);
+}
+
+void RocksDBStore::load_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
+
+    if (readings.size() < MIN_INGESTED_READINGS) {
+        add_bulk_reading_records(sensor, readings, ignore_errors);
+        return;
     }
+
+    open_db(false);
+    const std::string file_path = compose_ingest_path(sensor->uuid_string());
+
     try {
-        write_batch(db, batch);
+        ingest_readings(sensor, readings, file_path);
+
+        rocksdb::WriteBatch batch;
+        batch_summaries_t summaries;
+        stage_summary(batch, summaries, sensor, readings);
+        write_batch(batch);
 
     } catch (std::exception const& e) {
+        bfs::remove(file_path);
         handle_reading_insertion_error(ignore_errors, sensor);
     }
 }
 
-void RocksDBStore::update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+rocksdb::DB* RocksDBStore::open_db(const bool create_if_missing) {
 
-    //FIXME: improve this method
-    add_bulk_reading_records(sensor, readings, ignore_errors);
+    if (_db) {
+        return _db;
+    }
+
+    //The block cache is shared by both column families, and the memtables are charged to it
+    if (!_block_cache) {
+        _block_cache = rocksdb::NewLRUCache(get_size_option(BLOCK_CACHE_SIZE, 64 << 20));
+        _write_buffer_manager.reset(new rocksdb::WriteBufferManager(
+                get_size_option(WRITE_BUFFER_MANAGER_SIZE, 64 << 20), _block_cache));
+    }
+
+    //The retention filter is used by the compactions of the readings family, and its listener writes the rollups
+    _retention_filter.reset(new RocksDBRetentionFilter());
+    _retention_listener.reset(new RocksDBRetentionListener(_retention_filter));
+
+    rocksdb::DBOptions options;
+    options.create_if_missing = create_if_missing;
+    options.create_missing_column_families = create_if_missing;
+    options.paranoid_checks = get_option("paranoid_checks", "false") == "true";
+    options.write_buffer_manager = _write_buffer_manager;
+    options.listeners.push_back(_retention_listener);
+
+    rocksdb::BlockBasedTableOptions table_options;
+    table_options.block_cache = _block_cache;
+    table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(
+            get_size_option(BLOOM_FILTER_BITS_PER_KEY, 10), false));
+
+    rocksdb::ColumnFamilyOptions sensors_options;
+    sensors_options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+
+    //Bloom filters of the readings are built on the sensor prefix, for timeframe seeks
+    _readings_options = rocksdb::ColumnFamilyOptions();
+    _readings_options.prefix_extractor.reset(rocksdb::NewFixedPrefixTransform(RocksDBCodec::SENSOR_SIZE));
+    _readings_options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    _readings_options.compaction_filter = _retention_filter.get();
+
+    rocksdb::ColumnFamilyOptions rollups_options;
+    rollups_options.prefix_extractor.reset(rocksdb::NewFixedPrefixTransform(RocksDBCodec::SENSOR_SIZE));
+    rollups_options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    rollups_options.merge_operator.reset(new RocksDBRollupMergeOperator());
+
+    std::vector<rocksdb::ColumnFamilyDescriptor> families;
+    families.push_back(rocksdb::ColumnFamilyDescriptor(rocksdb::kDefaultColumnFamilyName, sensors_options));
+    families.push_back(rocksdb::ColumnFamilyDescriptor(SENSORS_FAMILY, sensors_options));
+    families.push_back(rocksdb::ColumnFamilyDescriptor(READINGS_FAMILY, _readings_options));
+    families.push_back(rocksdb::ColumnFamilyDescriptor(ROLLUPS_FAMILY, rollups_options));
+
+    rocksdb::DB* db = NULL;
+    const rocksdb::Status status = rocksdb::DB::Open(options, compose_db_path(), families, &_families, &db);
+
+    if (!status.ok()) {
+        throw StoreException(status.ToString());
+    }
+    _db = db;
+    _sensors_family = _families[1];
+    _readings_family = _families[2];
+    _rollups_family = _families[3];
+
+    load_retention_policies();
+    _retention_listener->set_family(_rollups_family);
+    _retention_listener->write_rollups(_db);
+
+    return _db;
 }
 
-void RocksDBStore::clear_buffers() {
+void RocksDBStore::close_db() {
+
+    if (_db) {
+        //Compactions are finished first, so that all their rollups are written
+        rocksdb::CancelAllBackgroundWork(_db, true);
+        _retention_listener->write_rollups(_db);
+        _retention_listener->set_family(NULL);
 
-    Store::clear_buffers();
-    _db_buffer.clear();
+        for (std::vector<rocksdb::ColumnFamilyHandle*>::const_iterator it = _families.begin(); it != _families.end(); ++it) {
+            _db->DestroyColumnFamilyHandle(*it);
+        }
+        delete _db;
+    }
+    _db = NULL;
+    _families.clear();
+    _sensors_family = NULL;
+    _readings_family = NULL;
+    _rollups_family = NULL;
 }
 
-rocksdb::DB* RocksDBStore::open_db(const bool create_if_missing, const bool error_if_exists, const std::string& db_path) {
+void RocksDBStore::load_retention_policies() {
 
-    rocksdb::DB* db = _db_buffer[db_path];
+    rocksdb::Iterator* it = _db->NewIterator(rocksdb::ReadOptions(), _sensors_family);
 
-    if (!db) {
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+
+        const std::string key = it->key().ToString();
 
-        rocksdb::Options options;
-        options.create_if_missing = create_if_missing;
-        options.error_if_exists = error_if_exists;
-        options.paranoid_checks = _db_options["paranoid_checks"] == "true";
-        options.disableDataSync = _db_options["disableDataSync"] == "true";
+        if (key.size() == RocksDBCodec::SENSOR_SIZE + RETENTION_KEY.size() && key.compare(RocksDBCodec::SENSOR_SIZE, std::string::npos, RETENTION_KEY) == 0) {
 
-        const rocksdb::Status status = rocksdb::DB::Open(options, db_path, &db);
+            timestamp_t time_to_live, rollup_resolution;
+            std::istringstream iss(it->value().ToString());
+            iss >> time_to_live >> rollup_resolution;
 
-        if (!status.ok()) {
-            throw StoreException(status.ToString());
+            if (!iss.fail()) {
+                _retention_filter->set_policy(key.substr(0, RocksDBCodec::SENSOR_SIZE), time_to_live, rollup_resolution);
+            }
         }
-        _db_buffer[db_path] = db;
     }
-    return db;
+
+    const rocksdb::Status status = it->status();
+    delete it;
+
+    if (!status.ok()) {
+        throw StoreException(status.ToString());
+    }
 }
 
-void RocksDBStore::close_db(const std::string& db_path) {
+const std::string RocksDBStore::get_option(const std::string& name, const std::string& default_value) {
+
+    const std::map<const std::string, const std::string>::const_iterator found = _db_options.find(name);
+    return found == _db_options.end() ? default_value : found->second;
+}
 
-    rocksdb::DB* db = _db_buffer[db_path];
+const size_t RocksDBStore::get_size_option(const std::string& name, const size_t default_value) {
 
-    if (db) {
-        _db_buffer.erase(db_path);
-        delete db;
+    const std::map<const std::string, const std::string>::const_iterator found = _db_options.find(name);
+
+    if (found == _db_options.end()) {
+        return default_value;
     }
+
+    try {
+        return boost::lexical_cast<size_t>(found->second);
+
+    } catch (boost::bad_lexical_cast const& e) {
+        std::ostringstream oss;
+        oss << "Invalid value for RocksDB option " << name << ": " << found->second;
+        throw StoreException(oss.str());
+    }
+}
+
+void RocksDBStore::put_sensor(rocksdb::WriteBatch& batch, const Sensor::Ptr sensor) {
+
+    const std::string key = RocksDBCodec::encode_sensor(sensor->uuid());
+
+    batch.Put(_sensors_family, key + SENSOR_PROPERTIES[0], sensor->external_id());
+    batch.Put(_sensors_family, key + SENSOR_PROPERTIES[1], sensor->name());
+    batch.Put(_sensors_family, key + SENSOR_PROPERTIES[2], sensor->description());
+    batch.Put(_sensors_family, key + SENSOR_PROPERTIES[3], sensor->unit());
+    batch.Put(_sensors_family, key + SENSOR_PROPERTIES[4], sensor->timezone());
 }
 
-void RocksDBStore::remove_db(const std::string& db_path) {
+Sensor::Ptr RocksDBStore::create_sensor(const std::string& key, const std::map<std::string, std::string>& properties) {
+
+    std::vector<std::string> values;
+
+    for (size_t i = 0; i < sizeof (SENSOR_PROPERTIES) / sizeof (SENSOR_PROPERTIES[0]); i++) {
+
+        const std::map<std::string, std::string>::const_iterator found = properties.find(SENSOR_PROPERTIES[i]);
 
-    close_db(db_path);
-    bfs::remove_all(db_path);
+        if (found == properties.end()) {
+            std::ostringstream err;
+            err << "Sensor " << boost::uuids::to_string(RocksDBCodec::decode_sensor(key)) << " could not be found.";
+            throw StoreException(err.str());
+        }
+        values.push_back(found->second);
+    }
+    return sensor_factory->createSensor(RocksDBCodec::decode_sensor(key), values[0], values[1], values[2], values[3], values[4]);
 }
 
-void RocksDBStore::put_sensor(const bool create, const Sensor::Ptr sensor) {
+void RocksDBStore::stage_summary(rocksdb::WriteBatch& batch, batch_summaries_t& summaries, const Sensor::Ptr sensor, const ReadingsSpan& readings) {
+
+    const std::string key = RocksDBCodec::encode_sensor(sensor->uuid());
+
+    if (_retention_filter->has_policy(key)) {
+        return;
+    }
+    batch_summaries_t::iterator found = summaries.find(key);
+
+    if (found == summaries.end()) {
+        SensorSummary summary;
+        const bool exists = get_summary(key, summary);
+        found = summaries.insert(batch_summaries_t::value_type(key, std::pair<bool, SensorSummary>(exists, summary))).first;
+    }
 
-    rocksdb::DB* db = open_db(create, create,
-            compose_sensor_properties_path(sensor->uuid_string()));
+    if (!found->second.first) {
+        return;
 
-    put_value(db, "external_id", sensor->external_id());
-    put_value(db, "name", sensor->name());
-    put_value(db, "description", sensor->description());
-    put_value(db, "unit", sensor->unit());
-    put_value(db, "timezone", sensor->timezone());
+    } else if (found->second.second.appendable(readings)) {
+        found->second.second.add(readings);
+        batch.Put(_sensors_family, key + SUMMARY_KEY, RocksDBCodec::encode_summary(found->second.second));
+
+    } else {
+        //Existing readings may have been overwritten, so the summary is computed again when requested
+        found->second.first = false;
+        batch.Delete(_sensors_family, key + SUMMARY_KEY);
+    }
+}
+
+const bool RocksDBStore::get_summary(const std::string& sensor_key, SensorSummary& summary) {
+
+    std::string value;
+    return get_value(_sensors_family, sensor_key + SUMMARY_KEY, value) && RocksDBCodec::decode_summary(value, summary);
 }
 
-void RocksDBStore::put_value(rocksdb::DB* db, const std::string& key, const std::string& value) {
+void RocksDBStore::put_value(rocksdb::ColumnFamilyHandle* family, const std::string& key, const std::string& value) {
 
-    const rocksdb::Status status = db->Put(_write_options, key, value);
+    const rocksdb::Status status = _db->Put(_write_options, family, key, value);
 
     if (!status.ok()) {
         throw StoreException(status.ToString());
     }
 }
 
-std::string RocksDBStore::get_value(rocksdb::DB* db, const std::string& key) {
+const bool RocksDBStore::get_value(rocksdb::ColumnFamilyHandle* family, const std::string& key, std::string& value) {
 
-    rocksdb::ReadOptions options;
+    const rocksdb::Status status = _db->Get(rocksdb::ReadOptions(), family, key, &value);
 
-    std::string value;
-    const rocksdb::Status status = db->Get(options, key, &value);
+    if (status.IsNotFound()) {
+        return false;
+
+    } else if (!status.ok()) {
+        throw StoreException(status.ToString());
+    }
+    return true;
+}
+
+void RocksDBStore::write_batch(rocksdb::WriteBatch& batch) {
+
+    write_batch(batch, _write_options);
+}
+
+void RocksDBStore::write_batch(rocksdb::WriteBatch& batch, const rocksdb::WriteOptions& options) {
+
+    const rocksdb::Status status = _db->Write(options, &batch);
+
+    if (!status.ok()) {
+        throw StoreException(status.ToString());
+    }
+}
+
+void RocksDBStore::ingest_readings(const Sensor::Ptr sensor, const ReadingsSpan& readings, const std::string& file_path) {
+
+    //The readings are sorted by timestamp, so their keys are written in ascending order
+    rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), rocksdb::Options(rocksdb::DBOptions(), _readings_options), _readings_family);
+    rocksdb::Status status = writer.Open(file_path);
+
+    for (size_t i = 0; status.ok() && i < readings.size(); i++) {
+        status = writer.Put(RocksDBCodec::encode_reading(sensor->uuid(), time_converter->convert_to_epoch(readings.timestamp(i))),
+                RocksDBCodec::encode_value(readings.value(i)));
+    }
 
     if (status.ok()) {
-        return value;
+        status = writer.Finish();
+    }
 
-    } else {
+    //Ingested readings get a newer sequence number, so they replace existing ones
+    if (status.ok()) {
+        rocksdb::IngestExternalFileOptions options;
+        options.move_files = true;
+        status = _db->IngestExternalFile(_readings_family, std::vector<std::string>(1, file_path), options);
+    }
+
+    if (!status.ok()) {
         throw StoreException(status.ToString());
     }
 }
 
-void RocksDBStore::delete_value(rocksdb::DB* db, const std::string& key) {
+void RocksDBStore::check_layout() {
+
+    if (bfs::exists(compose_sensors_path())) {
+        std::ostringstream oss;
+        oss << "The sensors of this RocksDB store are kept in the databases of an older version, the store must be upgraded.";
+        throw StoreException(oss.str());
+    }
+}
+
+void RocksDBStore::migrate_sensor_databases() {
+
+    open_db(true);
+    const bfs::directory_iterator end;
+    std::vector<bfs::path> paths;
+
+    for (bfs::directory_iterator it(compose_sensors_path()); it != end; it++) {
+        paths.push_back(it->path());
+    }
+
+    //Each sensor is removed once it was migrated, so nothing is lost if the migration is interrupted.
+    //It is renamed first, so a partly removed database is never migrated again.
+    for (std::vector<bfs::path>::const_iterator it = paths.begin(); it != paths.end(); ++it) {
+
+        if (it->extension() != MIGRATED_EXTENSION) {
+            migrate_sensor_database(it->filename().string());
+        }
+
+        bfs::path migrated = *it;
+        migrated.replace_extension(MIGRATED_EXTENSION);
+        bfs::rename(*it, migrated);
+        bfs::remove_all(migrated);
+    }
+    bfs::remove_all(compose_sensors_path());
+}
+
+void RocksDBStore::migrate_sensor_database(const std::string& uuid_str) {
+
+    Sensor::uuid_t uuid;
+    std::stringstream ss;
+    ss << uuid_str;
+    ss >> uuid;
+
+    if (ss.fail()) {
+        std::ostringstream oss;
+        oss << "The database path contains invalid subdirectories.";
+        throw StoreException(oss.str());
+    }
+
+    //The old databases are removed after the migration, so the migrated data must be durable
+    rocksdb::WriteOptions options;
+    options.sync = true;
+
+    const std::string key = RocksDBCodec::encode_sensor(uuid);
+    rocksdb::WriteBatch batch;
+    bool binary = false;
 
-    const rocksdb::Status status = db->Delete(_write_options, key);
+    rocksdb::DB* properties = open_sensor_database(compose_sensor_properties_path(uuid_str));
+    rocksdb::Iterator* it = properties->NewIterator(rocksdb::ReadOptions());
+
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+
+        const std::string name = it->key().ToString();
+
+        if (name == "readings_format") {
+            binary = it->value().ToString() == "binary";
+
+        } else if (name != SUMMARY_KEY) {
+            batch.Put(_sensors_family, key + name, it->value());
+        }
+    }
+    delete it;
+    delete properties;
+    write_batch(batch, options);
+    batch.Clear();
+
+    //Readings were written as decimal strings, and later as binary keys without the sensor prefix
+    rocksdb::DB* readings = open_sensor_database(compose_sensor_readings_path(uuid_str));
+    it = readings->NewIterator(rocksdb::ReadOptions());
+
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+
+        timestamp_t timestamp;
+        double value;
+
+        if (binary) {
+            timestamp = RocksDBCodec::decode_timestamp(it->key());
+            value = RocksDBCodec::decode_value(it->value());
+
+        } else {
+            timestamp = atol(it->key().ToString().c_str());
+            value = atof(it->value().ToString().c_str());
+        }
+        batch.Put(_readings_family, RocksDBCodec::encode_reading(uuid, timestamp), RocksDBCodec::encode_value(value));
+
+        if (batch.Count() >= MIGRATION_BATCH_SIZE) {
+            write_batch(batch, options);
+            batch.Clear();
+        }
+    }
+
+    const rocksdb::Status status = it->status();
+    delete it;
+    delete readings;
 
     if (!status.ok()) {
         throw StoreException(status.ToString());
     }
+    write_batch(batch, options);
 }
 
-void RocksDBStore::write_batch(rocksdb::DB* db, rocksdb::WriteBatch& batch) {
+rocksdb::DB* RocksDBStore::open_sensor_database(const std::string& db_path) {
 
-    const rocksdb::Status status = db->Write(_write_options, &batch);
+    rocksdb::Options options;
+    options.create_if_missing = false;
+
+    rocksdb::DB* db = NULL;
+    const rocksdb::Status status = rocksdb::DB::Open(options, db_path, &db);
 
     if (!status.ok()) {
         throw StoreException(status.ToString());
     }
+    return db;
+}
+
+const std::string RocksDBStore::compose_db_path() {
+
+    std::ostringstream str;
+    str << _path.string() << "/db";
+    return str.str();
 }
 
 const std::string RocksDBStore::compose_sensors_path() {
@@ -376,6 +829,13 @@ const std::string RocksDBStore::compose_sensors_path() {
     return str.str();
 }
 
+const std::string RocksDBStore::compose_ingest_path(const std::string& uuid) {
+
+    std::ostringstream str;
+    str << _path.string() << "/ingest-" << uuid << ".sst";
+    return str.str();
+}
+
 const std::string RocksDBStore::compose_sensor_path(const std::string& uuid) {
 
     std::ostringstream str;
@@ -26,13 +26,29 @@
 
 #include <boost/filesystem.hpp>
 #include <rocksdb/db.h>
+#include <rocksdb/cache.h>
+#include <rocksdb/write_buffer_manager.h>
+#include <rocksdb/sst_file_writer.h>
 #include <libklio/store.hpp>
+#include <libklio/rocksdb/rocksdb-readings-cursor.hpp>
+#include <libklio/rocksdb/rocksdb-retention.hpp>
 
 
 namespace bfs = boost::filesystem;
 
 namespace klio {
 
+    //Rollups of expired readings, by interval start
+    typedef std::map<timestamp_t, SensorSummary> rollups_t;
+    typedef boost::shared_ptr<rollups_t> rollups_t_Ptr;
+
+    /**
+     * All sensors share a single RocksDB database. Sensor properties and
+     * readings are kept in two column families, with keys prefixed by the
+     * 16 bytes of the sensor uuid. The readings family uses the sensor as
+     * prefix for its bloom filters, and both families share one block
+     * cache, which also accounts for the memtables.
+     */
     class RocksDBStore : public Store {
     public:
         typedef boost::shared_ptr<RocksDBStore> Ptr;
@@ -47,15 +63,14 @@ namespace klio {
         _path(path),
         _synchronous(synchronous),
         _db_options(db_options),
-        _read_options(read_options) {
-
-            if (_synchronous) {
-                _write_options.sync = "true";
-                _write_options.disableWAL = "false";
-            } else {
-                _write_options.sync = "false";
-                _write_options.disableWAL = "true";
-            }
+        _read_options(read_options),
+        _db(NULL),
+        _sensors_family(NULL),
+        _readings_family(NULL),
+        _rollups_family(NULL) {
+
+            _write_options.sync = _synchronous;
+            _write_options.disableWAL = !_synchronous;
         };
 
         virtual ~RocksDBStore() {
@@ -69,47 +84,104 @@ namespace klio {
         void dispose();
         const std::string str();
 
+        //Moves the sensors of an older version, with two databases each, to the single database
+        void upgrade();
+
+        /**
+         * Readings of the sensor that are older than time_to_live seconds
+         * are no longer returned, and they are dropped from the database
+         * by the background compactions. When rollup_resolution is not 0,
+         * the dropped readings are first aggregated into intervals of
+         * that many seconds, which are returned by get_rollups().
+         *
+         * Rollups are written after each compaction. Readings of a
+         * compaction that is aborted may be counted twice.
+         */
+        void set_retention(const Sensor::Ptr sensor, const timestamp_t time_to_live, const timestamp_t rollup_resolution);
+        void remove_retention(const Sensor::Ptr sensor);
+        rollups_t_Ptr get_rollups(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end);
+
+        //Database options, in addition to paranoid_checks. Sizes are in bytes.
+        static const std::string BLOCK_CACHE_SIZE;
+        static const std::string WRITE_BUFFER_MANAGER_SIZE;
+        static const std::string BLOOM_FILTER_BITS_PER_KEY;
+
     protected:
         void add_sensor_record(const Sensor::Ptr sensor);
         void remove_sensor_record(const Sensor::Ptr sensor);
         void update_sensor_record(const Sensor::Ptr sensor);
         void add_single_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const bool ignore_errors);
-        void add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors);
-        void update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors);
+        void add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
+        void add_batch_reading_records(const sensors_readings_spans_t& readings, const bool ignore_errors);
+        void update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
+
+        /**
+         * Large loads are written to a sorted SST file, which is ingested
+         * into the readings family instead of passing through the memtable.
+         */
+        void load_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
 
         std::vector<Sensor::Ptr> get_sensor_records();
         readings_t_Ptr get_all_reading_records(const Sensor::Ptr sensor);
         readings_t_Ptr get_timeframe_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end);
+        ReadingsCursor::Ptr get_all_reading_records_cursor(const Sensor::Ptr sensor);
+        ReadingsCursor::Ptr get_timeframe_reading_records_cursor(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end);
         unsigned long int get_num_readings_value(const Sensor::Ptr sensor);
         reading_t get_last_reading_record(const Sensor::Ptr sensor);
+        SensorSummary get_sensor_summary_record(const Sensor::Ptr sensor);
         reading_t get_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp);
 
-        void clear_buffers();
+        //Summaries of sensors with a retention policy change as their readings expire
+        void refresh_sensor_summaries();
 
     private:
         RocksDBStore(const RocksDBStore& original);
         RocksDBStore& operator =(const RocksDBStore& rhs);
 
+        //Summaries read or written during one batch, by sensor key prefix
+        typedef std::map<std::string, std::pair<bool, SensorSummary> > batch_summaries_t;
+
         bfs::path _path;
         bool _synchronous;
         std::map<const std::string, const std::string> _db_options;
         std::map<const std::string, const std::string> _read_options;
         rocksdb::WriteOptions _write_options;
-        std::map<const std::string, rocksdb::DB*> _db_buffer;
-
-        rocksdb::DB* open_db(const bool create_if_missing, const bool error_if_exists, const std::string& db_path);
-        void close_db(const std::string& db_path);
-        void remove_db(const std::string& db_path);
 
-        void put_sensor(const bool create, const Sensor::Ptr sensor);
-        void put_value(rocksdb::DB* db, const std::string& key, const std::string& value);
-        std::string get_value(rocksdb::DB* db, const std::string& key);
-        void delete_value(rocksdb::DB* db, const std::string& key);
-        void write_batch(rocksdb::DB* db, rocksdb::WriteBatch& batch);
-        Sensor::Ptr load_sensor(const Sensor::uuid_t& uuid);
+        rocksdb::DB* _db;
+        std::vector<rocksdb::ColumnFamilyHandle*> _families;
+        rocksdb::ColumnFamilyHandle* _sensors_family;
+        rocksdb::ColumnFamilyHandle* _readings_family;
+        rocksdb::ColumnFamilyOptions _readings_options;
+        rocksdb::ColumnFamilyHandle* _rollups_family;
+        std::shared_ptr<RocksDBRetentionFilter> _retention_filter;
+        std::shared_ptr<RocksDBRetentionListener> _retention_listener;
+        std::shared_ptr<rocksdb::Cache> _block_cache;
+        std::shared_ptr<rocksdb::WriteBufferManager> _write_buffer_manager;
+
+        rocksdb::DB* open_db(const bool create_if_missing);
+        void close_db();
+        void load_retention_policies();
+        const std::string get_option(const std::string& name, const std::string& default_value);
+        const size_t get_size_option(const std::string& name, const size_t default_value);
+
+        void put_sensor(rocksdb::WriteBatch& batch, const Sensor::Ptr sensor);
+        Sensor::Ptr create_sensor(const std::string& key, const std::map<std::string, std::string>& properties);
+        void stage_summary(rocksdb::WriteBatch& batch, batch_summaries_t& summaries, const Sensor::Ptr sensor, const ReadingsSpan& readings);
+        const bool get_summary(const std::string& sensor_key, SensorSummary& summary);
+        void put_value(rocksdb::ColumnFamilyHandle* family, const std::string& key, const std::string& value);
+        const bool get_value(rocksdb::ColumnFamilyHandle* family, const std::string& key, std::string& value);
+        void write_batch(rocksdb::WriteBatch& batch);
+        void write_batch(rocksdb::WriteBatch& batch, const rocksdb::WriteOptions& options);
+        void ingest_readings(const Sensor::Ptr sensor, const ReadingsSpan& readings, const std::string& file_path);
+
+        void check_layout();
+        void migrate_sensor_databases();
+        void migrate_sensor_database(const std::string& uuid);
+        rocksdb::DB* open_sensor_database(const std::string& db_path);
 
         const std::string compose_db_path();
         const std::string compose_sensors_path();
+        const std::string compose_ingest_path(const std::string& uuid);
         const std::string compose_sensor_path(const std::string& uuid);
         const std::string compose_sensor_properties_path(const std::string& uuid);
         const std::string compose_sensor_readings_path(const std::string& uuid);
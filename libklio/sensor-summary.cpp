@@ -0,0 +1,85 @@
+#include <sstream>
+#include <libklio/sensor-summary.hpp>
+
+
+using namespace klio;
+
+const bool SensorSummary::appendable(const ReadingsSpan& readings) const {
+
+    return _num_readings == 0 || readings.empty() || readings.timestamp(0) > _last_timestamp;
+}
+
+void SensorSummary::add(const timestamp_t timestamp, const double value) {
+
+    if (_num_readings == 0) {
+        _first_timestamp = timestamp;
+        _last_timestamp = timestamp;
+        _last_value = value;
+        _min_value = value;
+        _max_value = value;
+
+    } else {
+        if (timestamp < _first_timestamp) {
+            _first_timestamp = timestamp;
+        }
+        if (timestamp >= _last_timestamp) {
+            _last_timestamp = timestamp;
+            _last_value = value;
+        }
+        if (value < _min_value) {
+            _min_value = value;
+        }
+        if (value > _max_value) {
+            _max_value = value;
+        }
+    }
+    _sum += value;
+    _num_readings++;
+}
+
+void SensorSummary::add(const ReadingsSpan& readings) {
+
+    for (size_t i = 0; i < readings.size(); i++) {
+        add(readings.timestamp(i), readings.value(i));
+    }
+}
+
+void SensorSummary::add(const SensorSummary& summary) {
+
+    if (summary._num_readings == 0) {
+        return;
+
+    } else if (_num_readings == 0) {
+        *this = summary;
+        return;
+    }
+
+    if (summary._first_timestamp < _first_timestamp) {
+        _first_timestamp = summary._first_timestamp;
+    }
+    if (summary._last_timestamp >= _last_timestamp) {
+        _last_timestamp = summary._last_timestamp;
+        _last_value = summary._last_value;
+    }
+    if (summary._min_value < _min_value) {
+        _min_value = summary._min_value;
+    }
+    if (summary._max_value > _max_value) {
+        _max_value = summary._max_value;
+    }
+    _sum += summary._sum;
+    _num_readings += summary._num_readings;
+}
+
+const std::string SensorSummary::str() const {
+
+    std::ostringstream oss;
+    oss << _num_readings << " readings";
+
+    if (_num_readings > 0) {
+        oss << " from " << _first_timestamp << " to " << _last_timestamp <<
+                ", last value " << _last_value <<
+                ", min " << _min_value << ", max " << _max_value << ", sum " << _sum;
+    }
+    return oss.str();
+}
@@ -0,0 +1,125 @@
+/**
+ * This file is part of libklio.
+ *
+ * (c) Fraunhofer ITWM
+ *
+ * libklio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libklio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libklio. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKLIO_SENSOR_SUMMARY_HPP
+#define LIBKLIO_SENSOR_SUMMARY_HPP 1
+
+#include <libklio/common.hpp>
+#include <libklio/types.hpp>
+#include <libklio/readings-buffer.hpp>
+
+
+namespace klio {
+
+    /**
+     * Statistics of all readings of a sensor. Stores keep a summary per
+     * sensor and extend it when readings are flushed, so that it can be
+     * retrieved without reading the time series.
+     */
+    class SensorSummary {
+    public:
+
+        SensorSummary() :
+        _num_readings(0),
+        _first_timestamp(0),
+        _last_timestamp(0),
+        _last_value(0),
+        _min_value(0),
+        _max_value(0),
+        _sum(0) {
+        };
+
+        SensorSummary(const unsigned long int num_readings, const timestamp_t first_timestamp, const timestamp_t last_timestamp,
+                const double last_value, const double min_value, const double max_value, const double sum) :
+        _num_readings(num_readings),
+        _first_timestamp(first_timestamp),
+        _last_timestamp(last_timestamp),
+        _last_value(last_value),
+        _min_value(min_value),
+        _max_value(max_value),
+        _sum(sum) {
+        };
+
+        const unsigned long int num_readings() const {
+            return _num_readings;
+        };
+
+        const bool empty() const {
+            return _num_readings == 0;
+        };
+
+        const timestamp_t first_timestamp() const {
+            return _first_timestamp;
+        };
+
+        const timestamp_t last_timestamp() const {
+            return _last_timestamp;
+        };
+
+        const double last_value() const {
+            return _last_value;
+        };
+
+        const reading_t last_reading() const {
+            return reading_t(_last_timestamp, _last_value);
+        };
+
+        const double min_value() const {
+            return _min_value;
+        };
+
+        const double max_value() const {
+            return _max_value;
+        };
+
+        const double sum() const {
+            return _sum;
+        };
+
+        const double mean() const {
+            return _num_readings == 0 ? 0 : _sum / _num_readings;
+        };
+
+        /**
+         * Readings can only be added to a summary when they are newer than
+         * all readings it covers. Otherwise they may replace readings that
+         * are already counted, and the summary has to be computed again.
+         */
+        const bool appendable(const ReadingsSpan& readings) const;
+
+        void add(const timestamp_t timestamp, const double value);
+        void add(const ReadingsSpan& readings);
+
+        //Combines the statistics of two disjoint sets of readings
+        void add(const SensorSummary& summary);
+
+        const std::string str() const;
+
+    private:
+        unsigned long int _num_readings;
+        timestamp_t _first_timestamp;
+        timestamp_t _last_timestamp;
+        double _last_value;
+        double _min_value;
+        double _max_value;
+        double _sum;
+    };
+};
+
+#endif /* LIBKLIO_SENSOR_SUMMARY_HPP */
@@ -0,0 +1,31 @@
+#include <sstream>
+#include <libklio/sqlite3/sqlite3-readings-cursor.hpp>
+
+
+using namespace klio;
+
+bool SQLite3ReadingsCursor::next(reading_t& reading) {
+
+    //Stepping a finished statement would run it again
+    if (_done) {
+        return false;
+    }
+
+    const int rc = sqlite3_step(_stmt);
+
+    if (rc == SQLITE_ROW) {
+        reading.first = _time_converter->convert_from_epoch(sqlite3_column_int64(_stmt, 0));
+        reading.second = sqlite3_column_double(_stmt, 1);
+        return true;
+
+    } else if (rc == SQLITE_DONE) {
+        _done = true;
+        return false;
+
+    } else {
+        _done = true;
+        std::ostringstream oss;
+        oss << "Can't fetch reading. Error: " << sqlite3_errmsg(sqlite3_db_handle(_stmt)) << ", Error code: " << rc;
+        throw StoreException(oss.str());
+    }
+}
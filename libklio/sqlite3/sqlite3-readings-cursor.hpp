@@ -0,0 +1,66 @@
+/**
+ * This file is part of libklio.
+ *
+ * (c) Fraunhofer ITWM
+ *
+ * libklio is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libklio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libklio. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBKLIO_SQLITE3_READINGS_CURSOR_HPP
+#define LIBKLIO_SQLITE3_READINGS_CURSOR_HPP 1
+
+#include <sqlite3.h>
+#include <libklio/readings-cursor.hpp>
+#include <libklio/time.hpp>
+
+
+namespace klio {
+
+    /**
+     * Steps through the rows of a prepared statement, which must select
+     * timestamp and value in this order. The cursor takes ownership of the
+     * statement and finalizes it when it is destroyed.
+     */
+    class SQLite3ReadingsCursor : public ReadingsCursor {
+    public:
+        typedef boost::shared_ptr<SQLite3ReadingsCursor> Ptr;
+
+        SQLite3ReadingsCursor(sqlite3_stmt* stmt, const TimeConverter::Ptr time_converter) :
+        ReadingsCursor(),
+        _stmt(stmt),
+        _time_converter(time_converter),
+        _done(false) {
+        };
+
+        virtual ~SQLite3ReadingsCursor() {
+            sqlite3_finalize(_stmt);
+        };
+
+        sqlite3_stmt* statement() const {
+            return _stmt;
+        };
+
+        bool next(reading_t& reading);
+
+    private:
+        SQLite3ReadingsCursor(const SQLite3ReadingsCursor& original);
+        SQLite3ReadingsCursor& operator=(const SQLite3ReadingsCursor& rhs);
+
+        sqlite3_stmt* _stmt;
+        TimeConverter::Ptr _time_converter;
+        bool _done;
+    };
+};
+
+#endif /* LIBKLIO_SQLITE3_READINGS_CURSOR_HPP */
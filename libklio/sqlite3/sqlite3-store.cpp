@@ -1,10 +1,15 @@
 #include <iostream>
 #include <sstream>
 #include <cstdio>
+#include <algorithm>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/lexical_cast.hpp>
 #include <libklio/sqlite3/sqlite3-transaction.hpp>
 #include <libklio/sqlite3/sqlite3-store.hpp>
 
@@ -15,6 +20,41 @@ const std::string SQLite3Store::OS_SYNC_OFF = "OFF";
 const std::string SQLite3Store::OS_SYNC_NORMAL = "NORMAL";
 const std::string SQLite3Store::OS_SYNC_FULL = "FULL";
 
+const std::string SQLite3Store::JOURNAL_MODE = "journal_mode";
+const std::string SQLite3Store::MMAP_SIZE = "mmap_size";
+const std::string SQLite3Store::CACHE_SIZE = "cache_size";
+const std::string SQLite3Store::TEMP_STORE = "temp_store";
+const std::string SQLite3Store::WAL_AUTOCHECKPOINT = "wal_autocheckpoint";
+
+const std::string SQLite3Store::JOURNAL_MODE_DELETE = "DELETE";
+const std::string SQLite3Store::JOURNAL_MODE_WAL = "WAL";
+
+const std::string SQLite3Store::SCHEMA = "schema";
+const std::string SQLite3Store::SCHEMA_READINGS_TABLE = "readings_table";
+const std::string SQLite3Store::SCHEMA_SENSOR_TABLES = "sensor_tables";
+
+const std::string SQLite3Store::TIMESTAMP_RESOLUTION = "timestamp_resolution";
+const std::string SQLite3Store::TIMESTAMP_RESOLUTION_SECONDS = "seconds";
+const std::string SQLite3Store::TIMESTAMP_RESOLUTION_MILLISECONDS = "milliseconds";
+
+//Files that SQLite keeps next to the database in WAL journal mode
+static const char* WAL_SUFFIXES[] = {"-wal", "-shm"};
+
+//Readings statements, composed for either schema: $table is the readings source and $sensor the sensor condition
+static const std::string SELECT_READINGS_SQL = "SELECT timestamp, value FROM $table WHERE $sensor";
+static const std::string SELECT_TIMEFRAME_READINGS_SQL = "SELECT timestamp, value FROM $table WHERE $sensor AND timestamp BETWEEN ?2 AND ?3";
+static const std::string COUNT_READINGS_SQL = "SELECT count(*) FROM $table WHERE $sensor";
+static const std::string SELECT_LAST_READING_SQL = "SELECT timestamp, value FROM $table WHERE $sensor ORDER BY timestamp DESC LIMIT 1";
+static const std::string SELECT_READING_SQL = "SELECT timestamp, value FROM $table WHERE $sensor AND timestamp = ?2";
+static const std::string SELECT_SUMMARY_SQL = "SELECT count(*), min(timestamp), max(timestamp), min(value), max(value), total(value), "
+        "(SELECT value FROM $table WHERE $sensor ORDER BY timestamp DESC LIMIT 1) FROM $table WHERE $sensor";
+
+//Buckets start at multiples of ?4, the modulo is corrected for timestamps before the epoch
+static const std::string SELECT_AGGREGATED_READINGS_SQL = "SELECT timestamp - ((timestamp % ?4) + ?4) % ?4 AS bucket, $aggregate "
+        "FROM $table WHERE $sensor AND timestamp BETWEEN ?2 AND ?3 GROUP BY bucket ORDER BY bucket";
+
+static const std::string SENSORS_COLUMNS_SQL = "(id INTEGER PRIMARY KEY, uuid VARCHAR(36) NOT NULL UNIQUE, external_id VARCHAR(36), name VARCHAR(100), description VARCHAR(255), unit VARCHAR(20), timezone VARCHAR(30), device_type_id INTEGER)";
+
 void SQLite3Store::open() {
 
     if (_db == NULL) {
@@ -27,6 +67,8 @@ void SQLite3Store::open() {
 
 void SQLite3Store::close() {
 
+    stop_async_flush();
+
     if (_db == NULL) {
         LOG("Store is already closed.");
 
@@ -46,6 +88,9 @@ void SQLite3Store::open_db() {
 
     if (sqlite3_open_v2(_path.c_str(), &_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) == SQLITE_OK) {
 
+        //Each row of a multi-row insertion binds two variables, plus the sensor id
+        _max_rows_per_statement = std::max(1, (sqlite3_limit(_db, SQLITE_LIMIT_VARIABLE_NUMBER, -1) - 1) / 2);
+
         if (_transaction) {
             _transaction->db(_db);
 
@@ -53,6 +98,19 @@ void SQLite3Store::open_db() {
             _transaction = create_transaction_handler();
         }
 
+        try {
+            apply_options();
+            _readings_table = has_table("readings");
+
+            if (has_table("properties")) {
+                load_timestamp_resolution();
+            }
+
+        } catch (std::exception const& e) {
+            close_db();
+            throw;
+        }
+
     } else {
         std::ostringstream oss;
         if (_db) {
@@ -70,6 +128,113 @@ void SQLite3Store::open_db() {
     }
 }
 
+void SQLite3Store::apply_options() {
+
+    set_pragma("synchronous", _synchronous);
+
+    for (std::map<const std::string, const std::string>::const_iterator it = _db_options.begin(); it != _db_options.end(); ++it) {
+
+        const std::string name = (*it).first;
+        const std::string value = boost::to_upper_copy((*it).second);
+        bool valid;
+        bool pragma = true;
+
+        //Schema and timestamp resolution are not pragmas, see initialize()
+        if (name == SCHEMA) {
+            valid = (*it).second == SCHEMA_READINGS_TABLE || (*it).second == SCHEMA_SENSOR_TABLES;
+            pragma = false;
+
+        } else if (name == TIMESTAMP_RESOLUTION) {
+            valid = (*it).second == TIMESTAMP_RESOLUTION_SECONDS || (*it).second == TIMESTAMP_RESOLUTION_MILLISECONDS;
+            pragma = false;
+
+        } else if (name == JOURNAL_MODE) {
+            valid = value == JOURNAL_MODE_DELETE || value == JOURNAL_MODE_WAL ||
+                    value == "TRUNCATE" || value == "PERSIST" || value == "MEMORY" || value == "OFF";
+
+        } else if (name == TEMP_STORE) {
+            valid = value == "DEFAULT" || value == "FILE" || value == "MEMORY" ||
+                    value == "0" || value == "1" || value == "2";
+
+        } else if (name == MMAP_SIZE || name == CACHE_SIZE || name == WAL_AUTOCHECKPOINT) {
+            try {
+                boost::lexical_cast<long long>(value);
+                valid = true;
+
+            } catch (boost::bad_lexical_cast const& e) {
+                valid = false;
+            }
+
+        } else {
+            std::ostringstream oss;
+            oss << "Unknown SQLite3 option: " << name;
+            throw StoreException(oss.str());
+        }
+
+        if (!valid) {
+            std::ostringstream oss;
+            oss << "Invalid value for SQLite3 option " << name << ": " << (*it).second;
+            throw StoreException(oss.str());
+        }
+
+        if (pragma) {
+            set_pragma(name, value);
+        }
+    }
+}
+
+void SQLite3Store::set_pragma(const std::string& name, const std::string& value) {
+
+    std::ostringstream oss;
+    oss << "PRAGMA " << name << " = " << value;
+    sqlite3_stmt* stmt = prepare(oss.str());
+
+    int rc = sqlite3_step(stmt);
+
+    //Some pragmas return the new setting, e.g. the journal mode actually in use
+    if (rc == SQLITE_ROW && name == JOURNAL_MODE) {
+
+        const std::string mode((char*) sqlite3_column_text(stmt, 0));
+        if (!boost::iequals(mode, value)) {
+            LOG("Journal mode " << value << " is not available, using " << mode);
+        }
+    }
+
+    while (rc == SQLITE_ROW) {
+        rc = sqlite3_step(stmt);
+    }
+
+    if (rc != SQLITE_DONE) {
+        oss.str("");
+        oss << "Can't set SQLite3 option " << name << ". Error: " << sqlite3_errmsg(_db) << ", Error code: " << rc;
+        finalize(&stmt);
+        throw StoreException(oss.str());
+    }
+    finalize(&stmt);
+}
+
+void SQLite3Store::load_timestamp_resolution() {
+
+    //Stores without the property predate millisecond mode
+    std::string stored = TIMESTAMP_RESOLUTION_SECONDS;
+    sqlite3_stmt* stmt = get_statement("SELECT value FROM properties WHERE name = ?1");
+    sqlite3_bind_text(stmt, 1, TIMESTAMP_RESOLUTION.c_str(), -1, SQLITE_TRANSIENT);
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        stored = std::string((char*) sqlite3_column_text(stmt, 0));
+    }
+    reset(stmt);
+
+    const std::map<const std::string, const std::string>::const_iterator requested = _db_options.find(TIMESTAMP_RESOLUTION);
+
+    if (requested != _db_options.end() && requested->second != stored) {
+        std::ostringstream oss;
+        oss << "The store keeps timestamps in " << stored << ", not in " << requested->second << ".";
+        throw StoreException(oss.str());
+    }
+    _timestamps_per_second = stored == TIMESTAMP_RESOLUTION_MILLISECONDS ? 1000 : 1;
+}
+
 void SQLite3Store::close_db() {
 
     if (sqlite3_close_v2(_db) == SQLITE_OK) {
@@ -110,7 +275,7 @@ void SQLite3Store::check_integrity() {
         } else if (!bfs::is_regular_file(_path)) {
             result = "This is not a regular file.";
 
-        } else if (bfs::file_size(_path) == 0) {
+        } else if (bfs::file_size(_path) == 0 && !has_wal_content()) {
             result = "File is empty.";
 
         } else {
@@ -186,15 +351,23 @@ void SQLite3Store::check_integrity() {
 
 void SQLite3Store::initialize() {
 
-    //FIXME: change type of field timestamp
+    //New stores get the schema option, existing ones keep their layout until they are upgraded
+    const bool new_readings_table = !has_table("sensors") && use_readings_table();
 
     //Create table sensors if it does not exist
-    sqlite3_stmt* stmt = prepare("CREATE TABLE IF NOT EXISTS sensors(uuid VARCHAR(36) PRIMARY KEY, external_id VARCHAR(36), name VARCHAR(100), description VARCHAR(255), unit VARCHAR(20), timezone VARCHAR(30), device_type_id INTEGER)");
+    sqlite3_stmt* stmt = new_readings_table ?
+            prepare("CREATE TABLE IF NOT EXISTS sensors" + SENSORS_COLUMNS_SQL) :
+            prepare("CREATE TABLE IF NOT EXISTS sensors(uuid VARCHAR(36) PRIMARY KEY, external_id VARCHAR(36), name VARCHAR(100), description VARCHAR(255), unit VARCHAR(20), timezone VARCHAR(30), device_type_id INTEGER)");
 
     try {
         execute(stmt, SQLITE_DONE);
         finalize(&stmt);
 
+        if (new_readings_table) {
+            create_readings_table();
+        }
+        _readings_table = has_table("readings");
+
         stmt = prepare("CREATE UNIQUE INDEX IF NOT EXISTS sensors_external_id_idx ON sensors (external_id)");
         execute(stmt, SQLITE_DONE);
         finalize(&stmt);
@@ -209,8 +382,18 @@ void SQLite3Store::initialize() {
         sqlite3_bind_text(stmt, 1, "version", -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 2, info->getVersion().c_str(), -1, SQLITE_TRANSIENT);
         execute(stmt, SQLITE_DONE);
+        reset(stmt);
+
+        //Rotated files keep the resolution of the store, which may have been opened without the option
+        const std::map<const std::string, const std::string>::const_iterator resolution = _db_options.find(TIMESTAMP_RESOLUTION);
+        const std::string& current = _timestamps_per_second == 1000 ? TIMESTAMP_RESOLUTION_MILLISECONDS : TIMESTAMP_RESOLUTION_SECONDS;
+        sqlite3_bind_text(stmt, 1, TIMESTAMP_RESOLUTION.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, (resolution == _db_options.end() ? current : resolution->second).c_str(), -1, SQLITE_TRANSIENT);
+        execute(stmt, SQLITE_DONE);
         finalize(&stmt);
 
+        load_timestamp_resolution();
+
         std::ostringstream oss;
         oss << "PRAGMA synchronous = " << _synchronous;
         sqlite3_stmt* stmt = prepare(oss.str());
@@ -247,11 +430,17 @@ void SQLite3Store::upgrade() {
             finalize(&stmt);
         }
 
+        if (!_readings_table && use_readings_table()) {
+            finalize_sensor_statements();
+            migrate_sensor_tables();
+        }
+
         stmt = prepare("CREATE UNIQUE INDEX IF NOT EXISTS sensors_external_id_idx ON sensors (external_id)");
         execute(stmt, SQLITE_DONE);
         finalize(&stmt);
 
         auto_commit_transaction(transaction);
+        _readings_table = has_table("readings");
 
     } catch (std::exception const& e) {
         finalize(&stmt);
@@ -259,6 +448,65 @@ void SQLite3Store::upgrade() {
     }
 }
 
+const bool SQLite3Store::use_readings_table() {
+
+    const std::map<const std::string, const std::string>::const_iterator found = _db_options.find(SCHEMA);
+    return found == _db_options.end() || found->second != SCHEMA_SENSOR_TABLES;
+}
+
+void SQLite3Store::create_readings_table() {
+
+    execute("CREATE TABLE IF NOT EXISTS readings(sensor_id INTEGER NOT NULL, timestamp INTEGER NOT NULL, value REAL, PRIMARY KEY(sensor_id, timestamp)) WITHOUT ROWID");
+}
+
+void SQLite3Store::migrate_sensor_tables() {
+
+    //Sensors get an integer id, which requires rebuilding the sensors table
+    execute("CREATE TABLE sensors_upgrade" + SENSORS_COLUMNS_SQL);
+    execute("INSERT INTO sensors_upgrade (uuid, external_id, name, description, unit, timezone, device_type_id) SELECT uuid, external_id, name, description, unit, timezone, device_type_id FROM sensors");
+    execute("DROP TABLE sensors");
+    execute("ALTER TABLE sensors_upgrade RENAME TO sensors");
+    create_readings_table();
+
+    std::vector<std::pair<sqlite3_int64, std::string> > sensors;
+    sqlite3_stmt* stmt = prepare("SELECT id, uuid FROM sensors");
+
+    while (SQLITE_ROW == sqlite3_step(stmt)) {
+        sensors.push_back(std::pair<sqlite3_int64, std::string>(
+                sqlite3_column_int64(stmt, 0),
+                std::string((char*) sqlite3_column_text(stmt, 1))));
+    }
+    finalize(&stmt);
+
+    for (std::vector<std::pair<sqlite3_int64, std::string> >::const_iterator it = sensors.begin(); it != sensors.end(); ++it) {
+
+        if (has_table((*it).second)) {
+
+            std::ostringstream oss;
+            oss << "INSERT INTO readings (sensor_id, timestamp, value) SELECT " << (*it).first << ", timestamp, value FROM '" << (*it).second << "'";
+            execute(oss.str());
+
+            oss.str("");
+            oss << "DROP TABLE '" << (*it).second << "'";
+            execute(oss.str());
+        }
+    }
+}
+
+void SQLite3Store::execute(const std::string& sql) {
+
+    sqlite3_stmt* stmt = prepare(sql);
+
+    try {
+        execute(stmt, SQLITE_DONE);
+
+    } catch (std::exception const& e) {
+        finalize(&stmt);
+        throw;
+    }
+    finalize(&stmt);
+}
+
 void SQLite3Store::prepare() {
 
     prepare_statements();
@@ -279,6 +527,8 @@ void SQLite3Store::prepare_statements() {
 
 void SQLite3Store::finalize_statements() {
 
+    finalize_sensor_statements();
+
     for (boost::unordered_map<const std::string, sqlite3_stmt*>::const_iterator it = _statements.begin(); it != _statements.end(); ++it) {
         sqlite3_stmt* stmt = (*it).second;
         finalize(&stmt);
@@ -300,20 +550,29 @@ void SQLite3Store::dispose() {
 
     close();
     bfs::remove(_path);
+
+    for (size_t i = 0; i < sizeof (WAL_SUFFIXES) / sizeof (WAL_SUFFIXES[0]); i++) {
+        bfs::remove(_path.string() + WAL_SUFFIXES[i]);
+    }
 }
 
 void SQLite3Store::rotate(bfs::path to_path) {
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+
     if (_db == NULL || _transaction->pending()) {
         std::ostringstream oss;
         oss << "The database must be open and all transactions finalized so that the store can be rotated.";
         throw StoreException(oss.str());
     }
 
+    //The rotated database file must not depend on the write-ahead log
+    checkpoint();
+
     finalize_statements();
     close_db();
 
-    boost::filesystem::rename(_path, to_path);
+    move_db_files(to_path);
 
     open_db();
 
@@ -325,6 +584,48 @@ void SQLite3Store::rotate(bfs::path to_path) {
     }
 }
 
+void SQLite3Store::checkpoint() {
+
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+
+    if (_db == NULL) {
+        std::ostringstream oss;
+        oss << "The database must be open so that it can be checkpointed.";
+        throw StoreException(oss.str());
+    }
+
+    const int rc = sqlite3_wal_checkpoint_v2(_db, NULL, SQLITE_CHECKPOINT_TRUNCATE, NULL, NULL);
+
+    if (rc == SQLITE_BUSY) {
+        LOG("The write-ahead log is in use by other connections and could not be truncated.");
+
+    } else if (rc != SQLITE_OK) {
+        std::ostringstream oss;
+        oss << "Can't checkpoint the database. Error: " << sqlite3_errmsg(_db) << ", Error code: " << rc;
+        throw StoreException(oss.str());
+    }
+}
+
+void SQLite3Store::move_db_files(const bfs::path& to_path) {
+
+    bfs::rename(_path, to_path);
+
+    //Logs left behind by other connections belong to the rotated database
+    for (size_t i = 0; i < sizeof (WAL_SUFFIXES) / sizeof (WAL_SUFFIXES[0]); i++) {
+
+        const bfs::path from(_path.string() + WAL_SUFFIXES[i]);
+        if (bfs::exists(from)) {
+            bfs::rename(from, bfs::path(to_path.string() + WAL_SUFFIXES[i]));
+        }
+    }
+}
+
+const bool SQLite3Store::has_wal_content() {
+
+    const bfs::path wal(_path.string() + WAL_SUFFIXES[0]);
+    return bfs::exists(wal) && bfs::file_size(wal) > 0;
+}
+
 Transaction::Ptr SQLite3Store::get_transaction_handler() {
 
     return _auto_commit ? create_transaction_handler() : _transaction;
@@ -399,6 +700,10 @@ void SQLite3Store::add_sensor_record(const Sensor::Ptr sensor) {
     }
     reset(_insert_sensor_stmt);
 
+    if (_readings_table) {
+        return;
+    }
+
     std::ostringstream oss;
     oss << "CREATE TABLE '" << sensor->uuid_string() << "'(timestamp INTEGER PRIMARY KEY, value DOUBLE)";
     sqlite3_stmt* create_table_stmt = prepare(oss.str());
@@ -415,6 +720,8 @@ void SQLite3Store::add_sensor_record(const Sensor::Ptr sensor) {
 
 void SQLite3Store::remove_sensor_record(const Sensor::Ptr sensor) {
 
+    const sqlite3_int64 sensor_id = _readings_table ? get_sensor_statements(sensor)->sensor_id : 0;
+
     try {
         sqlite3_bind_text(_remove_sensor_stmt, 1, sensor->uuid_string().c_str(), -1, SQLITE_TRANSIENT);
 
@@ -425,6 +732,14 @@ void SQLite3Store::remove_sensor_record(const Sensor::Ptr sensor) {
         throw;
     }
     reset(_remove_sensor_stmt);
+    finalize_sensor_statements(sensor->uuid());
+
+    if (_readings_table) {
+        std::ostringstream oss;
+        oss << "DELETE FROM readings WHERE sensor_id = " << sensor_id;
+        execute(oss.str());
+        return;
+    }
 
     std::ostringstream oss;
     oss << "DROP TABLE '" << sensor->uuid_string() << "'";
@@ -480,9 +795,7 @@ std::vector<Sensor::Ptr> SQLite3Store::get_sensor_records() {
 readings_t_Ptr SQLite3Store::get_all_reading_records(const Sensor::Ptr sensor) {
 
     readings_t_Ptr readings;
-    std::ostringstream oss;
-    oss << "SELECT timestamp, value FROM '" << sensor->uuid_string() << "'";
-    sqlite3_stmt* stmt = get_statement(oss.str());
+    sqlite3_stmt* stmt = get_sensor_statement(&get_sensor_statements(sensor)->select_readings_stmt, sensor, SELECT_READINGS_SQL);
 
     try {
         readings = get_readings_records(stmt);
@@ -498,13 +811,11 @@ readings_t_Ptr SQLite3Store::get_all_reading_records(const Sensor::Ptr sensor) {
 readings_t_Ptr SQLite3Store::get_timeframe_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
 
     readings_t_Ptr readings;
-    std::ostringstream oss;
-    oss << "SELECT timestamp, value FROM '" << sensor->uuid_string() << "' WHERE timestamp BETWEEN ? AND ?";
-    sqlite3_stmt* stmt = get_statement(oss.str());
+    sqlite3_stmt* stmt = get_sensor_statement(&get_sensor_statements(sensor)->select_timeframe_readings_stmt, sensor, SELECT_TIMEFRAME_READINGS_SQL);
 
     try {
-        sqlite3_bind_int(stmt, 1, begin);
-        sqlite3_bind_int(stmt, 2, end);
+        sqlite3_bind_int64(stmt, 2, begin);
+        sqlite3_bind_int64(stmt, 3, end);
 
         readings = get_readings_records(stmt);
 
@@ -516,6 +827,52 @@ readings_t_Ptr SQLite3Store::get_timeframe_reading_records(const Sensor::Ptr sen
     return readings;
 }
 
+ReadingsCursor::Ptr SQLite3Store::get_all_reading_records_cursor(const Sensor::Ptr sensor) {
+
+    //Cursors own their statements, so that several of them can be open at once
+    SQLite3ReadingsCursor::Ptr cursor(new SQLite3ReadingsCursor(
+            prepare(compose_readings_sql(sensor, SELECT_READINGS_SQL + " ORDER BY timestamp")), time_converter));
+    bind_sensor(cursor->statement(), sensor);
+
+    return cursor;
+}
+
+ReadingsCursor::Ptr SQLite3Store::get_timeframe_reading_records_cursor(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
+
+    SQLite3ReadingsCursor::Ptr cursor(new SQLite3ReadingsCursor(
+            prepare(compose_readings_sql(sensor, SELECT_TIMEFRAME_READINGS_SQL + " ORDER BY timestamp")), time_converter));
+    sqlite3_stmt* stmt = cursor->statement();
+    bind_sensor(stmt, sensor);
+    sqlite3_bind_int64(stmt, 2, begin);
+    sqlite3_bind_int64(stmt, 3, end);
+
+    return cursor;
+}
+
+readings_t_Ptr SQLite3Store::get_aggregated_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+        const timestamp_t bucket, const aggregate_t function) {
+
+    //Each query scans many readings, the statement is not kept
+    readings_t_Ptr readings;
+    sqlite3_stmt* stmt = prepare(compose_readings_sql(sensor,
+            boost::replace_all_copy(SELECT_AGGREGATED_READINGS_SQL, "$aggregate", compose_aggregate_sql(function))));
+
+    try {
+        bind_sensor(stmt, sensor);
+        sqlite3_bind_int64(stmt, 2, begin);
+        sqlite3_bind_int64(stmt, 3, end);
+        sqlite3_bind_int64(stmt, 4, bucket);
+
+        readings = get_readings_records(stmt);
+
+    } catch (std::exception const& e) {
+        finalize(&stmt);
+        throw;
+    }
+    finalize(&stmt);
+    return readings;
+}
+
 readings_t_Ptr SQLite3Store::get_readings_records(sqlite3_stmt* stmt) {
 
     readings_t_Ptr readings(new readings_t());
@@ -524,7 +881,7 @@ readings_t_Ptr SQLite3Store::get_readings_records(sqlite3_stmt* stmt) {
 
         readings->insert(
                 std::pair<timestamp_t, double>(
-                time_converter->convert_from_epoch(sqlite3_column_int(stmt, 0)),
+                time_converter->convert_from_epoch(sqlite3_column_int64(stmt, 0)),
                 sqlite3_column_double(stmt, 1)
                 ));
     }
@@ -533,13 +890,11 @@ readings_t_Ptr SQLite3Store::get_readings_records(sqlite3_stmt* stmt) {
 
 unsigned long int SQLite3Store::get_num_readings_value(const Sensor::Ptr sensor) {
 
-    int num;
-    std::ostringstream oss;
-    oss << "SELECT count(*) FROM '" << sensor->uuid_string() << "'";
-    sqlite3_stmt* stmt = get_statement(oss.str());
+    unsigned long int num;
+    sqlite3_stmt* stmt = get_sensor_statement(&get_sensor_statements(sensor)->count_readings_stmt, sensor, COUNT_READINGS_SQL);
 
     try {
-        num = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : 0;
+        num = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : 0;
 
     } catch (std::exception const& e) {
         reset(stmt);
@@ -552,15 +907,13 @@ unsigned long int SQLite3Store::get_num_readings_value(const Sensor::Ptr sensor)
 reading_t SQLite3Store::get_last_reading_record(const Sensor::Ptr sensor) {
 
     std::pair<timestamp_t, double> reading;
-    std::ostringstream oss;
-    oss << "SELECT timestamp, value FROM '" << sensor->uuid_string() << "' ORDER BY timestamp DESC LIMIT 1";
-    sqlite3_stmt* stmt = get_statement(oss.str());
+    sqlite3_stmt* stmt = get_sensor_statement(&get_sensor_statements(sensor)->select_last_reading_stmt, sensor, SELECT_LAST_READING_SQL);
 
     try {
         if (sqlite3_step(stmt) == SQLITE_ROW) {
 
             reading = std::pair<timestamp_t, double>(
-                    time_converter->convert_from_epoch(sqlite3_column_int(stmt, 0)),
+                    time_converter->convert_from_epoch(sqlite3_column_int64(stmt, 0)),
                     sqlite3_column_double(stmt, 1)
                     );
         }
@@ -573,20 +926,51 @@ reading_t SQLite3Store::get_last_reading_record(const Sensor::Ptr sensor) {
     return reading;
 }
 
+SensorSummary SQLite3Store::get_sensor_summary_record(const Sensor::Ptr sensor) {
+
+    //Summaries are computed once per sensor, the statement is not kept
+    SensorSummary summary;
+    sqlite3_stmt* stmt = prepare(compose_readings_sql(sensor, SELECT_SUMMARY_SQL));
+
+    try {
+        bind_sensor(stmt, sensor);
+
+        //The aggregates always yield a row, failures must not pass for a sensor without readings
+        execute(stmt, SQLITE_ROW);
+
+        if (sqlite3_column_int64(stmt, 0) > 0) {
+
+            summary = SensorSummary(
+                    sqlite3_column_int64(stmt, 0),
+                    time_converter->convert_from_epoch(sqlite3_column_int64(stmt, 1)),
+                    time_converter->convert_from_epoch(sqlite3_column_int64(stmt, 2)),
+                    sqlite3_column_double(stmt, 6),
+                    sqlite3_column_double(stmt, 3),
+                    sqlite3_column_double(stmt, 4),
+                    sqlite3_column_double(stmt, 5)
+                    );
+        }
+
+    } catch (std::exception const& e) {
+        finalize(&stmt);
+        throw;
+    }
+    finalize(&stmt);
+    return summary;
+}
+
 reading_t SQLite3Store::get_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp) {
 
     std::pair<timestamp_t, double> reading;
-    std::ostringstream oss;
-    oss << "SELECT timestamp, value FROM '" << sensor->uuid_string() << "' WHERE timestamp = ?";
-    sqlite3_stmt* stmt = get_statement(oss.str());
+    sqlite3_stmt* stmt = get_sensor_statement(&get_sensor_statements(sensor)->select_reading_stmt, sensor, SELECT_READING_SQL);
 
     try {
-        sqlite3_bind_int(stmt, 1, timestamp);
+        sqlite3_bind_int64(stmt, 2, timestamp);
 
         if (sqlite3_step(stmt) == SQLITE_ROW) {
 
             reading = std::pair<timestamp_t, double>(
-                    time_converter->convert_from_epoch(sqlite3_column_int(stmt, 0)),
+                    time_converter->convert_from_epoch(sqlite3_column_int64(stmt, 0)),
                     sqlite3_column_double(stmt, 1)
                     );
         }
@@ -601,45 +985,79 @@ reading_t SQLite3Store::get_reading_record(const Sensor::Ptr sensor, const times
 
 void SQLite3Store::add_single_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const bool ignore_errors) {
 
-    add_reading_record(sensor, timestamp, value, "INSERT", ignore_errors);
+    const timestamp_t timestamps[] = {timestamp};
+    const double values[] = {value};
+
+    add_reading_records(sensor, ReadingsSpan(timestamps, values, 1), false, ignore_errors);
 }
 
-void SQLite3Store::add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+void SQLite3Store::add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
 
-    for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
-        add_reading_record(sensor, (*it).first, (*it).second, "INSERT", ignore_errors);
-    }
+    add_reading_records(sensor, readings, false, ignore_errors);
 }
 
-void SQLite3Store::update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+void SQLite3Store::update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
 
-    for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
-        add_reading_record(sensor, (*it).first, (*it).second, "INSERT OR REPLACE", ignore_errors);
-    }
+    add_reading_records(sensor, readings, true, ignore_errors);
 }
 
-void SQLite3Store::add_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const std::string& operation, const bool ignore_errors) {
+void SQLite3Store::add_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool replace, const bool ignore_errors) {
 
-    std::ostringstream oss;
-    oss << operation << " INTO '" << sensor->uuid_string() << "' (timestamp, value) VALUES (?, ?)";
-    sqlite3_stmt* stmt = get_statement(oss.str());
+    size_t offset = 0;
+
+    //Readings are written in chunks of 2^level rows, so that a few cached statements cover any number of readings
+    while (offset < readings.size()) {
+
+        const size_t remaining = readings.size() - offset;
+        size_t level = 0;
+
+        while ((size_t(2) << level) <= std::min(remaining, _max_rows_per_statement)) {
+            level++;
+        }
+
+        const ReadingsSpan chunk = readings.sub(offset, size_t(1) << level);
+        sqlite3_stmt* stmt = get_insert_statement(sensor, replace, level);
+
+        try {
+            add_reading_records(stmt, chunk);
+
+        } catch (std::exception const& e) {
+
+            if (level == 0) {
+                handle_reading_insertion_error(ignore_errors, chunk.timestamp(0), chunk.value(0));
+
+            } else {
+                //A multi-row statement fails as a whole, so the failing readings are looked up one by one
+                for (size_t i = 0; i < chunk.size(); i++) {
+                    add_reading_records(sensor, chunk.sub(i, 1), replace, ignore_errors);
+                }
+            }
+        }
+        offset += chunk.size();
+    }
+}
+
+void SQLite3Store::add_reading_records(sqlite3_stmt* stmt, const ReadingsSpan& readings) {
 
     try {
-        sqlite3_bind_int(stmt, 1, time_converter->convert_to_epoch(timestamp));
-        sqlite3_bind_double(stmt, 2, value);
+        for (size_t i = 0; i < readings.size(); i++) {
+            sqlite3_bind_int64(stmt, 2 * i + 2, time_converter->convert_to_epoch(readings.timestamp(i)));
+            sqlite3_bind_double(stmt, 2 * i + 3, readings.value(i));
+        }
 
         execute(stmt, SQLITE_DONE);
-        reset(stmt);
 
     } catch (std::exception const& e) {
         reset(stmt);
-        handle_reading_insertion_error(ignore_errors, timestamp, value);
+        throw;
     }
+    reset(stmt);
 }
 
 void SQLite3Store::clear_buffers() {
 
     Store::clear_buffers();
+    finalize_sensor_statements();
     _statements.clear();
 }
 
@@ -681,6 +1099,145 @@ sqlite3_stmt *SQLite3Store::get_statement(const std::string& sql) {
     }
 }
 
+SQLite3Store::sensor_statements_t_Ptr SQLite3Store::get_sensor_statements(const Sensor::Ptr sensor) {
+
+    const boost::unordered_map<const Sensor::uuid_t, sensor_statements_t_Ptr>::const_iterator found = _sensor_statements.find(sensor->uuid());
+
+    if (found != _sensor_statements.end()) {
+        return found->second;
+    }
+
+    const sensor_statements_t_Ptr statements(new sensor_statements_t());
+
+    if (_readings_table) {
+
+        sqlite3_stmt* stmt = get_statement("SELECT id FROM sensors WHERE uuid = ?1");
+        sqlite3_bind_text(stmt, 1, sensor->uuid_string().c_str(), -1, SQLITE_TRANSIENT);
+        const bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+
+        if (exists) {
+            statements->sensor_id = sqlite3_column_int64(stmt, 0);
+        }
+        reset(stmt);
+
+        if (!exists) {
+            std::ostringstream oss;
+            oss << "Sensor " << sensor->uuid_string() << " could not be found.";
+            throw StoreException(oss.str());
+        }
+    }
+    _sensor_statements[sensor->uuid()] = statements;
+    return statements;
+}
+
+sqlite3_stmt *SQLite3Store::get_sensor_statement(sqlite3_stmt** stmt, const Sensor::Ptr sensor, const std::string& sql) {
+
+    if (*stmt == NULL) {
+        *stmt = prepare(compose_readings_sql(sensor, sql));
+    }
+    bind_sensor(*stmt, sensor);
+    return *stmt;
+}
+
+const std::string SQLite3Store::compose_readings_sql(const Sensor::Ptr sensor, const std::string& sql) {
+
+    if (_readings_table) {
+        return boost::replace_all_copy(boost::replace_all_copy(sql, "$table", "readings"), "$sensor", "sensor_id = ?1");
+
+    } else {
+        return boost::replace_all_copy(boost::replace_all_copy(sql, "$table", "'" + sensor->uuid_string() + "'"), "$sensor", "1");
+    }
+}
+
+const std::string SQLite3Store::compose_aggregate_sql(const aggregate_t function) {
+
+    switch (function) {
+        case AGGREGATE_AVG:
+            return "avg(value)";
+        case AGGREGATE_MIN:
+            return "min(value)";
+        case AGGREGATE_MAX:
+            return "max(value)";
+        case AGGREGATE_SUM:
+            return "sum(value)";
+        case AGGREGATE_COUNT:
+            return "count(*)";
+        case AGGREGATE_FIRST:
+            //SQLite takes bare columns from the row of the only min() or max() aggregate
+            return "value, min(timestamp)";
+        default:
+            return "value, max(timestamp)";
+    }
+}
+
+void SQLite3Store::bind_sensor(sqlite3_stmt* stmt, const Sensor::Ptr sensor) {
+
+    if (_readings_table) {
+        sqlite3_bind_int64(stmt, 1, get_sensor_statements(sensor)->sensor_id);
+    }
+}
+
+sqlite3_stmt *SQLite3Store::get_insert_statement(const Sensor::Ptr sensor, const bool replace, const size_t level) {
+
+    const sensor_statements_t_Ptr statements = get_sensor_statements(sensor);
+    std::vector<sqlite3_stmt*>& stmts = replace ? statements->replace_readings_stmts : statements->insert_readings_stmts;
+
+    if (stmts.size() <= level) {
+        stmts.resize(level + 1, NULL);
+    }
+
+    if (stmts[level] == NULL) {
+
+        std::ostringstream oss;
+        oss << (replace ? "INSERT OR REPLACE" : "INSERT");
+
+        if (_readings_table) {
+            oss << " INTO readings (sensor_id, timestamp, value) VALUES ";
+        } else {
+            oss << " INTO '" << sensor->uuid_string() << "' (timestamp, value) VALUES ";
+        }
+
+        //The sensor id is ?1, readings are bound from ?2 on
+        for (size_t i = 0; i < (size_t(1) << level); i++) {
+            oss << (i == 0 ? "(" : ", (") << (_readings_table ? "?1, " : "") << "?" << 2 * i + 2 << ", ?" << 2 * i + 3 << ")";
+        }
+        stmts[level] = prepare(oss.str());
+    }
+    bind_sensor(stmts[level], sensor);
+    return stmts[level];
+}
+
+void SQLite3Store::finalize_sensor_statements(const Sensor::uuid_t& uuid) {
+
+    const boost::unordered_map<const Sensor::uuid_t, sensor_statements_t_Ptr>::const_iterator found = _sensor_statements.find(uuid);
+
+    if (found != _sensor_statements.end()) {
+
+        const sensor_statements_t_Ptr statements = found->second;
+        finalize(&statements->select_readings_stmt);
+        finalize(&statements->select_timeframe_readings_stmt);
+        finalize(&statements->count_readings_stmt);
+        finalize(&statements->select_last_reading_stmt);
+        finalize(&statements->select_reading_stmt);
+
+        for (size_t i = 0; i < statements->insert_readings_stmts.size(); i++) {
+            finalize(&statements->insert_readings_stmts[i]);
+        }
+        for (size_t i = 0; i < statements->replace_readings_stmts.size(); i++) {
+            finalize(&statements->replace_readings_stmts[i]);
+        }
+        _sensor_statements.erase(found);
+    }
+}
+
+void SQLite3Store::finalize_sensor_statements() {
+
+    while (!_sensor_statements.empty()) {
+        const Sensor::uuid_t uuid = _sensor_statements.begin()->first;
+        finalize_sensor_statements(uuid);
+    }
+}
+
 int SQLite3Store::execute(sqlite3_stmt *stmt, const int expected_code) {
 
     int rc = sqlite3_step(stmt);
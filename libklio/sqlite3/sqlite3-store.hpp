@@ -25,6 +25,7 @@
 #include <boost/filesystem.hpp>
 #include <libklio/store.hpp>
 #include <libklio/sqlite3/sqlite3-transaction.hpp>
+#include <libklio/sqlite3/sqlite3-readings-cursor.hpp>
 
 
 namespace bfs = boost::filesystem;
@@ -40,12 +41,14 @@ namespace klio {
                 const bool auto_commit,
                 const bool auto_flush,
                 const timestamp_t flush_timeout,
-                const std::string& synchronous
+                const std::string& synchronous,
+                const std::map<const std::string, const std::string>& db_options
                 ) :
         Store(auto_commit, auto_flush, flush_timeout, 10, 10000),
         _path(path),
         _db(NULL),
         _synchronous(synchronous),
+        _db_options(db_options),
         _insert_sensor_stmt(NULL),
         _remove_sensor_stmt(NULL),
         _update_sensor_stmt(NULL),
@@ -53,7 +56,10 @@ namespace klio {
         _select_sensor_by_external_id_stmt(NULL),
         _select_sensor_by_name_stmt(NULL),
         _select_sensors_stmt(NULL),
-        _select_all_sensor_uuids_stmt(NULL) {
+        _select_all_sensor_uuids_stmt(NULL),
+        _readings_table(false),
+        _timestamps_per_second(1),
+        _max_rows_per_statement(1) {
         };
 
         virtual ~SQLite3Store() {
@@ -70,10 +76,55 @@ namespace klio {
         void rotate(bfs::path to_path);
         const std::string str();
 
+        /**
+         * Copies the content of the write-ahead log into the database file
+         * and truncates the log. It has no effect unless the store runs in
+         * WAL journal mode.
+         */
+        void checkpoint();
+
         static const std::string OS_SYNC_OFF;
         static const std::string OS_SYNC_NORMAL;
         static const std::string OS_SYNC_FULL;
 
+        //Database options, applied whenever the database is opened.
+        //Visit: http://www.sqlite.org/pragma.html
+        static const std::string JOURNAL_MODE;
+        static const std::string MMAP_SIZE;
+        static const std::string CACHE_SIZE;
+        static const std::string TEMP_STORE;
+        static const std::string WAL_AUTOCHECKPOINT;
+
+        static const std::string JOURNAL_MODE_DELETE;
+        static const std::string JOURNAL_MODE_WAL;
+
+        /**
+         * Layout of the readings. New stores keep the readings of all
+         * sensors in a single WITHOUT ROWID table, clustered by sensor id
+         * and timestamp. Older stores use a table per sensor, until they
+         * are upgraded. The option only affects new and upgraded stores.
+         */
+        static const std::string SCHEMA;
+        static const std::string SCHEMA_READINGS_TABLE;
+        static const std::string SCHEMA_SENSOR_TABLES;
+
+        const bool readings_table() const {
+            return _readings_table;
+        };
+
+        /**
+         * Resolution of the timestamps, fixed when the store is created.
+         * In millisecond mode, the timestamps of the readings are
+         * milliseconds since the epoch.
+         */
+        static const std::string TIMESTAMP_RESOLUTION;
+        static const std::string TIMESTAMP_RESOLUTION_SECONDS;
+        static const std::string TIMESTAMP_RESOLUTION_MILLISECONDS;
+
+        const timestamp_t timestamps_per_second() const {
+            return _timestamps_per_second;
+        };
+
     protected:
         Transaction::Ptr get_transaction_handler();
 
@@ -81,15 +132,22 @@ namespace klio {
         void remove_sensor_record(const Sensor::Ptr sensor);
         void update_sensor_record(const Sensor::Ptr sensor);
         void add_single_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const bool ignore_errors);
-        void add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors);
-        void update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors);
+        void add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
+        void update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
 
         std::vector<Sensor::Ptr> get_sensor_records();
         readings_t_Ptr get_all_reading_records(const Sensor::Ptr sensor);
         readings_t_Ptr get_timeframe_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end);
         unsigned long int get_num_readings_value(const Sensor::Ptr sensor);
         reading_t get_last_reading_record(const Sensor::Ptr sensor);
+        SensorSummary get_sensor_summary_record(const Sensor::Ptr sensor);
         reading_t get_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp);
+        ReadingsCursor::Ptr get_all_reading_records_cursor(const Sensor::Ptr sensor);
+        ReadingsCursor::Ptr get_timeframe_reading_records_cursor(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end);
+
+        //The readings are aggregated by a GROUP BY query
+        readings_t_Ptr get_aggregated_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+                const timestamp_t bucket, const aggregate_t function);
 
         void clear_buffers();
 
@@ -97,8 +155,34 @@ namespace klio {
         SQLite3Store(const SQLite3Store& original);
         SQLite3Store& operator =(const SQLite3Store& rhs);
 
+        /**
+         * Prepared statements on the readings table of a sensor. They are
+         * prepared when first used. Multi-row insertions are kept per
+         * number of rows, which is always a power of two.
+         */
+        typedef struct {
+            sqlite3_int64 sensor_id;
+            sqlite3_stmt* select_readings_stmt;
+            sqlite3_stmt* select_timeframe_readings_stmt;
+            sqlite3_stmt* count_readings_stmt;
+            sqlite3_stmt* select_last_reading_stmt;
+            sqlite3_stmt* select_reading_stmt;
+            std::vector<sqlite3_stmt*> insert_readings_stmts;
+            std::vector<sqlite3_stmt*> replace_readings_stmts;
+        } sensor_statements_t;
+        typedef boost::shared_ptr<sensor_statements_t> sensor_statements_t_Ptr;
+
         void open_db();
         void close_db();
+        void apply_options();
+        void set_pragma(const std::string& name, const std::string& value);
+        void load_timestamp_resolution();
+        void move_db_files(const bfs::path& to_path);
+        const bool use_readings_table();
+        void create_readings_table();
+        void migrate_sensor_tables();
+        void execute(const std::string& sql);
+        const bool has_wal_content();
         void prepare_statements();
         void finalize_statements();
         SQLite3Transaction::Ptr create_transaction_handler();
@@ -106,11 +190,20 @@ namespace klio {
         const bool has_table(const std::string& name);
         const bool has_column(const std::string& table, const std::string& column);
 
-        void add_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const std::string& operation, const bool ignore_errors);
+        void add_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool replace, const bool ignore_errors);
+        void add_reading_records(sqlite3_stmt* stmt, const ReadingsSpan& readings);
         readings_t_Ptr get_readings_records(sqlite3_stmt* stmt);
 
         sqlite3_stmt *prepare(const std::string& stmt_str);
         sqlite3_stmt *get_statement(const std::string& sql);
+        sensor_statements_t_Ptr get_sensor_statements(const Sensor::Ptr sensor);
+        sqlite3_stmt *get_sensor_statement(sqlite3_stmt** stmt, const Sensor::Ptr sensor, const std::string& sql);
+        const std::string compose_readings_sql(const Sensor::Ptr sensor, const std::string& sql);
+        const std::string compose_aggregate_sql(const aggregate_t function);
+        void bind_sensor(sqlite3_stmt* stmt, const Sensor::Ptr sensor);
+        sqlite3_stmt *get_insert_statement(const Sensor::Ptr sensor, const bool replace, const size_t level);
+        void finalize_sensor_statements(const Sensor::uuid_t& uuid);
+        void finalize_sensor_statements();
         int execute(sqlite3_stmt *stmt, const int expected_code);
         void reset(sqlite3_stmt *stmt);
         void finalize(sqlite3_stmt **stmt);
@@ -120,6 +213,7 @@ namespace klio {
         sqlite3 *_db;
         SQLite3Transaction::Ptr _transaction;
         std::string _synchronous;
+        std::map<const std::string, const std::string> _db_options;
         sqlite3_stmt* _insert_sensor_stmt;
         sqlite3_stmt* _remove_sensor_stmt;
         sqlite3_stmt* _update_sensor_stmt;
@@ -129,6 +223,10 @@ namespace klio {
         sqlite3_stmt* _select_sensors_stmt;
         sqlite3_stmt* _select_all_sensor_uuids_stmt;
         boost::unordered_map<const std::string, sqlite3_stmt*> _statements;
+        boost::unordered_map<const Sensor::uuid_t, sensor_statements_t_Ptr> _sensor_statements;
+        bool _readings_table;
+        timestamp_t _timestamps_per_second;
+        size_t _max_rows_per_statement;
     };
 };
 
@@ -28,7 +28,21 @@ SQLite3Store::Ptr StoreFactory::create_sqlite3_store(
         const timestamp_t flush_timeout,
         const std::string& synchronous) {
 
-    SQLite3Store::Ptr store = SQLite3Store::Ptr(new SQLite3Store(path, auto_commit, auto_flush, flush_timeout, synchronous));
+    std::map<const std::string, const std::string> db_options;
+
+    return create_sqlite3_store(path, prepare, auto_commit, auto_flush, flush_timeout, synchronous, db_options);
+}
+
+SQLite3Store::Ptr StoreFactory::create_sqlite3_store(
+        const bfs::path& path,
+        const bool prepare,
+        const bool auto_commit,
+        const bool auto_flush,
+        const timestamp_t flush_timeout,
+        const std::string& synchronous,
+        const std::map<const std::string, const std::string>& db_options) {
+
+    SQLite3Store::Ptr store = SQLite3Store::Ptr(new SQLite3Store(path, auto_commit, auto_flush, flush_timeout, synchronous, db_options));
     store->open();
     store->initialize();
     if (prepare) {
@@ -49,7 +63,20 @@ SQLite3Store::Ptr StoreFactory::open_sqlite3_store(
         const timestamp_t flush_timeout,
         const std::string& synchronous) {
 
-    SQLite3Store::Ptr store = SQLite3Store::Ptr(new SQLite3Store(path, auto_commit, auto_flush, flush_timeout, synchronous));
+    std::map<const std::string, const std::string> db_options;
+
+    return open_sqlite3_store(path, auto_commit, auto_flush, flush_timeout, synchronous, db_options);
+}
+
+SQLite3Store::Ptr StoreFactory::open_sqlite3_store(
+        const bfs::path& path,
+        const bool auto_commit,
+        const bool auto_flush,
+        const timestamp_t flush_timeout,
+        const std::string& synchronous,
+        const std::map<const std::string, const std::string>& db_options) {
+
+    SQLite3Store::Ptr store = SQLite3Store::Ptr(new SQLite3Store(path, auto_commit, auto_flush, flush_timeout, synchronous, db_options));
     store->open();
     store->check_integrity();
     store->prepare();
@@ -210,6 +237,19 @@ RocksDBStore::Ptr StoreFactory::open_rocksdb_store(const bfs::path& path,
     return store;
 }
 
+RocksDBStore::Ptr StoreFactory::upgrade_rocksdb_store(const bfs::path& path) {
+
+    std::map<const std::string, const std::string> db_options;
+    std::map<const std::string, const std::string> read_options;
+
+    RocksDBStore::Ptr store = RocksDBStore::Ptr(new RocksDBStore(path, true, 600, false, db_options, read_options));
+    store->upgrade();
+    store->open();
+    store->check_integrity();
+    store->prepare();
+    return store;
+}
+
 #endif /* ENABLE_ROCKSDB */
 
 
@@ -243,6 +283,19 @@ RedisStore::Ptr StoreFactory::create_redis_store(
     return store;
 }
 
+RedisStore::Ptr StoreFactory::create_redis_store(
+        const RedisConnectionPool::Ptr pool,
+        const bool auto_commit,
+        const bool auto_flush,
+        const timestamp_t flush_timeout) {
+
+    RedisStore::Ptr store = RedisStore::Ptr(new RedisStore(pool, auto_commit, auto_flush, flush_timeout));
+    store->open();
+    store->initialize();
+    store->prepare();
+    return store;
+}
+
 #endif /* ENABLE_REDIS3M */
 
 #ifdef ENABLE_POSTGRESQL
@@ -270,7 +323,19 @@ PostgreSQLStore::Ptr StoreFactory::create_postgresql_store(
         const timestamp_t flush_timeout,
         const bool synchronous) {
 
-    PostgreSQLStore::Ptr store = PostgreSQLStore::Ptr(new PostgreSQLStore(info, auto_commit, auto_flush, flush_timeout, synchronous));
+    return create_postgresql_store(info, prepare, auto_commit, auto_flush, flush_timeout, synchronous, false);
+}
+
+PostgreSQLStore::Ptr StoreFactory::create_postgresql_store(
+        const std::string& info,
+        const bool prepare,
+        const bool auto_commit,
+        const bool auto_flush,
+        const timestamp_t flush_timeout,
+        const bool synchronous,
+        const bool partitioned) {
+
+    PostgreSQLStore::Ptr store = PostgreSQLStore::Ptr(new PostgreSQLStore(info, auto_commit, auto_flush, flush_timeout, synchronous, partitioned));
     store->open();
     store->initialize();
     if (prepare) {
@@ -68,6 +68,21 @@ namespace klio {
                 const std::string& synchronous
                 );
 
+        /**
+         * Creates a store with database options, see SQLite3Store::JOURNAL_MODE
+         * and the other option names. For instance, journal_mode = WAL lets
+         * readers such as klio-export run without blocking the writer.
+         */
+        SQLite3Store::Ptr create_sqlite3_store(
+                const bfs::path& path,
+                const bool prepare,
+                const bool auto_commit,
+                const bool auto_flush,
+                const timestamp_t flush_timeout,
+                const std::string& synchronous,
+                const std::map<const std::string, const std::string>& db_options
+                );
+
         SQLite3Store::Ptr open_sqlite3_store(const bfs::path& path);
 
         SQLite3Store::Ptr open_sqlite3_store(
@@ -79,6 +94,15 @@ namespace klio {
                 const std::string& synchronous
                 );
 
+        SQLite3Store::Ptr open_sqlite3_store(
+                const bfs::path& path,
+                const bool auto_commit,
+                const bool auto_flush,
+                const timestamp_t flush_timeout,
+                const std::string& synchronous,
+                const std::map<const std::string, const std::string>& db_options
+                );
+
         TXTStore::Ptr create_txt_store(const bfs::path& path);
 
         TXTStore::Ptr create_txt_store(const bfs::path& path, const std::string& field_separator);
@@ -144,6 +168,9 @@ namespace klio {
                 const std::map<const std::string, const std::string>& read_options
                 );
 
+        //Stores of older versions must be upgraded before they can be opened
+        RocksDBStore::Ptr upgrade_rocksdb_store(const bfs::path& path);
+
 #endif /* ENABLE_ROCKSDB */
 
 #ifdef ENABLE_REDIS3M
@@ -165,6 +192,13 @@ namespace klio {
                 const timestamp_t flush_timeout
                 );
 
+        RedisStore::Ptr create_redis_store(
+                const RedisConnectionPool::Ptr pool,
+                const bool auto_commit,
+                const bool auto_flush,
+                const timestamp_t flush_timeout
+                );
+
 #endif /* ENABLE_REDIS3M */
 
 #ifdef ENABLE_POSTGRESQL
@@ -184,6 +218,16 @@ namespace klio {
                 const bool synchronous
                 );
 
+        PostgreSQLStore::Ptr create_postgresql_store(
+                const std::string& info,
+                const bool prepare,
+                const bool auto_commit,
+                const bool auto_flush,
+                const timestamp_t flush_timeout,
+                const bool synchronous,
+                const bool partitioned
+                );
+
 #endif /* ENABLE_POSTGRESQL */
 
     private:
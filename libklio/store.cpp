@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <boost/bind.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <libklio/store.hpp>
 
@@ -11,14 +13,38 @@ const Store::cached_operation_type_t Store::INSERT_OPERATION = 1;
 const Store::cached_operation_type_t Store::UPDATE_OPERATION = 2;
 const Store::cached_operation_type_t Store::DELETE_OPERATION = 3;
 
+/**
+ * Keeps the store locked while the readings of a backend cursor are fetched.
+ */
+class LockedReadingsCursor : public ReadingsCursor {
+public:
+
+    LockedReadingsCursor(boost::recursive_mutex& mutex, const ReadingsCursor::Ptr cursor) :
+    ReadingsCursor(),
+    _lock(mutex),
+    _cursor(cursor) {
+    };
+
+    bool next(reading_t& reading) {
+        return _cursor->next(reading);
+    };
+
+private:
+    //The cursor is released before the lock
+    boost::unique_lock<boost::recursive_mutex> _lock;
+    ReadingsCursor::Ptr _cursor;
+};
+
 void Store::start_transaction() {
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     check_out_commit_off();
     get_transaction_handler()->start();
 }
 
 void Store::commit_transaction() {
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     check_out_commit_off();
     flush_all(_auto_flush);
     get_transaction_handler()->commit();
@@ -26,6 +52,7 @@ void Store::commit_transaction() {
 
 void Store::rollback_transaction() {
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     check_out_commit_off();
     get_transaction_handler()->rollback();
     clear_buffers();
@@ -76,6 +103,7 @@ void Store::add_sensor(const Sensor::Ptr sensor) {
 
     LOG("Adding sensor: " << sensor->str());
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     const Transaction::Ptr transaction = auto_start_transaction();
 
     add_sensor_record(sensor);
@@ -88,6 +116,7 @@ void Store::remove_sensor(const Sensor::Ptr sensor) {
 
     LOG("Removing sensor: " << sensor->str());
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     const Transaction::Ptr transaction = auto_start_transaction();
 
     remove_sensor_record(sensor);
@@ -100,6 +129,7 @@ void Store::update_sensor(const Sensor::Ptr sensor) {
 
     LOG("Updating sensor: " << sensor->str());
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     const Transaction::Ptr transaction = auto_start_transaction();
 
     update_sensor_record(sensor);
@@ -112,9 +142,19 @@ void Store::add_reading(const Sensor::Ptr sensor, const timestamp_t timestamp, c
 
     LOG("Adding to sensor: " << sensor->str() << " time=" << timestamp << " value=" << value);
 
-    klio::readings_t_Ptr cached_readings = get_buffered_readings(sensor, INSERT_OPERATION);
-    cached_readings->insert(reading_t(timestamp, value));
-    auto_flush();
+    const cached_sensor_readings_t_Ptr buffers = get_sensor_buffers(sensor->uuid());
+
+    if (!enqueue_reading(sensor->uuid(), INSERT_OPERATION, timestamp, value)) {
+
+        bool limit_reached;
+        {
+            boost::mutex::scoped_lock lock(buffers->mutex);
+            buffers->operations.at(INSERT_OPERATION)->insert(timestamp, value);
+            mark_dirty(buffers, 1);
+            limit_reached = sensor_limit_reached(buffers);
+        }
+        auto_flush(sensor->uuid(), limit_reached);
+    }
 }
 
 void Store::add_readings(const Sensor::Ptr sensor, const readings_t& readings) {
@@ -124,6 +164,50 @@ void Store::add_readings(const Sensor::Ptr sensor, const readings_t& readings) {
     add_readings(sensor, readings, INSERT_OPERATION);
 }
 
+void Store::add_readings(const sensors_readings_t& readings) {
+
+    LOG("Adding readings of " << readings.size() << " sensors");
+
+    //All sensors are checked before any reading is buffered
+    std::vector<cached_sensor_readings_t_Ptr> buffers;
+    for (sensors_readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
+        buffers.push_back(get_sensor_buffers((*it).first->uuid()));
+    }
+
+    bool buffered = false;
+    bool limit_reached = false;
+    for (size_t i = 0; i < readings.size(); i++) {
+
+        const Sensor::Ptr sensor = readings[i].first;
+
+        if (readings[i].second.empty()) {
+            continue;
+        }
+
+        readings_t unqueued;
+        const readings_t& pending = enqueue_readings(sensor, readings[i].second, INSERT_OPERATION, unqueued) ? unqueued : readings[i].second;
+
+        if (!pending.empty()) {
+            limit_reached = buffer_readings(buffers[i], pending, INSERT_OPERATION) || limit_reached;
+            buffered = true;
+        }
+    }
+
+    //Enqueued readings are flushed by the flush thread
+    if (!buffered) {
+        return;
+    }
+
+    if (limit_reached || store_limit_reached()) {
+
+        boost::recursive_mutex::scoped_lock lock(_mutex);
+        flush_full_buffers();
+
+    } else {
+        auto_flush();
+    }
+}
+
 void Store::update_readings(const Sensor::Ptr sensor, const readings_t& readings) {
 
     LOG("Updating " << readings->size() << " readings of sensor: " << sensor->str());
@@ -131,31 +215,83 @@ void Store::update_readings(const Sensor::Ptr sensor, const readings_t& readings
     add_readings(sensor, readings, UPDATE_OPERATION);
 }
 
+void Store::load_readings(const Sensor::Ptr sensor, const readings_t& readings) {
+
+    LOG("Loading " << readings.size() << " readings of sensor: " << sensor->str());
+
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    const Transaction::Ptr transaction = auto_start_transaction();
+    load_sensor_readings(sensor, readings);
+    auto_commit_transaction(transaction);
+}
+
+void Store::load_readings(const Sensor::Ptr sensor, const readings_t& readings, const timestamp_t timestamps_per_second) {
+
+    if (timestamps_per_second == this->timestamps_per_second()) {
+        load_readings(sensor, readings);
+
+    } else {
+        load_readings(sensor, *convert_timestamps(readings, timestamps_per_second));
+    }
+}
+
 void Store::add_readings(const Sensor::Ptr sensor, const readings_t& readings, const cached_operation_type_t operation_type) {
 
     if (!readings.empty()) {
 
-        klio::readings_t_Ptr cached_readings = get_buffered_readings(sensor, operation_type);
-        for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
-            cached_readings->insert(reading_t((*it).first, (*it).second));
+        const cached_sensor_readings_t_Ptr buffers = get_sensor_buffers(sensor->uuid());
+
+        readings_t unqueued;
+        const readings_t& pending = enqueue_readings(sensor, readings, operation_type, unqueued) ? unqueued : readings;
+
+        if (!pending.empty()) {
+            const bool limit_reached = buffer_readings(buffers, pending, operation_type);
+            auto_flush(sensor->uuid(), limit_reached);
         }
-        auto_flush();
     }
 }
 
-readings_t_Ptr Store::get_buffered_readings(const Sensor::Ptr sensor, const cached_operation_type_t operation_type) {
+const bool Store::buffer_readings(const cached_sensor_readings_t_Ptr buffers, const readings_t& readings, const cached_operation_type_t operation_type) {
 
-    //Check if sensor exists
-    get_sensor(sensor->uuid());
+    boost::mutex::scoped_lock lock(buffers->mutex);
+    buffers->operations.at(operation_type)->insert(readings);
+    mark_dirty(buffers, readings.size());
+    return sensor_limit_reached(buffers);
+}
+
+void Store::mark_dirty(const cached_sensor_readings_t_Ptr buffers, const size_t num_readings) {
+
+    _buffered_readings += num_readings;
 
-    cached_reading_operations_type_t_Ptr cached_operations = _reading_operations_buffer[sensor->uuid()];
-    return cached_operations->at(operation_type);
+    //The sensor lock must be held. Only the first reading after a flush touches the shared set.
+    if (!buffers->dirty) {
+
+        buffers->dirty = true;
+        boost::mutex::scoped_lock lock(_dirty_sensors_mutex);
+        _dirty_sensors.insert(buffers->uuid);
+    }
+}
+
+Store::cached_sensor_readings_t_Ptr Store::get_sensor_buffers(const Sensor::uuid_t& uuid) {
+
+    boost::shared_lock<boost::shared_mutex> lock(_registry_mutex);
+
+    boost::unordered_map<const Sensor::uuid_t, cached_sensor_readings_t_Ptr>::const_iterator found =
+            _reading_operations_buffer.find(uuid);
+
+    if (found == _reading_operations_buffer.end() || _sensors_buffer.count(uuid) == 0) {
+        std::ostringstream err;
+        err << "Sensor " << boost::uuids::to_string(uuid) << " could not be found.";
+        throw StoreException(err.str());
+    }
+    return found->second;
 }
 
 Sensor::Ptr Store::get_sensor(const Sensor::uuid_t& uuid) {
 
     LOG("Getting sensor by UUID: " << uuid);
 
+    boost::shared_lock<boost::shared_mutex> lock(_registry_mutex);
     boost::unordered_map<const Sensor::uuid_t, Sensor::Ptr>::const_iterator found = _sensors_buffer.find(uuid);
 
     if (found == _sensors_buffer.end()) {
@@ -171,6 +307,7 @@ std::vector<Sensor::Ptr> Store::get_sensors() {
 
     LOG("Getting all sensors");
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     return get_sensor_records();
 }
 
@@ -178,11 +315,13 @@ std::vector<Sensor::Ptr> Store::get_sensors_by_external_id(const std::string& ex
 
     LOG("Getting sensors by external id");
 
+    boost::shared_lock<boost::shared_mutex> lock(_registry_mutex);
     std::vector<Sensor::Ptr> sensors;
 
-    if (_external_ids_buffer.count(external_id) > 0) {
-        Sensor::uuid_t uuid = _external_ids_buffer[external_id];
-        sensors.push_back(_sensors_buffer[uuid]);
+    boost::unordered_map<const std::string, Sensor::uuid_t>::const_iterator found = _external_ids_buffer.find(external_id);
+
+    if (found != _external_ids_buffer.end()) {
+        sensors.push_back(_sensors_buffer.at(found->second));
     }
     return sensors;
 }
@@ -191,6 +330,7 @@ std::vector<Sensor::Ptr> Store::get_sensors_by_name(const std::string& name) {
 
     LOG("Getting sensors by name");
 
+    boost::shared_lock<boost::shared_mutex> lock(_registry_mutex);
     std::vector<Sensor::Ptr> sensors;
 
     for (boost::unordered_map<Sensor::uuid_t, Sensor::Ptr>::const_iterator it = _sensors_buffer.begin(); it != _sensors_buffer.end(); ++it) {
@@ -208,6 +348,7 @@ std::vector<Sensor::uuid_t> Store::get_sensor_uuids() {
 
     LOG("Getting sensor UUIDs");
 
+    boost::shared_lock<boost::shared_mutex> lock(_registry_mutex);
     std::vector<Sensor::uuid_t> uuids;
 
     for (boost::unordered_map<Sensor::uuid_t, Sensor::Ptr>::const_iterator it = _sensors_buffer.begin(); it != _sensors_buffer.end(); ++it) {
@@ -220,6 +361,8 @@ readings_t_Ptr Store::get_all_readings(const Sensor::Ptr sensor) {
 
     LOG("Retrieving all readings of sensor " << sensor->str());
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    drain_queue();
     flush(sensor, true);
 
     return get_all_reading_records(sensor);
@@ -229,6 +372,8 @@ readings_t_Ptr Store::get_timeframe_readings(const Sensor::Ptr sensor, const tim
 
     LOG("Retrieving readings of sensor " << sensor->str() << " between " << begin << " and " << end);
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    drain_queue();
     flush(sensor, true);
 
     return get_timeframe_reading_records(sensor, begin, end);
@@ -238,33 +383,184 @@ unsigned long int Store::get_num_readings(const Sensor::Ptr sensor) {
 
     LOG("Retrieving number of readings for sensor " << sensor->str());
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    drain_queue();
     flush(sensor, true);
+    refresh_sensor_summaries();
 
-    return get_num_readings_value(sensor);
+    const boost::unordered_map<const Sensor::uuid_t, SensorSummary>::const_iterator found = _sensor_summaries.find(sensor->uuid());
+    return found == _sensor_summaries.end() ? get_num_readings_value(sensor) : found->second.num_readings();
 }
 
 reading_t Store::get_last_reading(const Sensor::Ptr sensor) {
 
     LOG("Retrieving last reading of sensor " << sensor->str());
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    drain_queue();
     flush(sensor, true);
+    refresh_sensor_summaries();
+
+    const boost::unordered_map<const Sensor::uuid_t, SensorSummary>::const_iterator found = _sensor_summaries.find(sensor->uuid());
+    return found == _sensor_summaries.end() || found->second.empty() ? get_last_reading_record(sensor) : found->second.last_reading();
+}
+
+SensorSummary Store::get_sensor_summary(const Sensor::Ptr sensor) {
+
+    LOG("Retrieving summary of sensor " << sensor->str());
+
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    drain_queue();
+    flush(sensor, true);
+    refresh_sensor_summaries();
+
+    const boost::unordered_map<const Sensor::uuid_t, SensorSummary>::const_iterator found = _sensor_summaries.find(sensor->uuid());
+
+    if (found != _sensor_summaries.end()) {
+        return found->second;
+    }
+
+    const SensorSummary summary = get_sensor_summary_record(sensor);
+    _sensor_summaries.insert(std::pair<const Sensor::uuid_t, SensorSummary>(sensor->uuid(), summary));
+    return summary;
+}
+
+readings_t_Ptr Store::get_aggregated_readings(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+        const timestamp_t bucket, const aggregate_t function) {
+
+    LOG("Aggregating readings of sensor " << sensor->str() << " between " << begin << " and " << end);
+
+    if (bucket <= 0) {
+        throw StoreException("The aggregation interval must be positive.");
+    }
+
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    drain_queue();
+    flush(sensor, true);
+
+    return get_aggregated_reading_records(sensor, begin, end, bucket, function);
+}
+
+readings_t_Ptr Store::get_aggregated_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+        const timestamp_t bucket, const aggregate_t function) {
+
+    readings_t_Ptr aggregated = readings_t_Ptr(new readings_t());
+    const ReadingsCursor::Ptr cursor = get_timeframe_reading_records_cursor(sensor, begin, end);
+    reading_t reading;
+    timestamp_t interval = 0;
+    double value = 0;
+    unsigned long int count = 0;
+
+    while (cursor->next(reading)) {
+
+        //Intervals start at multiples of the bucket, also for timestamps before the epoch
+        timestamp_t start = reading.first - reading.first % bucket;
+        if (reading.first % bucket < 0) {
+            start -= bucket;
+        }
+
+        if (count > 0 && start != interval) {
+            (*aggregated)[interval] = complete_aggregate(function, value, count);
+            count = 0;
+        }
+
+        if (count == 0) {
+            interval = start;
+            value = reading.second;
+
+        } else if (function == AGGREGATE_AVG || function == AGGREGATE_SUM) {
+            value += reading.second;
+
+        } else if (function == AGGREGATE_MIN) {
+            value = std::min(value, reading.second);
+
+        } else if (function == AGGREGATE_MAX) {
+            value = std::max(value, reading.second);
+
+        } else if (function == AGGREGATE_LAST) {
+            value = reading.second;
+        }
+        count++;
+    }
+
+    if (count > 0) {
+        (*aggregated)[interval] = complete_aggregate(function, value, count);
+    }
+    return aggregated;
+}
+
+const double Store::complete_aggregate(const aggregate_t function, const double value, const unsigned long int count) {
+
+    if (function == AGGREGATE_AVG) {
+        return value / count;
+
+    } else if (function == AGGREGATE_COUNT) {
+        return count;
+    }
+    return value;
+}
+
+SensorSummary Store::get_sensor_summary_record(const Sensor::Ptr sensor) {
+
+    SensorSummary summary;
+    const ReadingsCursor::Ptr cursor = get_all_reading_records_cursor(sensor);
+    reading_t reading;
 
-    return get_last_reading_record(sensor);
+    while (cursor->next(reading)) {
+        summary.add(reading.first, reading.second);
+    }
+    return summary;
 }
 
 reading_t Store::get_reading(const Sensor::Ptr sensor, const timestamp_t timestamp) {
 
     LOG("Retrieving reading of sensor " << sensor->str());
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    drain_queue();
     flush(sensor, true);
 
     return get_reading_record(sensor, timestamp);
 }
 
+ReadingsCursor::Ptr Store::get_all_readings_cursor(const Sensor::Ptr sensor) {
+
+    LOG("Opening cursor on all readings of sensor " << sensor->str());
+
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    drain_queue();
+    flush(sensor, true);
+
+    return ReadingsCursor::Ptr(new LockedReadingsCursor(_mutex, get_all_reading_records_cursor(sensor)));
+}
+
+ReadingsCursor::Ptr Store::get_timeframe_readings_cursor(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
+
+    LOG("Opening cursor on readings of sensor " << sensor->str() << " between " << begin << " and " << end);
+
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    drain_queue();
+    flush(sensor, true);
+
+    return ReadingsCursor::Ptr(new LockedReadingsCursor(_mutex, get_timeframe_reading_records_cursor(sensor, begin, end)));
+}
+
+ReadingsCursor::Ptr Store::get_all_reading_records_cursor(const Sensor::Ptr sensor) {
+
+    //By default, readings are loaded at once
+    return ReadingsCursor::Ptr(new MapReadingsCursor(get_all_reading_records(sensor)));
+}
+
+ReadingsCursor::Ptr Store::get_timeframe_reading_records_cursor(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end) {
+
+    return ReadingsCursor::Ptr(new MapReadingsCursor(get_timeframe_reading_records(sensor, begin, end)));
+}
+
 void Store::sync(const Store::Ptr store) {
 
     LOG("Synchronizing this store with store " << store->str());
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     const std::vector<Sensor::Ptr> sensors = store->get_sensors();
     const Transaction::Ptr transaction = auto_start_transaction();
 
@@ -278,6 +574,7 @@ void Store::sync_readings(const Sensor::Ptr sensor, const Store::Ptr store) {
 
     LOG("Synchronizing this store readings with the readings of sensor " << sensor->str() << " from store " << store->str());
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     const Transaction::Ptr transaction = auto_start_transaction();
     sync_reading_records(sensor, store);
     auto_commit_transaction(transaction);
@@ -287,6 +584,7 @@ void Store::sync_sensors(const Store::Ptr store) {
 
     LOG("Synchronizing this store sensors with the sensors of store " << store->str());
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     const std::vector<Sensor::Ptr> sensors = store->get_sensors();
     const Transaction::Ptr transaction = auto_start_transaction();
 
@@ -297,12 +595,63 @@ void Store::sync_sensors(const Store::Ptr store) {
     auto_commit_transaction(transaction);
 }
 
+const timestamp_t Store::timestamps_per_second() const {
+
+    return 1;
+}
+
 void Store::sync_reading_records(const Sensor::Ptr sensor, const Store::Ptr store) {
 
     readings_t_Ptr readings = store->get_all_readings(sensor);
+
+    if (store->timestamps_per_second() != timestamps_per_second()) {
+        readings = convert_timestamps(*readings, store->timestamps_per_second());
+    }
     Sensor::Ptr local_sensor = sync_sensor_record(sensor);
     set_buffers(local_sensor);
-    add_readings(local_sensor, *readings, UPDATE_OPERATION);
+    load_sensor_readings(local_sensor, *readings);
+}
+
+readings_t_Ptr Store::convert_timestamps(const readings_t& readings, const timestamp_t timestamps_per_second) {
+
+    //Coarser timestamps would merge readings, finer ones are multiplied
+    if (timestamps_per_second <= 0 || this->timestamps_per_second() % timestamps_per_second != 0) {
+        std::ostringstream oss;
+        oss << "Timestamps with a resolution of " << timestamps_per_second << " per second can not be stored in "
+                << str() << ", which has a resolution of " << this->timestamps_per_second() << " per second.";
+        throw StoreException(oss.str());
+    }
+
+    const timestamp_t factor = this->timestamps_per_second() / timestamps_per_second;
+    readings_t_Ptr converted(new readings_t());
+
+    for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
+        converted->insert(converted->end(), reading_t(it->first * factor, it->second));
+    }
+    return converted;
+}
+
+void Store::load_sensor_readings(const Sensor::Ptr sensor, const readings_t& readings) {
+
+    //Readings added before are written first, so that the loaded ones replace them
+    drain_queue();
+    flush(sensor, false);
+
+    if (readings.empty()) {
+        return;
+    }
+
+    ReadingsBuffer buffer;
+    buffer.insert(readings);
+
+    try {
+        load_reading_records(sensor, buffer.span(), false);
+
+    } catch (std::exception const& e) {
+        _sensor_summaries.erase(sensor->uuid());
+        throw;
+    }
+    update_sensor_summary(sensor->uuid(), buffer.span());
 }
 
 Sensor::Ptr Store::sync_sensor_record(const Sensor::Ptr sensor) {
@@ -342,6 +691,7 @@ Sensor::Ptr Store::sync_sensor_record(const Sensor::Ptr sensor) {
 
 void Store::prepare() {
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
     std::vector<Sensor::Ptr> sensors = get_sensor_records();
     for (std::vector<Sensor::Ptr>::const_iterator sensor = sensors.begin(); sensor != sensors.end(); ++sensor) {
         set_buffers(*sensor);
@@ -355,6 +705,9 @@ void Store::flush() {
 
 void Store::flush(bool ignore_errors) {
 
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    drain_queue();
+
     const Transaction::Ptr transaction = auto_start_transaction();
     flush_all(ignore_errors);
     auto_commit_transaction(transaction);
@@ -362,89 +715,584 @@ void Store::flush(bool ignore_errors) {
 
 void Store::auto_flush() {
 
+    if (!_auto_flush) {
+        return;
+    }
+
+    //Only the caller that claims the flush takes the store lock, the others return at once
     const timestamp_t now = time_converter->get_timestamp();
+    timestamp_t last_flush;
 
-    if (_auto_flush && now - _last_flush >= _flush_timeout) {
+    if (!claim_flush(now, last_flush)) {
+        return;
+    }
 
+    //Writers never wait for the store, a busy store is flushed by a later caller
+    boost::unique_lock<boost::recursive_mutex> lock(_mutex, boost::try_to_lock);
+
+    if (!lock.owns_lock()) {
+        release_flush(now, last_flush);
+        return;
+    }
+
+    try {
         const Transaction::Ptr transaction = auto_start_transaction();
         flush_all(true);
         auto_commit_transaction(transaction);
-        _last_flush = now;
+
+    } catch (std::exception const& e) {
+        release_flush(now, last_flush);
+        throw;
+    }
+}
+
+const bool Store::claim_flush(const timestamp_t now, timestamp_t& last_flush) {
+
+    boost::mutex::scoped_lock lock(_last_flush_mutex);
+
+    if (now - _last_flush < _flush_timeout) {
+        return false;
+    }
+    last_flush = _last_flush;
+    _last_flush = now;
+    return true;
+}
+
+void Store::release_flush(const timestamp_t now, const timestamp_t last_flush) {
+
+    boost::mutex::scoped_lock lock(_last_flush_mutex);
+
+    //The flush is due again, unless another caller has flushed meanwhile
+    if (_last_flush == now) {
+        _last_flush = last_flush;
+    }
+}
+
+void Store::auto_flush(const Sensor::uuid_t& uuid, const bool sensor_limit_reached) {
+
+    if (store_limit_reached()) {
+
+        boost::recursive_mutex::scoped_lock lock(_mutex);
+
+        if (store_limit_reached()) {
+
+            const Transaction::Ptr transaction = auto_start_transaction();
+            flush_all(true);
+            auto_commit_transaction(transaction);
+        }
+
+    } else if (sensor_limit_reached) {
+
+        boost::recursive_mutex::scoped_lock lock(_mutex);
+
+        const Transaction::Ptr transaction = auto_start_transaction();
+        flush(get_sensor(uuid), true);
+        auto_commit_transaction(transaction);
+
+    } else {
+        auto_flush();
+    }
+}
+
+void Store::flush_full_buffers() {
+
+    if (store_limit_reached()) {
+
+        const Transaction::Ptr transaction = auto_start_transaction();
+        flush_all(true);
+        auto_commit_transaction(transaction);
+        return;
+    }
+
+    if (_max_sensor_buffered_readings == 0 && _max_sensor_buffered_bytes == 0) {
+        return;
+    }
+
+    std::vector<Sensor::uuid_t> uuids;
+    {
+        boost::mutex::scoped_lock lock(_dirty_sensors_mutex);
+        uuids.assign(_dirty_sensors.begin(), _dirty_sensors.end());
+    }
+
+    std::vector<Sensor::Ptr> sensors;
+    {
+        boost::shared_lock<boost::shared_mutex> lock(_registry_mutex);
+
+        for (std::vector<Sensor::uuid_t>::const_iterator it = uuids.begin(); it != uuids.end(); ++it) {
+
+            boost::unordered_map<const Sensor::uuid_t, cached_sensor_readings_t_Ptr>::const_iterator found = _reading_operations_buffer.find(*it);
+
+            if (found != _reading_operations_buffer.end()) {
+
+                boost::mutex::scoped_lock sensor_lock(found->second->mutex);
+                if (sensor_limit_reached(found->second)) {
+                    sensors.push_back(_sensors_buffer.at(*it));
+                }
+            }
+        }
+    }
+
+    if (!sensors.empty()) {
+
+        const Transaction::Ptr transaction = auto_start_transaction();
+        flush_sensors(sensors, true);
+        auto_commit_transaction(transaction);
     }
 }
 
+const bool Store::sensor_limit_reached(const cached_sensor_readings_t_Ptr buffers) {
+
+    if (_max_sensor_buffered_readings == 0 && _max_sensor_buffered_bytes == 0) {
+        return false;
+    }
+
+    const ReadingsBuffer::Ptr inserts = buffers->operations.at(INSERT_OPERATION);
+    const ReadingsBuffer::Ptr updates = buffers->operations.at(UPDATE_OPERATION);
+
+    return (_max_sensor_buffered_readings > 0 && inserts->size() + updates->size() >= _max_sensor_buffered_readings) ||
+            (_max_sensor_buffered_bytes > 0 && inserts->bytes() + updates->bytes() >= _max_sensor_buffered_bytes);
+}
+
+const bool Store::store_limit_reached() {
+
+    const unsigned long int buffered = _buffered_readings;
+
+    return (_max_buffered_readings > 0 && buffered >= _max_buffered_readings) ||
+            (_max_buffered_bytes > 0 && buffered * (sizeof (timestamp_t) + sizeof (double)) >= _max_buffered_bytes);
+}
+
 void Store::flush_all(bool ignore_errors) {
 
-    for (boost::unordered_map<Sensor::uuid_t, Sensor::Ptr>::const_iterator it = _sensors_buffer.begin(); it != _sensors_buffer.end(); ++it) {
-        flush((*it).second, ignore_errors);
+    std::vector<Sensor::uuid_t> uuids;
+    {
+        boost::mutex::scoped_lock lock(_dirty_sensors_mutex);
+        uuids.assign(_dirty_sensors.begin(), _dirty_sensors.end());
+        _dirty_sensors.clear();
+    }
+
+    std::vector<Sensor::Ptr> sensors;
+    {
+        boost::shared_lock<boost::shared_mutex> lock(_registry_mutex);
+
+        for (std::vector<Sensor::uuid_t>::const_iterator it = uuids.begin(); it != uuids.end(); ++it) {
+
+            boost::unordered_map<const Sensor::uuid_t, Sensor::Ptr>::const_iterator found = _sensors_buffer.find(*it);
+            if (found != _sensors_buffer.end()) {
+                sensors.push_back(found->second);
+            }
+        }
+    }
+
+    try {
+        flush_sensors(sensors, ignore_errors);
+
+    } catch (std::exception const& e) {
+
+        //Sensors that were not flushed remain dirty
+        boost::mutex::scoped_lock lock(_dirty_sensors_mutex);
+        for (std::vector<Sensor::Ptr>::const_iterator it = sensors.begin(); it != sensors.end(); ++it) {
+            _dirty_sensors.insert((*it)->uuid());
+        }
+        throw;
     }
 }
 
 void Store::flush(const Sensor::Ptr sensor, bool ignore_errors) {
 
-    boost::unordered_map<const Sensor::uuid_t, cached_reading_operations_type_t_Ptr>::const_iterator found =
-            _reading_operations_buffer.find(sensor->uuid());
+    flush_sensors(std::vector<Sensor::Ptr>(1, sensor), ignore_errors);
+}
 
-    if (found == _reading_operations_buffer.end()) {
-        std::ostringstream err;
-        err << "Sensor " << sensor->uuid_string() << " could not be found.";
-        throw StoreException(err.str());
+void Store::flush_sensors(const std::vector<Sensor::Ptr>& sensors, bool ignore_errors) {
+
+    std::vector<cached_sensor_readings_t_Ptr> buffers;
+    {
+        boost::shared_lock<boost::shared_mutex> lock(_registry_mutex);
+
+        for (std::vector<Sensor::Ptr>::const_iterator it = sensors.begin(); it != sensors.end(); ++it) {
+
+            boost::unordered_map<const Sensor::uuid_t, cached_sensor_readings_t_Ptr>::const_iterator found =
+                    _reading_operations_buffer.find((*it)->uuid());
+
+            if (found == _reading_operations_buffer.end()) {
+                std::ostringstream err;
+                err << "Sensor " << (*it)->uuid_string() << " could not be found.";
+                throw StoreException(err.str());
+            }
+            buffers.push_back(found->second);
+        }
     }
 
-    readings_t_Ptr readings = found->second->at(INSERT_OPERATION);
+    //Only the flushed sensors are locked, readings of other sensors can still be added.
+    //No other thread holds more than one sensor lock, so they can be taken in any order.
+    std::vector<boost::shared_ptr<boost::mutex::scoped_lock> > locks;
+    std::vector<size_t> dirty;
+    std::vector<size_t> num_readings;
+
+    for (size_t i = 0; i < buffers.size(); i++) {
+
+        locks.push_back(boost::shared_ptr<boost::mutex::scoped_lock>(new boost::mutex::scoped_lock(buffers[i]->mutex)));
 
-    //Small number of insertions
-    if (readings->size() <= _min_bulk_size) {
+        if (buffers[i]->dirty) {
 
-        for (readings_cit_t it = readings->begin(); it != readings->end(); ++it) {
-            add_single_reading_record(sensor, (*it).first, (*it).second, ignore_errors);
+            const ReadingsBuffer::Ptr readings = buffers[i]->operations.at(INSERT_OPERATION);
+            num_readings.push_back(readings->size());
+            readings->compact();
+            dirty.push_back(i);
         }
+    }
 
-        //Bulk insertion
-    } else {
+    try {
+        //The insertions of all sensors are written in batches of at most _max_bulk_size readings
+        sensors_readings_spans_t batch;
+        size_t batch_size = 0;
+        boost::unordered_set<Sensor::uuid_t> unwritten;
+
+        for (std::vector<size_t>::const_iterator it = dirty.begin(); it != dirty.end(); ++it) {
+
+            const ReadingsBuffer::Ptr readings = buffers[*it]->operations.at(INSERT_OPERATION);
+            size_t offset = 0;
+
+            while (offset < readings->size()) {
+
+                const size_t length = std::min<size_t>(_max_bulk_size - batch_size, readings->size() - offset);
+                batch.push_back(sensor_readings_span_t(sensors[*it], readings->span(offset, length)));
+                batch_size += length;
+                offset += length;
+
+                if (batch_size >= _max_bulk_size) {
+                    write_batch(batch, ignore_errors, unwritten);
+                    batch.clear();
+                    batch_size = 0;
+                }
+            }
+        }
+
+        if (!batch.empty()) {
+            write_batch(batch, ignore_errors, unwritten);
+        }
+
+        for (size_t i = 0; i < dirty.size(); i++) {
+
+            const Sensor::Ptr sensor = sensors[dirty[i]];
+            const cached_sensor_readings_t_Ptr sensor_buffers = buffers[dirty[i]];
+
+            const ReadingsBuffer::Ptr insertions = sensor_buffers->operations.at(INSERT_OPERATION);
+            if (unwritten.count(sensor->uuid()) > 0) {
+                _sensor_summaries.erase(sensor->uuid());
+            } else {
+                update_sensor_summary(sensor->uuid(), insertions->span());
+            }
+            insertions->clear();
+            _buffered_readings -= num_readings[i];
+
+            const ReadingsBuffer::Ptr readings = sensor_buffers->operations.at(UPDATE_OPERATION);
+            if (!readings->empty()) {
+                const size_t num_updates = readings->size();
+                readings->compact();
+                update_reading_records(sensor, readings->span(), ignore_errors);
+                readings->clear();
+                _buffered_readings -= num_updates;
+
+                //Updates may replace counted readings
+                _sensor_summaries.erase(sensor->uuid());
+            }
+            sensor_buffers->dirty = false;
+        }
+
+    } catch (std::exception const& e) {
+
+        //Some readings may have been written, the summaries are computed again when requested
+        for (std::vector<size_t>::const_iterator it = dirty.begin(); it != dirty.end(); ++it) {
+            _sensor_summaries.erase(sensors[*it]->uuid());
+        }
+        throw;
+    }
+}
+
+void Store::write_batch(const sensors_readings_spans_t& batch, const bool ignore_errors, boost::unordered_set<Sensor::uuid_t>& unwritten) {
+
+    const unsigned long int errors = _insertion_errors;
+    add_batch_reading_records(batch, ignore_errors);
+
+    //Ignored errors may have left readings of any sensor of the batch unwritten
+    if (_insertion_errors != errors) {
+        for (sensors_readings_spans_cit_t it = batch.begin(); it != batch.end(); ++it) {
+            unwritten.insert((*it).first->uuid());
+        }
+    }
+}
+
+void Store::update_sensor_summary(const Sensor::uuid_t& uuid, const ReadingsSpan& readings) {
+
+    const boost::unordered_map<const Sensor::uuid_t, SensorSummary>::iterator found = _sensor_summaries.find(uuid);
+
+    if (found != _sensor_summaries.end()) {
+
+        if (found->second.appendable(readings)) {
+            found->second.add(readings);
+
+        } else {
+            _sensor_summaries.erase(found);
+        }
+    }
+}
+
+void Store::load_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
+
+    for (size_t offset = 0; offset < readings.size(); offset += _max_bulk_size) {
+        update_reading_records(sensor, readings.sub(offset, _max_bulk_size), ignore_errors);
+    }
+}
+
+void Store::add_batch_reading_records(const sensors_readings_spans_t& readings, const bool ignore_errors) {
+
+    for (sensors_readings_spans_cit_t it = readings.begin(); it != readings.end(); ++it) {
+
+        const Sensor::Ptr sensor = (*it).first;
+        const ReadingsSpan& span = (*it).second;
+
+        //Small number of insertions
+        if (span.size() <= _min_bulk_size) {
+
+            for (size_t i = 0; i < span.size(); i++) {
+                add_single_reading_record(sensor, span.timestamp(i), span.value(i), ignore_errors);
+            }
+
+            //Bulk insertion
+        } else {
+            add_bulk_reading_records(sensor, span, ignore_errors);
+        }
+    }
+}
+
+void Store::start_async_flush(const size_t high_water_mark, const bool block_when_full) {
+
+    if (!_auto_commit) {
+        std::ostringstream oss;
+        oss << "Asynchronous flushing requires the store to perform commits automatically.";
+        throw StoreException(oss.str());
+    }
 
-        readings_cit_t reading = readings->begin();
-        readings_t_Ptr bulk(new readings_t());
-        int bulks = (int) ceil(((double) readings->size()) / ((double) _max_bulk_size));
+    if (high_water_mark == 0) {
+        std::ostringstream oss;
+        oss << "The high-water mark of the readings queue must be greater than zero.";
+        throw StoreException(oss.str());
+    }
+
+    boost::mutex::scoped_lock lock(_queue_mutex);
+
+    if (_async_flush) {
+        std::ostringstream oss;
+        oss << "Asynchronous flushing is already enabled.";
+        throw StoreException(oss.str());
+    }
+
+    _high_water_mark = high_water_mark;
+    _block_when_full = block_when_full;
+    _stop_flush_thread = false;
+    _async_flush = true;
+    _flush_thread = boost::shared_ptr<boost::thread>(new boost::thread(boost::bind(&Store::run_flush_thread, this)));
+}
+
+void Store::stop_async_flush() {
+
+    {
+        boost::mutex::scoped_lock lock(_queue_mutex);
+
+        if (!_async_flush) {
+            return;
+        }
+        //Readings added from now on are buffered synchronously
+        _async_flush = false;
+        _stop_flush_thread = true;
+    }
+    _queue_not_empty.notify_all();
+    _queue_not_full.notify_all();
+
+    _flush_thread->join();
+    _flush_thread.reset();
+
+    //Move the remaining readings to the database. Errors are only logged,
+    //because this method is invoked when the store is closed.
+    try {
+        flush(true);
+
+    } catch (std::exception const& e) {
+        LOG("Final asynchronous flush failed: " << e.what());
+    }
+}
+
+const bool Store::async_flush() {
+
+    boost::mutex::scoped_lock lock(_queue_mutex);
+    return _async_flush;
+}
+
+const unsigned long int Store::num_dropped_readings() {
+
+    boost::mutex::scoped_lock lock(_queue_mutex);
+    return _dropped_readings;
+}
+
+bool Store::enqueue_readings(const Sensor::Ptr sensor, const readings_t& readings, const cached_operation_type_t operation_type, readings_t& unqueued) {
+
+    boost::mutex::scoped_lock lock(_queue_mutex);
+
+    if (!_async_flush) {
+        return false;
+    }
+
+    for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
+
+        const queue_space_t space = wait_for_queue_space(lock);
 
-        while (bulks-- > 0) {
+        if (space == QUEUE_SPACE) {
+            const queued_reading_t queued = {sensor->uuid(), operation_type, (*it).first, (*it).second};
+            _queue.push_back(queued);
+
+        } else if (space == QUEUE_STOPPED) {
+            //The final flush may already have drained the queue, the caller buffers the rest
+            unqueued.insert(it, readings.end());
+            break;
+        }
+    }
+
+    if (_queue.size() >= _high_water_mark / 2) {
+        _queue_not_empty.notify_one();
+    }
+    return true;
+}
+
+bool Store::enqueue_reading(const Sensor::uuid_t& uuid, const cached_operation_type_t operation_type, const timestamp_t timestamp, const double value) {
+
+    boost::mutex::scoped_lock lock(_queue_mutex);
+
+    if (!_async_flush) {
+        return false;
+    }
+
+    const queue_space_t space = wait_for_queue_space(lock);
+
+    if (space == QUEUE_STOPPED) {
+        return false;
+    }
+
+    if (space == QUEUE_SPACE) {
+        const queued_reading_t queued = {uuid, operation_type, timestamp, value};
+        _queue.push_back(queued);
+
+        if (_queue.size() >= _high_water_mark / 2) {
+            _queue_not_empty.notify_one();
+        }
+    }
+    return true;
+}
 
-            while (reading != readings->end() && bulk->size() < _max_bulk_size) {
-                bulk->insert(*reading);
-                reading++;
+Store::queue_space_t Store::wait_for_queue_space(boost::mutex::scoped_lock& lock) {
+
+    while (_async_flush && _queue.size() >= _high_water_mark) {
+
+        if (!_block_when_full) {
+            _dropped_readings++;
+            LOG("The readings queue is full. Dropping reading.");
+            return QUEUE_FULL;
+        }
+        _queue_not_empty.notify_one();
+        _queue_not_full.wait(lock);
+    }
+
+    //Asynchronous flushing was stopped while waiting
+    return _async_flush ? QUEUE_SPACE : QUEUE_STOPPED;
+}
+
+void Store::run_flush_thread() {
+
+    const boost::posix_time::seconds period(_flush_timeout > 0 ? _flush_timeout : 1);
+
+    while (true) {
+        {
+            boost::mutex::scoped_lock lock(_queue_mutex);
+
+            //Wake up when the queue fills up or, at the latest, once per flush period
+            if (!_stop_flush_thread && (_queue.empty() || _queue.size() < _high_water_mark / 2)) {
+                _queue_not_empty.timed_wait(lock, period);
+            }
+            if (_stop_flush_thread) {
+                return;
             }
-            add_bulk_reading_records(sensor, *bulk, ignore_errors);
-            bulk->clear();
         }
+
+        try {
+            boost::recursive_mutex::scoped_lock lock(_mutex);
+            drain_queue();
+            flush_full_buffers();
+            auto_flush();
+
+        } catch (std::exception const& e) {
+            LOG("Asynchronous flush failed: " << e.what());
+        }
+    }
+}
+
+void Store::drain_queue() {
+
+    std::deque<queued_reading_t> queued;
+    {
+        boost::mutex::scoped_lock lock(_queue_mutex);
+        queued.swap(_queue);
     }
-    readings->clear();
+    _queue_not_full.notify_all();
+
+    boost::shared_lock<boost::shared_mutex> lock(_registry_mutex);
 
-    readings = found->second->at(UPDATE_OPERATION);
-    if (readings->size() > 0) {
-        update_reading_records(sensor, *readings, ignore_errors);
-        readings->clear();
+    for (std::deque<queued_reading_t>::const_iterator it = queued.begin(); it != queued.end(); ++it) {
+
+        boost::unordered_map<const Sensor::uuid_t, cached_sensor_readings_t_Ptr>::const_iterator found =
+                _reading_operations_buffer.find((*it).uuid);
+
+        if (found == _reading_operations_buffer.end()) {
+            LOG("Sensor " << boost::uuids::to_string((*it).uuid) << " could not be found. Dropping reading.");
+        } else {
+            boost::mutex::scoped_lock sensor_lock(found->second->mutex);
+            found->second->operations.at((*it).operation)->insert((*it).timestamp, (*it).value);
+            mark_dirty(found->second, 1);
+        }
     }
 }
 
 void Store::set_buffers(const Sensor::Ptr sensor) {
 
+    boost::unique_lock<boost::shared_mutex> lock(_registry_mutex);
+
     if (_external_ids_buffer.count(sensor->external_id()) > 0) {
 
         Sensor::uuid_t other_uuid = _external_ids_buffer[sensor->external_id()];
         _sensors_buffer.erase(other_uuid);
 
         if (_reading_operations_buffer.count(other_uuid) > 0) {
-            _reading_operations_buffer[sensor->uuid()] = _reading_operations_buffer[other_uuid];
+
+            cached_sensor_readings_t_Ptr buffers = _reading_operations_buffer[other_uuid];
             _reading_operations_buffer.erase(other_uuid);
+            _reading_operations_buffer[sensor->uuid()] = buffers;
+
+            boost::mutex::scoped_lock sensor_lock(buffers->mutex);
+            buffers->uuid = sensor->uuid();
+
+            if (buffers->dirty) {
+                boost::mutex::scoped_lock dirty_lock(_dirty_sensors_mutex);
+                _dirty_sensors.insert(buffers->uuid);
+            }
         }
     }
 
     if (_reading_operations_buffer.count(sensor->uuid()) == 0) {
 
-        cached_reading_operations_type_t_Ptr cached_operations = cached_reading_operations_type_t_Ptr(new cached_reading_operations_type_t());
-        cached_operations->insert(cached_readings_type_t(INSERT_OPERATION, readings_t_Ptr(new readings_t())));
-        cached_operations->insert(cached_readings_type_t(UPDATE_OPERATION, readings_t_Ptr(new readings_t())));
-        _reading_operations_buffer[sensor->uuid()] = cached_operations;
+        cached_sensor_readings_t_Ptr buffers = cached_sensor_readings_t_Ptr(new cached_sensor_readings_t());
+        buffers->operations.insert(cached_readings_type_t(INSERT_OPERATION, ReadingsBuffer::Ptr(new ReadingsBuffer())));
+        buffers->operations.insert(cached_readings_type_t(UPDATE_OPERATION, ReadingsBuffer::Ptr(new ReadingsBuffer())));
+        buffers->uuid = sensor->uuid();
+        buffers->dirty = false;
+        _reading_operations_buffer[sensor->uuid()] = buffers;
     }
 
     _sensors_buffer[sensor->uuid()] = sensor;
@@ -453,16 +1301,53 @@ void Store::set_buffers(const Sensor::Ptr sensor) {
 
 void Store::clear_buffers(const Sensor::Ptr sensor) {
 
+    boost::unique_lock<boost::shared_mutex> lock(_registry_mutex);
     _sensors_buffer.erase(sensor->uuid());
     _external_ids_buffer.erase(sensor->external_id());
-    _reading_operations_buffer.erase(sensor->uuid());
+    _sensor_summaries.erase(sensor->uuid());
+
+    boost::unordered_map<const Sensor::uuid_t, cached_sensor_readings_t_Ptr>::const_iterator found =
+            _reading_operations_buffer.find(sensor->uuid());
+
+    if (found != _reading_operations_buffer.end()) {
+
+        const cached_sensor_readings_t_Ptr buffers = found->second;
+        _reading_operations_buffer.erase(found);
+
+        boost::mutex::scoped_lock sensor_lock(buffers->mutex);
+        _buffered_readings -= buffers->operations.at(INSERT_OPERATION)->size() + buffers->operations.at(UPDATE_OPERATION)->size();
+    }
+
+    boost::mutex::scoped_lock dirty_lock(_dirty_sensors_mutex);
+    _dirty_sensors.erase(sensor->uuid());
+}
+
+void Store::clear_sensor_summaries() {
+
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    _sensor_summaries.clear();
+}
+
+void Store::clear_sensor_summary(const Sensor::uuid_t& uuid) {
+
+    boost::recursive_mutex::scoped_lock lock(_mutex);
+    _sensor_summaries.erase(uuid);
+}
+
+void Store::refresh_sensor_summaries() {
 }
 
 void Store::clear_buffers() {
 
+    boost::unique_lock<boost::shared_mutex> lock(_registry_mutex);
     _sensors_buffer.clear();
     _external_ids_buffer.clear();
+    _sensor_summaries.clear();
     _reading_operations_buffer.clear();
+    _buffered_readings = 0;
+
+    boost::mutex::scoped_lock dirty_lock(_dirty_sensors_mutex);
+    _dirty_sensors.clear();
 }
 
 void Store::handle_reading_insertion_error(const bool ignore_errors, const timestamp_t timestamp, const double value) {
@@ -479,9 +1364,21 @@ void Store::handle_reading_insertion_error(const bool ignore_errors, const Senso
     handle_reading_insertion_error(ignore_errors, oss.str());
 }
 
+void Store::handle_reading_insertion_error(const bool ignore_errors, const sensors_readings_spans_t& readings, const std::string& error) {
+
+    std::ostringstream oss;
+    oss << "Error adding readings for sensors:";
+    for (sensors_readings_spans_cit_t it = readings.begin(); it != readings.end(); ++it) {
+        oss << " " << (*it).first->uuid_string();
+    }
+    oss << ". " << error;
+    handle_reading_insertion_error(ignore_errors, oss.str());
+}
+
 void Store::handle_reading_insertion_error(const bool ignore_errors, const std::string message) {
 
     if (ignore_errors) {
+        _insertion_errors++;
         LOG(message);
     } else {
         throw StoreException(message);
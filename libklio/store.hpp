@@ -21,15 +21,26 @@
 #ifndef LIBKLIO_STORE_HPP
 #define LIBKLIO_STORE_HPP 1
 
+#include <deque>
 #include <vector>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/optional/optional.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/any.hpp>
+#include <boost/atomic.hpp>
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <libklio/common.hpp>
 #include <libklio/types.hpp>
+#include <libklio/readings-buffer.hpp>
+#include <libklio/readings-cursor.hpp>
 #include <libklio/sensor.hpp>
+#include <libklio/sensor-summary.hpp>
 #include <libklio/time.hpp>
 #include <libklio/transaction.hpp>
 #include <libklio/sensor-factory.hpp>
@@ -71,18 +82,133 @@ namespace klio {
 
         void add_reading(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value);
         void add_readings(const Sensor::Ptr sensor, const readings_t& readings);
+
+        /**
+         * Adds the readings of several sensors at once, for instance a frame
+         * covering all meters of a site. The buffered readings of all sensors
+         * are written in the same batch when the store is flushed.
+         */
+        void add_readings(const sensors_readings_t& readings);
         void update_readings(const Sensor::Ptr sensor, const readings_t& readings);
 
+        /**
+         * Writes a large set of readings, such as historical data, directly
+         * to the database, replacing readings with the same timestamps. The
+         * readings are not buffered, and stores that support it bypass their
+         * regular write path.
+         */
+        void load_readings(const Sensor::Ptr sensor, const readings_t& readings);
+
+        /**
+         * Loads readings whose timestamps have another resolution, given in
+         * timestamps per second. They are converted when the store has the
+         * finer resolution, otherwise a StoreException is thrown, since
+         * readings would be merged.
+         */
+        void load_readings(const Sensor::Ptr sensor, const readings_t& readings, const timestamp_t timestamps_per_second);
+
         readings_t_Ptr get_all_readings(const Sensor::Ptr sensor);
         readings_t_Ptr get_timeframe_readings(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end);
         reading_t get_last_reading(const Sensor::Ptr sensor);
         reading_t get_reading(const Sensor::Ptr sensor, const timestamp_t timestamp);
         unsigned long int get_num_readings(const Sensor::Ptr sensor);
 
+        /**
+         * Combines the readings between begin and end into intervals of
+         * bucket seconds, which start at multiples of bucket since the
+         * epoch. The result holds one value per interval with readings,
+         * keyed by the start of the interval.
+         */
+        readings_t_Ptr get_aggregated_readings(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+                const timestamp_t bucket, const aggregate_t function);
+
+        /**
+         * Number of readings, first and last reading, minimum, maximum and
+         * sum of the values of a sensor. The store computes the summary of
+         * a sensor once and extends it whenever readings are flushed.
+         */
+        SensorSummary get_sensor_summary(const Sensor::Ptr sensor);
+
+        /**
+         * Cursors fetch readings incrementally, ordered by timestamp. The
+         * store stays locked for other threads until the cursor is
+         * destroyed, which must happen in the thread that opened it.
+         */
+        ReadingsCursor::Ptr get_all_readings_cursor(const Sensor::Ptr sensor);
+        ReadingsCursor::Ptr get_timeframe_readings_cursor(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end);
+
+        /**
+         * Readings of a store whose timestamps have another resolution are
+         * converted like by load_readings().
+         */
         void sync(const Store::Ptr store);
         void sync_readings(const Sensor::Ptr sensor, const Store::Ptr store);
         void sync_sensors(const Store::Ptr store);
 
+        //Resolution of the timestamps of the readings, 1 for seconds since the epoch
+        virtual const timestamp_t timestamps_per_second() const;
+
+        /**
+         * Switches the store to asynchronous flushing. From now on, readings
+         * are added to a bounded queue and a background thread moves them
+         * into the buffers and performs the automatic flushes. When the queue
+         * holds high_water_mark readings, callers either wait for the flush
+         * thread (block_when_full = true) or the new readings are discarded.
+         *
+         * Asynchronous flushing requires automatic commits. Readings of
+         * sensors removed while they are still queued are logged and
+         * discarded by the flush thread.
+         */
+        void start_async_flush(const size_t high_water_mark, const bool block_when_full);
+        void stop_async_flush();
+
+        const bool async_flush();
+        const unsigned long int num_dropped_readings();
+
+        /**
+         * Limits of buffered readings that trigger a flush before the flush
+         * timeout expires. Sensor limits flush only the sensor that reached
+         * them, store limits flush all sensors. Zero disables a limit.
+         * Like timed flushes, these flushes log insertion errors instead
+         * of throwing them, whether they run in the caller or in the
+         * flush thread.
+         */
+        const unsigned long int max_buffered_readings() const {
+            return _max_buffered_readings;
+        };
+
+        void max_buffered_readings(const unsigned long int max_buffered_readings) {
+            _max_buffered_readings = max_buffered_readings;
+        };
+
+        const unsigned long int max_buffered_bytes() const {
+            return _max_buffered_bytes;
+        };
+
+        void max_buffered_bytes(const unsigned long int max_buffered_bytes) {
+            _max_buffered_bytes = max_buffered_bytes;
+        };
+
+        const unsigned long int max_sensor_buffered_readings() const {
+            return _max_sensor_buffered_readings;
+        };
+
+        void max_sensor_buffered_readings(const unsigned long int max_sensor_buffered_readings) {
+            _max_sensor_buffered_readings = max_sensor_buffered_readings;
+        };
+
+        const unsigned long int max_sensor_buffered_bytes() const {
+            return _max_sensor_buffered_bytes;
+        };
+
+        void max_sensor_buffered_bytes(const unsigned long int max_sensor_buffered_bytes) {
+            _max_sensor_buffered_bytes = max_sensor_buffered_bytes;
+        };
+
+        const unsigned long int num_buffered_readings() const {
+            return _buffered_readings;
+        };
+
     protected:
 
         Store(const bool auto_commit, const bool auto_flush, const timestamp_t flush_timeout, const unsigned int min_bulk_size, const unsigned int max_bulk_size) :
@@ -91,7 +217,18 @@ namespace klio {
         _flush_timeout(flush_timeout),
         _last_flush(0),
         _min_bulk_size(min_bulk_size),
-        _max_bulk_size(max_bulk_size) {
+        _max_bulk_size(max_bulk_size),
+        _async_flush(false),
+        _stop_flush_thread(false),
+        _high_water_mark(0),
+        _block_when_full(true),
+        _dropped_readings(0),
+        _max_buffered_readings(0),
+        _max_buffered_bytes(0),
+        _max_sensor_buffered_readings(0),
+        _max_sensor_buffered_bytes(0),
+        _buffered_readings(0),
+        _insertion_errors(0) {
         };
 
         static const SensorFactory::Ptr sensor_factory;
@@ -105,8 +242,22 @@ namespace klio {
         virtual void remove_sensor_record(const Sensor::Ptr sensor) = 0;
         virtual void update_sensor_record(const Sensor::Ptr sensor) = 0;
         virtual void add_single_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp, const double value, const bool ignore_errors) = 0;
-        virtual void add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) = 0;
-        virtual void update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) = 0;
+        virtual void add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) = 0;
+        virtual void update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) = 0;
+
+        /**
+         * Writes the readings of several sensors in one batched operation.
+         * The default implementation writes the readings of each sensor
+         * separately.
+         */
+        virtual void add_batch_reading_records(const sensors_readings_spans_t& readings, const bool ignore_errors);
+
+        /**
+         * Writes sorted readings of a sensor, bypassing the buffers. The
+         * default implementation updates them in bulks of at most
+         * _max_bulk_size readings.
+         */
+        virtual void load_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors);
 
         virtual std::vector<Sensor::Ptr> get_sensor_records() = 0;
         virtual readings_t_Ptr get_all_reading_records(const Sensor::Ptr sensor) = 0;
@@ -114,22 +265,74 @@ namespace klio {
         virtual reading_t get_last_reading_record(const Sensor::Ptr sensor) = 0;
         virtual reading_t get_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp) = 0;
         virtual unsigned long int get_num_readings_value(const Sensor::Ptr sensor) = 0;
+        virtual SensorSummary get_sensor_summary_record(const Sensor::Ptr sensor);
+        virtual ReadingsCursor::Ptr get_all_reading_records_cursor(const Sensor::Ptr sensor);
+        virtual ReadingsCursor::Ptr get_timeframe_reading_records_cursor(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end);
+
+        /**
+         * Aggregates the readings in the database where possible. The
+         * default implementation aggregates the readings of a cursor.
+         */
+        virtual readings_t_Ptr get_aggregated_reading_records(const Sensor::Ptr sensor, const timestamp_t begin, const timestamp_t end,
+                const timestamp_t bucket, const aggregate_t function);
 
         void set_buffers(const Sensor::Ptr sensor);
         virtual void clear_buffers();
+
+        //Summaries are computed again after the store itself has removed readings
+        void clear_sensor_summaries();
+        void clear_sensor_summary(const Sensor::uuid_t& uuid);
+
+        //Called before cached summaries are used, for stores whose readings also expire on their own
+        virtual void refresh_sensor_summaries();
         void handle_reading_insertion_error(const bool ignore_errors, const timestamp_t timestamp, const double value);
         void handle_reading_insertion_error(const bool ignore_errors, const Sensor::Ptr sensor);
+        void handle_reading_insertion_error(const bool ignore_errors, const sensors_readings_spans_t& readings, const std::string& error);
 
         bool _auto_commit;
         bool _auto_flush;
         boost::unordered_map<const Sensor::uuid_t, Sensor::Ptr> _sensors_buffer;
 
+        /*
+         * Locking: _mutex serializes all database access, including flushes.
+         * The sensor registry (_sensors_buffer and the private buffer maps) is
+         * guarded by _registry_mutex; it is only modified while _mutex is held
+         * too, so code holding _mutex may read it directly. The buffered
+         * readings of each sensor have their own mutex, so readings of
+         * different sensors are added without contention. Timed flushes are
+         * claimed under _last_flush_mutex and skipped while _mutex is busy,
+         * so writers never wait for them.
+         * Lock order: _mutex, _registry_mutex, sensor mutex.
+         */
+        boost::recursive_mutex _mutex;
+
     private:
         typedef unsigned int cached_operation_type_t;
-        typedef std::pair<const cached_operation_type_t, const readings_t_Ptr> cached_readings_type_t;
-        typedef boost::unordered_map<const cached_operation_type_t, const readings_t_Ptr> cached_reading_operations_type_t;
-        typedef boost::unordered_map<const cached_operation_type_t, const readings_t_Ptr>::const_iterator cached_reading_operations_type_it_t;
-        typedef boost::shared_ptr<cached_reading_operations_type_t> cached_reading_operations_type_t_Ptr;
+        typedef std::pair<const cached_operation_type_t, const ReadingsBuffer::Ptr> cached_readings_type_t;
+        typedef boost::unordered_map<const cached_operation_type_t, const ReadingsBuffer::Ptr> cached_reading_operations_type_t;
+        typedef boost::unordered_map<const cached_operation_type_t, const ReadingsBuffer::Ptr>::const_iterator cached_reading_operations_type_it_t;
+
+        typedef struct {
+            boost::mutex mutex;
+            cached_reading_operations_type_t operations;
+            Sensor::uuid_t uuid;
+            bool dirty;
+        } cached_sensor_readings_t;
+        typedef boost::shared_ptr<cached_sensor_readings_t> cached_sensor_readings_t_Ptr;
+
+        typedef struct {
+            Sensor::uuid_t uuid;
+            cached_operation_type_t operation;
+            timestamp_t timestamp;
+            double value;
+        } queued_reading_t;
+
+        //Outcomes of waiting for space in the readings queue
+        typedef enum {
+            QUEUE_SPACE,
+            QUEUE_FULL,
+            QUEUE_STOPPED
+        } queue_space_t;
 
         Store(const Store& original);
         Store& operator=(const Store& rhs);
@@ -143,18 +346,65 @@ namespace klio {
         unsigned int _min_bulk_size;
         unsigned int _max_bulk_size;
 
-        boost::unordered_map<const Sensor::uuid_t, cached_reading_operations_type_t_Ptr> _reading_operations_buffer;
+        boost::unordered_map<const Sensor::uuid_t, cached_sensor_readings_t_Ptr> _reading_operations_buffer;
         boost::unordered_map<const std::string, Sensor::uuid_t> _external_ids_buffer;
+        boost::unordered_map<const Sensor::uuid_t, SensorSummary> _sensor_summaries;
+        boost::shared_mutex _registry_mutex;
+
+        //Sensors with buffered readings, so that flushes skip idle sensors
+        boost::unordered_set<Sensor::uuid_t> _dirty_sensors;
+        boost::mutex _dirty_sensors_mutex;
+        boost::mutex _last_flush_mutex;
+
+        boost::shared_ptr<boost::thread> _flush_thread;
+        boost::mutex _queue_mutex;
+        boost::condition_variable _queue_not_empty;
+        boost::condition_variable _queue_not_full;
+        std::deque<queued_reading_t> _queue;
+        bool _async_flush;
+        bool _stop_flush_thread;
+        size_t _high_water_mark;
+        bool _block_when_full;
+        unsigned long int _dropped_readings;
+
+        unsigned long int _max_buffered_readings;
+        unsigned long int _max_buffered_bytes;
+        unsigned long int _max_sensor_buffered_readings;
+        unsigned long int _max_sensor_buffered_bytes;
+        boost::atomic<unsigned long int> _buffered_readings;
+
+        //Insertion errors that were only logged, guarded by _mutex like all writes
+        unsigned long int _insertion_errors;
 
         void sync_reading_records(const Sensor::Ptr sensor, const Store::Ptr store);
+        readings_t_Ptr convert_timestamps(const readings_t& readings, const timestamp_t timestamps_per_second);
+        void load_sensor_readings(const Sensor::Ptr sensor, const readings_t& readings);
         Sensor::Ptr sync_sensor_record(const Sensor::Ptr sensor);
         void add_readings(const Sensor::Ptr sensor, const readings_t& readings, const cached_operation_type_t operation_type);
-        readings_t_Ptr get_buffered_readings(const Sensor::Ptr sensor, const cached_operation_type_t operation_type);
+        const bool buffer_readings(const cached_sensor_readings_t_Ptr buffers, const readings_t& readings, const cached_operation_type_t operation_type);
+        cached_sensor_readings_t_Ptr get_sensor_buffers(const Sensor::uuid_t& uuid);
+        void mark_dirty(const cached_sensor_readings_t_Ptr buffers, const size_t num_readings);
+        const bool sensor_limit_reached(const cached_sensor_readings_t_Ptr buffers);
+        const bool store_limit_reached();
+
+        bool enqueue_readings(const Sensor::Ptr sensor, const readings_t& readings, const cached_operation_type_t operation_type, readings_t& unqueued);
+        bool enqueue_reading(const Sensor::uuid_t& uuid, const cached_operation_type_t operation_type, const timestamp_t timestamp, const double value);
+        queue_space_t wait_for_queue_space(boost::mutex::scoped_lock& lock);
+        void run_flush_thread();
+        void drain_queue();
 
         void check_out_commit_off();
         void auto_flush();
+        void auto_flush(const Sensor::uuid_t& uuid, const bool sensor_limit_reached);
+        void flush_full_buffers();
+        const bool claim_flush(const timestamp_t now, timestamp_t& last_flush);
+        void release_flush(const timestamp_t now, const timestamp_t last_flush);
         void flush_all(const bool ignore_errors);
         void flush(const Sensor::Ptr sensor, const bool ignore_errors);
+        void flush_sensors(const std::vector<Sensor::Ptr>& sensors, const bool ignore_errors);
+        void write_batch(const sensors_readings_spans_t& batch, const bool ignore_errors, boost::unordered_set<Sensor::uuid_t>& unwritten);
+        void update_sensor_summary(const Sensor::uuid_t& uuid, const ReadingsSpan& readings);
+        const double complete_aggregate(const aggregate_t function, const double value, const unsigned long int count);
         void clear_buffers(const Sensor::Ptr sensor);
         void handle_reading_insertion_error(const bool ignore_errors, const std::string message);
     };
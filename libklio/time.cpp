@@ -31,12 +31,12 @@ const timestamp_t TimeConverter::get_timestamp() {
     return rawtime;
 }
 
-const long TimeConverter::convert_to_epoch(const timestamp_t time) {
+const timestamp_t TimeConverter::convert_to_epoch(const timestamp_t time) {
     //TODO
     return time;
 }
 
-const timestamp_t TimeConverter::convert_from_epoch(const long epoch) {
+const timestamp_t TimeConverter::convert_from_epoch(const timestamp_t epoch) {
     //TODO
     return epoch;
 }
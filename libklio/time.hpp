@@ -40,8 +40,8 @@ namespace klio {
         };
 
         const timestamp_t get_timestamp();
-        const long convert_to_epoch(const timestamp_t time);
-        const timestamp_t convert_from_epoch(const long epoch);
+        const timestamp_t convert_to_epoch(const timestamp_t time);
+        const timestamp_t convert_from_epoch(const timestamp_t epoch);
         const std::string str_local(const timestamp_t time);
         const std::string str_utc(const timestamp_t time);
 
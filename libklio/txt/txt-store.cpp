@@ -17,6 +17,8 @@ void TXTStore::open() {
 }
 
 void TXTStore::close() {
+
+    stop_async_flush();
 }
 
 void TXTStore::check_integrity() {
@@ -126,39 +128,39 @@ void TXTStore::add_single_reading_record(const Sensor::Ptr sensor, const timesta
     }
 }
 
-void TXTStore::add_bulk_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+void TXTStore::add_bulk_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
 
     check_sensor(sensor, true);
 
     std::ofstream file(compose_sensor_readings_path(sensor->uuid_string()),
             std::ofstream::out | std::ofstream::app);
 
-    for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
+    for (size_t i = 0; i < readings.size(); i++) {
 
         try {
-            save_reading(file, (*it).first, (*it).second);
+            save_reading(file, readings.timestamp(i), readings.value(i));
 
         } catch (std::exception const& e) {
-            handle_reading_insertion_error(ignore_errors, (*it).first, (*it).second);
+            handle_reading_insertion_error(ignore_errors, readings.timestamp(i), readings.value(i));
         }
     }
     file.close();
 }
 
-void TXTStore::update_reading_records(const Sensor::Ptr sensor, const readings_t& readings, const bool ignore_errors) {
+void TXTStore::update_reading_records(const Sensor::Ptr sensor, const ReadingsSpan& readings, const bool ignore_errors) {
 
     check_sensor(sensor, true);
     
     std::ofstream file(compose_sensor_readings_path(sensor->uuid_string()),
             std::ofstream::out | std::ofstream::app);
 
-    for (readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
+    for (size_t i = 0; i < readings.size(); i++) {
 
         try {
-            save_reading(file, (*it).first, (*it).second);
+            save_reading(file, readings.timestamp(i), readings.value(i));
 
         } catch (std::exception const& e) {
-            handle_reading_insertion_error(ignore_errors, (*it).first, (*it).second);
+            handle_reading_insertion_error(ignore_errors, readings.timestamp(i), readings.value(i));
         }
     }
     file.close();
@@ -233,14 +235,12 @@ readings_t_Ptr TXTStore::get_timeframe_reading_records(const Sensor::Ptr sensor,
 
 unsigned long int TXTStore::get_num_readings_value(const Sensor::Ptr sensor) {
 
-    //TODO: make this method more efficient
-    return get_all_readings(sensor)->size();
+    return get_sensor_summary_record(sensor).num_readings();
 }
 
 reading_t TXTStore::get_last_reading_record(const Sensor::Ptr sensor) {
 
-    //TODO: improve this method
-    return *(get_all_reading_records(sensor)->end());
+    return get_sensor_summary_record(sensor).last_reading();
 }
 
 reading_t TXTStore::get_reading_record(const Sensor::Ptr sensor, const timestamp_t timestamp) {
@@ -41,10 +41,26 @@ namespace klio {
     typedef std::map<klio::timestamp_t, double>::const_iterator readings_cit_t;
     typedef std::pair<klio::timestamp_t, double> reading_t;
 
+    // functions that combine the readings of each interval of an aggregation
+    typedef enum {
+        AGGREGATE_AVG,
+        AGGREGATE_MIN,
+        AGGREGATE_MAX,
+        AGGREGATE_SUM,
+        AGGREGATE_COUNT,
+        AGGREGATE_FIRST,
+        AGGREGATE_LAST
+    } aggregate_t;
+
     // collection of sensors. The order of the sensors is important!
     typedef std::vector<klio::Sensor::Ptr> sensors_t;
     typedef std::vector<klio::Sensor::Ptr>::const_iterator sensors_cit_t;
 
+    // readings of several sensors, added in a single call
+    typedef std::pair<klio::Sensor::Ptr, readings_t> sensor_readings_t;
+    typedef std::vector<sensor_readings_t> sensors_readings_t;
+    typedef std::vector<sensor_readings_t>::const_iterator sensors_readings_cit_t;
+
     // "tables" of sensor data. 
     typedef boost::multi_array<double, 2 > sensordata_array_t;
     typedef sensordata_array_t::index sensordata_array_idx_t;
@@ -139,10 +139,10 @@ int main(int argc, char** argv) {
                     std::cout << "Found sensor \"" << loadedSensor->name() << "\"" << std::endl;
                     found_sensor = true;
 
-                    klio::readings_t_Ptr readings;
+                    klio::ReadingsCursor::Ptr readings;
 
                     if (!vm.count("lasthours")) {
-                        readings = store->get_all_readings(loadedSensor);
+                        readings = store->get_all_readings_cursor(loadedSensor);
 
                     } else {
                         uint32_t num_last_hours = vm["lasthours"].as<long>();
@@ -152,7 +152,7 @@ int main(int argc, char** argv) {
                         klio::timestamp_t first_timestamp = last_timestamp - num_last_seconds;
                         std::cout << "Retrieving last " << num_last_hours << " hours of data from the store (["
                                 << first_timestamp << ", " << last_timestamp << "])" << std::endl;
-                        readings = store->get_timeframe_readings(loadedSensor, first_timestamp, last_timestamp);
+                        readings = store->get_timeframe_readings_cursor(loadedSensor, first_timestamp, last_timestamp);
                     }
 
                     if (boost::iequals(action, std::string("TABLE")) ||
@@ -160,21 +160,21 @@ int main(int argc, char** argv) {
 
                         //TABLE and PLAINTABLE commands
 
-                        klio::readings_it_t it;
+                        klio::reading_t reading;
                         if (boost::iequals(action, std::string("TABLE"))) {
                             std::cout << "Writing header to output file." << std::endl;
                             *outputstream << "timestamp\treading" << std::endl;
                         }
-                        for (it = readings->begin(); it != readings->end(); it++) {
-                            klio::timestamp_t ts1 = (*it).first;
-                            double val1 = (*it).second;
+                        while (readings->next(reading)) {
+                            klio::timestamp_t ts1 = reading.first;
+                            double val1 = reading.second;
                             *outputstream << ts1 << "\t" << val1 << std::endl;
                         }
 
                     } else if (boost::iequals(action, std::string("CSV"))) {
                         //CSV command 
 
-                        klio::readings_it_t it;
+                        klio::reading_t reading;
                         *outputstream << "date;time;reading" << std::endl;
                         klio::LocalTime::Ptr lt(new klio::LocalTime("."));
 
@@ -183,14 +183,14 @@ int main(int argc, char** argv) {
 
                         std::ostringstream oss;
                         oss.imbue(std::locale(std::locale::classic(), output_facet));
-                        for (it = readings->begin(); it != readings->end(); it++) {
+                        while (readings->next(reading)) {
 
-                            klio::timestamp_t ts1 = (*it).first;
+                            klio::timestamp_t ts1 = reading.first;
                             boost::local_time::local_date_time localtime = lt->get_local_time(loadedSensor, ts1);
 
                             oss.str("");
                             oss << localtime;
-                            double val1 = (*it).second;
+                            double val1 = reading.second;
                             *outputstream << oss.str() << ";" << val1 << std::endl;
                         }
 
@@ -46,7 +46,9 @@ int main(int argc, char** argv) {
                 ("action,a", po::value<std::string>(), "Valid actions: csv")
                 ("separators,c", po::value<std::string>(), "the characters used in the readings file to separate columns")
                 ("storefile,s", po::value<std::string>(), "the data store to use")
+                ("storetype,t", po::value<std::string>(), "the type of the data store: sqlite3 (default) or rocksdb")
                 ("inputfile,f", po::value<std::string>(), "the readings file to import")
+                ("resolution,r", po::value<std::string>(), "the resolution of the timestamps in the readings file: seconds (default) or milliseconds")
                 ("id,i", po::value<std::string>(), "the internal id of the sensor (i.e. 3e3b6ef2-d960-4677-8845-1f52977b16d6)")
                 ;
         po::positional_options_description p;
@@ -108,6 +110,21 @@ int main(int argc, char** argv) {
 
         std::string separators = vm.count("separators") ? vm["separators"].as<std::string>() : ",";
 
+        //The readings are converted to the resolution of the store, if it is finer
+        std::string resolution = vm.count("resolution") ? vm["resolution"].as<std::string>() : "seconds";
+        klio::timestamp_t timestamps_per_second;
+
+        if (boost::iequals(resolution, std::string("seconds"))) {
+            timestamps_per_second = 1;
+
+        } else if (boost::iequals(resolution, std::string("milliseconds"))) {
+            timestamps_per_second = 1000;
+
+        } else {
+            std::cerr << "Unknown timestamp resolution " << resolution << std::endl;
+            return 2;
+        }
+
         if (!vm.count("id")) {
             std::cout << "You must specify the internal id of the sensor." << std::endl;
             return 2;
@@ -117,7 +134,23 @@ int main(int argc, char** argv) {
         std::ifstream* inputstream = new std::ifstream(inputfile.c_str());
         klio::StoreFactory::Ptr factory(new klio::StoreFactory());
 
-        klio::Store::Ptr store(factory->open_sqlite3_store(db));
+        std::string storetype = vm.count("storetype") ? vm["storetype"].as<std::string>() : "sqlite3";
+        klio::Store::Ptr store;
+
+        if (boost::iequals(storetype, std::string("sqlite3"))) {
+            store = factory->open_sqlite3_store(db);
+
+#ifdef ENABLE_ROCKSDB
+        } else if (boost::iequals(storetype, std::string("rocksdb"))) {
+            store = factory->open_rocksdb_store(db);
+#endif /* ENABLE_ROCKSDB */
+
+        } else {
+            std::cerr << "Unknown store type " << storetype << std::endl;
+            inputstream->close();
+            delete inputstream;
+            return 2;
+        }
         std::cout << "opened store: " << store->str() << std::endl;
 
         try {
@@ -136,7 +169,8 @@ int main(int argc, char** argv) {
                     klio::Importer::Ptr importer(new klio::CSVImporter(*inputstream, separators));
                     klio::readings_t_Ptr readings = importer->process();
 
-                    store->update_readings(sensor, *readings);
+                    //The readings are written at once, RocksDB stores ingest them as SST files
+                    store->load_readings(sensor, *readings, timestamps_per_second);
 
                 } else {
                     //UNKNOWN command
@@ -42,6 +42,7 @@ int main(int argc, char** argv) {
                 ("version,v", "print libklio version and exit")
                 ("action,a", po::value<std::string>(), "Valid actions are: create, check, sync, upgrade")
                 ("storefile,s", po::value<std::string>(), "the data store to use")
+                ("storetype,t", po::value<std::string>(), "the type of the data store to upgrade: sqlite3 (default), rocksdb or redis, whose host is given as store")
                 ("sourcestore,r", po::value<std::string>(), "the data store to use as source for synchronization")
                 ;
         po::positional_options_description p;
@@ -327,9 +328,29 @@ int main(int argc, char** argv) {
             try {
                 klio::VersionInfo::Ptr info = klio::VersionInfo::Ptr(new klio::VersionInfo());
 
-                std::cout << "Attempting to upgrade " << db << " to version " << info->getVersion() << std::endl;
-                klio::SQLite3Store::Ptr store(factory->create_sqlite3_store(db, false));
-                store->upgrade();
+                std::cout << "Attempting to upgrade " << storefile << " to version " << info->getVersion() << std::endl;
+                const std::string storetype = vm.count("storetype") ? vm["storetype"].as<std::string>() : "sqlite3";
+
+                if (boost::iequals(storetype, std::string("sqlite3"))) {
+                    klio::SQLite3Store::Ptr store(factory->create_sqlite3_store(db, false));
+                    store->upgrade();
+
+#ifdef ENABLE_ROCKSDB
+                } else if (boost::iequals(storetype, std::string("rocksdb"))) {
+                    klio::RocksDBStore::Ptr store(factory->upgrade_rocksdb_store(db));
+#endif /* ENABLE_ROCKSDB */
+
+#ifdef ENABLE_REDIS3M
+                } else if (boost::iequals(storetype, std::string("redis"))) {
+                    klio::RedisStore::Ptr store(factory->create_redis_store(storefile,
+                            klio::RedisStore::DEFAULT_REDIS_PORT, klio::RedisStore::DEFAULT_REDIS_DB));
+                    store->upgrade();
+#endif /* ENABLE_REDIS3M */
+
+                } else {
+                    std::cerr << "Unknown store type " << storetype << std::endl;
+                    return 1;
+                }
                 std::cout << "Store upgraded." << std::endl;
 
             } catch (klio::StoreException const& ex) {
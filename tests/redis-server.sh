@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# Starts and stops the Redis server used by the tests.
+#
+# Usage: redis-server.sh start|stop PORT DIR
+#
+# The server listens on 127.0.0.1 only, and it neither saves nor loads
+# any data. Its pid and log files are kept in DIR.
+
+PORT=$2
+DIR=$3
+PIDFILE="$DIR/redis-server-$PORT.pid"
+
+case "$1" in
+    start)
+        redis-server --port "$PORT" --bind 127.0.0.1 --save '' --appendonly no \
+            --dir "$DIR" --pidfile "$PIDFILE" --logfile "$DIR/redis-server-$PORT.log" \
+            --daemonize yes || exit 1
+
+        #The server accepts connections shortly after it was forked
+        for i in 1 2 3 4 5 6 7 8 9 10; do
+            if redis-cli -p "$PORT" ping > /dev/null 2>&1; then
+                exit 0
+            fi
+            sleep 1
+        done
+        echo "The Redis server on port $PORT did not start." >&2
+        exit 1
+        ;;
+    stop)
+        if [ -f "$PIDFILE" ]; then
+            kill "$(cat "$PIDFILE")"
+            rm -f "$PIDFILE"
+        fi
+        ;;
+    *)
+        echo "Usage: $0 start|stop PORT DIR" >&2
+        exit 1
+        ;;
+esac
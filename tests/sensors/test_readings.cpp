@@ -20,6 +20,7 @@
 
 #include <iostream>
 #include <map>
+#include <boost/bind.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/test/unit_test.hpp>
 #include <libklio/config.h>
@@ -396,6 +397,136 @@ BOOST_AUTO_TEST_CASE(check_roksdb_bulk_insert) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(check_rocksdb_timeframe_readings) {
+
+    try {
+        std::cout << std::endl << "Testing - The retrieval of readings by timeframe in RocksDB." << std::endl;
+        klio::Sensor::Ptr sensor = create_test_sensor("sensor", "sensor", "Watt");
+        klio::RocksDBStore::Ptr store = create_rocksdb_test_store(TEST_DB1_FILE);
+
+        try {
+            store->add_sensor(sensor);
+
+            //Timestamps of different lengths, whose decimal strings are not in time order
+            klio::readings_t readings;
+            for (klio::timestamp_t timestamp = 90; timestamp < 110; timestamp++) {
+                readings.insert(klio::reading_t(timestamp, timestamp * 0.5));
+            }
+            store->add_readings(sensor, readings);
+
+            klio::readings_t_Ptr timeframe = store->get_timeframe_readings(sensor, 95, 104);
+            BOOST_CHECK_EQUAL(10, timeframe->size());
+            BOOST_CHECK_EQUAL(95, timeframe->begin()->first);
+            BOOST_CHECK_EQUAL(104, timeframe->rbegin()->first);
+
+            BOOST_CHECK_EQUAL(50.5, store->get_reading(sensor, 101).second);
+            BOOST_CHECK_EQUAL(0, store->get_reading(sensor, 200).first);
+            BOOST_CHECK_EQUAL(109, store->get_last_reading(sensor).first);
+            BOOST_CHECK_EQUAL(20, store->get_all_readings(sensor)->size());
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_rocksdb_shared_database) {
+
+    try {
+        std::cout << std::endl << "Testing - The storage of several sensors in one RocksDB database." << std::endl;
+        klio::Sensor::Ptr sensor1 = create_test_sensor("sensor1", "sensor1", "Watt");
+        klio::Sensor::Ptr sensor2 = create_test_sensor("sensor2", "sensor2", "Watt");
+        klio::RocksDBStore::Ptr store = create_rocksdb_test_store(TEST_DB1_FILE);
+
+        try {
+            store->add_sensor(sensor1);
+            store->add_sensor(sensor2);
+
+            for (klio::timestamp_t timestamp = 1000; timestamp < 1100; timestamp++) {
+                store->add_reading(sensor1, timestamp, 1);
+                store->add_reading(sensor2, timestamp + 50, 2);
+            }
+            store->flush();
+
+            BOOST_CHECK_EQUAL(100, store->get_all_readings(sensor1)->size());
+            BOOST_CHECK_EQUAL(100, store->get_all_readings(sensor2)->size());
+            BOOST_CHECK_EQUAL(50, store->get_timeframe_readings(sensor1, 1050, 1200)->size());
+            BOOST_CHECK_EQUAL(1099, store->get_last_reading(sensor1).first);
+            BOOST_CHECK_EQUAL(1149, store->get_last_reading(sensor2).first);
+
+            store->remove_sensor(sensor1);
+
+            BOOST_CHECK_EQUAL(1, store->get_sensors().size());
+            BOOST_CHECK_EQUAL(100, store->get_num_readings(sensor2));
+            BOOST_CHECK_EQUAL(2, store->get_reading(sensor2, 1100).second);
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_rocksdb_retention) {
+
+    try {
+        std::cout << std::endl << "Testing - The retention of readings in RocksDB." << std::endl;
+        klio::Sensor::Ptr sensor = create_test_sensor("sensor", "sensor", "Watt");
+        klio::RocksDBStore::Ptr store = create_rocksdb_test_store(TEST_DB1_FILE);
+
+        try {
+            store->add_sensor(sensor);
+
+            //Readings older than one hour are hidden before they are compacted
+            store->set_retention(sensor, 3600, 600);
+
+            klio::TimeConverter::Ptr tc(new klio::TimeConverter());
+            const klio::timestamp_t now = tc->get_timestamp();
+
+            klio::readings_t readings;
+            for (klio::timestamp_t timestamp = now - 7200; timestamp < now; timestamp += 60) {
+                readings.insert(klio::reading_t(timestamp, 1));
+            }
+            store->add_readings(sensor, readings);
+
+            klio::readings_t_Ptr retained = store->get_all_readings(sensor);
+            BOOST_CHECK(retained->size() <= 61);
+            BOOST_CHECK(retained->begin()->first >= now - 3600);
+            BOOST_CHECK_EQUAL(0, store->get_reading(sensor, now - 7200).first);
+            BOOST_CHECK_EQUAL(retained->size(), store->get_sensor_summary(sensor).num_readings());
+
+            store->remove_retention(sensor);
+            BOOST_CHECK_EQUAL(120, store->get_all_readings(sensor)->size());
+            BOOST_CHECK_EQUAL(120, store->get_sensor_summary(sensor).num_readings());
+
+            //Cached summaries no longer count the readings that expire
+            store->set_retention(sensor, 3600, 0);
+            BOOST_CHECK(store->get_num_readings(sensor) <= 61);
+            BOOST_CHECK_EQUAL(store->get_all_readings(sensor)->size(), store->get_sensor_summary(sensor).num_readings());
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
 #endif /* ENABLE_ROCKSDB */
 
 #ifdef ENABLE_REDIS3M
@@ -411,8 +542,8 @@ klio::RedisStore::Ptr create_redis_test_store(const std::string& host, const uns
 klio::RedisStore::Ptr create_redis_test_store() {
 
     return create_redis_test_store(
-            klio::RedisStore::DEFAULT_REDIS_HOST,
-            klio::RedisStore::DEFAULT_REDIS_PORT,
+            TEST_REDIS_HOST,
+            TEST_REDIS_PORT,
             klio::RedisStore::DEFAULT_REDIS_DB);
 }
 
@@ -624,135 +755,995 @@ BOOST_AUTO_TEST_CASE(check_sqlite3_num_readings) {
     }
 }
 
-BOOST_AUTO_TEST_CASE(check_sync_readings) {
+BOOST_AUTO_TEST_CASE(check_sqlite3_buffered_unordered_readings) {
 
     try {
-        std::cout << std::endl << "Testing - Readings synchronization." << std::endl;
-        klio::SQLite3Store::Ptr storeA = create_sqlite3_test_store(TEST_DB1_FILE);
-        klio::SQLite3Store::Ptr storeB = create_sqlite3_test_store(TEST_DB2_FILE);
-
-        klio::Sensor::Ptr sensor1 = create_test_sensor("sensor1", "sensor1", "Watt");
-        klio::Sensor::Ptr sensor2 = create_test_sensor("sensor2", "sensor2", "Watt");
-        klio::Sensor::Ptr sensor3 = create_test_sensor("sensor3", "sensor3", "Watt");
-        klio::Sensor::Ptr sensor4 = create_test_sensor("sensor4", "sensor4", "Watt");
+        std::cout << std::endl << "Testing - The buffering of unordered and duplicated readings in SQLite3." << std::endl;
+        klio::Sensor::Ptr sensor = create_test_sensor("sensor", "sensor", "Watt");
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(
+                TEST_DB1_FILE,
+                true,
+                true,
+                false,
+                0,
+                klio::SQLite3Store::OS_SYNC_OFF);
 
         try {
-            storeA->add_sensor(sensor1);
-            storeB->sync(storeA);
-            std::vector<klio::Sensor::uuid_t> uuids = storeB->get_sensor_uuids();
-            BOOST_CHECK_EQUAL(1, uuids.size());
-
-            storeA->add_sensor(sensor2);
-            storeA->add_sensor(sensor3);
-            storeB->add_sensor(sensor4);
+            store->add_sensor(sensor);
 
-            //Add readings to sensor 1 and 3 at store A
             klio::TimeConverter::Ptr tc(new klio::TimeConverter());
-            klio::readings_t readings;
-            size_t num_readings = 10;
+            klio::timestamp_t start_time = tc->get_timestamp();
+            size_t num_readings = 50;
 
-            klio::timestamp_t timestamp = tc->get_timestamp();
+            //Add readings in descending order, each one twice
             for (size_t i = 0; i < num_readings; i++) {
-                klio::reading_t foo(timestamp--, 23);
-                readings.insert(foo);
+
+                klio::timestamp_t timestamp = start_time - i;
+                store->add_reading(sensor, timestamp, i);
+                store->add_reading(sensor, timestamp, i + 1000);
             }
-            std::cout << "Inserting " << readings.size() << " readings to sensor 1 and 3." << std::endl;
-            storeA->add_readings(sensor1, readings);
-            storeA->add_readings(sensor3, readings);
+            store->flush();
 
-            std::cout << "Synchronize sensor1 readings." << std::endl;
-            storeB->sync_readings(sensor1, storeA);
-            std::cout << "Synchronized." << std::endl;
+            klio::readings_t_Ptr loaded_readings = store->get_all_readings(sensor);
+            BOOST_CHECK_EQUAL(num_readings, loaded_readings->size());
 
-            klio::readings_t sync_readings = *storeB->get_all_readings(sensor1);
-            BOOST_CHECK_EQUAL(readings.size(), sync_readings.size());
+            //The first buffered value of each timestamp must be kept
+            for (size_t i = 0; i < num_readings; i++) {
+                BOOST_CHECK_EQUAL((double) i, (*loaded_readings)[start_time - i]);
+            }
 
-            std::map<klio::timestamp_t, double>::iterator it1;
-            std::map<klio::timestamp_t, double>::iterator it2 = readings.begin();
+            store->dispose();
 
-            for (it1 = sync_readings.begin(); it1 != sync_readings.end(); ++it1) {
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
 
-                klio::timestamp_t ts1 = (*it1).first;
-                klio::timestamp_t ts2 = (*it2).first;
-                double val1 = (*it1).second;
-                double val2 = (*it2).second;
-                ++it2;
+BOOST_AUTO_TEST_CASE(check_sqlite3_async_flush) {
 
-                BOOST_CHECK_EQUAL(ts1, ts2);
-                BOOST_CHECK_EQUAL(val1, val2);
-            }
+    try {
+        std::cout << std::endl << "Testing - The asynchronous flushing of readings in SQLite3." << std::endl;
+        klio::Sensor::Ptr sensor = create_test_sensor("sensor", "sensor", "Watt");
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(
+                TEST_DB1_FILE,
+                true,
+                true,
+                true,
+                1,
+                klio::SQLite3Store::OS_SYNC_OFF);
 
-            //Repeat synchronization
-            storeB->sync_readings(sensor1, storeA);
-            sync_readings = *storeB->get_all_readings(sensor1);
-            BOOST_CHECK_EQUAL(readings.size(), sync_readings.size());
+        try {
+            store->add_sensor(sensor);
+            store->start_async_flush(16, true);
+            BOOST_CHECK(store->async_flush());
 
-            //Sensor 2 has no readings
-            storeB->sync_readings(sensor2, storeA);
-            sync_readings = *storeB->get_all_readings(sensor2);
-            BOOST_CHECK_EQUAL(0, sync_readings.size());
+            klio::TimeConverter::Ptr tc(new klio::TimeConverter());
+            klio::timestamp_t start_time = tc->get_timestamp();
+            size_t num_readings = 1000;
 
-            //Sensor 3 does not exist in store B
-            storeB->sync_readings(sensor3, storeA);
+            for (size_t i = 0; i < num_readings; i++) {
+                store->add_reading(sensor, start_time - i, 23);
+            }
 
-            std::vector<klio::Sensor::Ptr> sensors = storeB->get_sensors_by_external_id(sensor3->external_id());
+            //Pending readings must be visible to readers
+            BOOST_CHECK_EQUAL(num_readings, store->get_num_readings(sensor));
+            BOOST_CHECK_EQUAL(0, store->num_dropped_readings());
 
-            for (std::vector<klio::Sensor::Ptr>::const_iterator it = sensors.begin(); it != sensors.end(); ++it) {
+            store->stop_async_flush();
+            BOOST_CHECK(!store->async_flush());
 
-                sensor3 = *it;
-                sync_readings = *storeB->get_all_readings(sensor3);
-                BOOST_CHECK_EQUAL(readings.size(), sync_readings.size());
+            //Readings that do not fit in the queue are discarded
+            store->start_async_flush(10, false);
+
+            klio::readings_t readings;
+            for (size_t i = 0; i < num_readings; i++) {
+                readings.insert(klio::reading_t(start_time + i + 1, 42));
             }
+            store->add_readings(sensor, readings);
+            store->flush();
 
-            klio::Sensor::Ptr changed3 = sensor_factory->createSensor(sensor3->uuid(), sensor3->external_id(), "Changed Name", "Changed Description", "kWh", "Europe/Paris", klio::DeviceType::DRIER);
-            storeA->update_sensor(changed3);
+            BOOST_CHECK_EQUAL(2 * num_readings, store->get_num_readings(sensor) + store->num_dropped_readings());
 
-            storeB->sync_readings(changed3, storeA);
+            store->dispose();
 
-            sync_readings = *storeB->get_all_readings(changed3);
-            BOOST_CHECK_EQUAL(readings.size(), sync_readings.size());
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
 
-            sensors = storeB->get_sensors_by_external_id(sensor3->external_id());
-            BOOST_CHECK_EQUAL(1, sensors.size());
+void add_test_readings_at_once(const klio::Store::Ptr store, const klio::Sensor::Ptr sensor, const klio::readings_t readings) {
 
-            for (std::vector<klio::Sensor::Ptr>::const_iterator it = sensors.begin(); it != sensors.end(); ++it) {
+    store->add_readings(sensor, readings);
+}
 
-                klio::Sensor::Ptr found = (*it);
-                BOOST_CHECK_EQUAL(found->uuid(), sensor3->uuid());
-                BOOST_CHECK_EQUAL(found->external_id(), sensor3->external_id());
-                BOOST_CHECK_EQUAL(found->name(), "Changed Name");
-                BOOST_CHECK_EQUAL(found->description(), "Changed Description");
-                BOOST_CHECK_EQUAL(found->unit(), "kWh");
-                BOOST_CHECK_EQUAL(found->timezone(), "Europe/Paris");
-                BOOST_CHECK_EQUAL(found->device_type(), klio::DeviceType::DRIER);
-            }
+void add_test_readings_one_by_one(const klio::Store::Ptr store, const klio::Sensor::Ptr sensor, const klio::readings_t readings) {
 
-            //Same external id, different uuids
-            klio::Sensor::Ptr copy4(sensor_factory->createSensor("sensor4", "copy of sensor 4", "kWh", "Europe/Paris"));
-            std::cout << "Created " << copy4->str() << std::endl;
-            storeA->add_sensor(copy4);
-            storeA->add_readings(copy4, readings);
+    for (klio::readings_cit_t it = readings.begin(); it != readings.end(); ++it) {
+        store->add_reading(sensor, (*it).first, (*it).second);
+    }
+}
 
-            storeB->sync_readings(copy4, storeA);
-            sync_readings = *storeB->get_all_readings(sensor4);
-            BOOST_CHECK_EQUAL(readings.size(), sync_readings.size());
+BOOST_AUTO_TEST_CASE(check_sqlite3_stop_async_flush) {
 
-            klio::Sensor::Ptr found = storeB->get_sensor(sensor4->uuid());
-            BOOST_CHECK_EQUAL(found->uuid(), sensor4->uuid());
-            BOOST_CHECK_EQUAL(found->external_id(), sensor4->external_id());
-            BOOST_CHECK_EQUAL(found->name(), copy4->name());
-            BOOST_CHECK_EQUAL(found->description(), found->description());
-            BOOST_CHECK_EQUAL(found->unit(), found->unit());
-            BOOST_CHECK_EQUAL(found->timezone(), found->timezone());
+    try {
+        std::cout << std::endl << "Testing - Stopping the asynchronous flushing of readings in SQLite3 while the queue is full." << std::endl;
+        klio::Sensor::Ptr sensor1 = create_test_sensor("sensor1", "sensor1", "Watt");
+        klio::Sensor::Ptr sensor2 = create_test_sensor("sensor2", "sensor2", "Watt");
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(
+                TEST_DB1_FILE,
+                true,
+                true,
+                true,
+                1,
+                klio::SQLite3Store::OS_SYNC_OFF);
 
-            // cleanup
-            storeA->dispose();
-            storeB->dispose();
+        try {
+            store->add_sensor(sensor1);
+            store->add_sensor(sensor2);
+            store->start_async_flush(10, true);
+
+            klio::readings_t readings;
+            for (klio::timestamp_t timestamp = 1000; timestamp < 1100; timestamp++) {
+                readings.insert(klio::reading_t(timestamp, 23));
+            }
+
+            {
+                //The open cursor keeps the flush thread from draining the queue, so the producers wait for space
+                klio::ReadingsCursor::Ptr cursor = store->get_all_readings_cursor(sensor1);
+                boost::thread producer1(boost::bind(add_test_readings_at_once, store, sensor1, readings));
+                boost::thread producer2(boost::bind(add_test_readings_one_by_one, store, sensor2, readings));
+                boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+
+                //The waiting producers buffer the rest of their readings themselves, at most 10 were queued
+                boost::thread stopper(boost::bind(&klio::Store::stop_async_flush, store));
+                boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+                BOOST_CHECK(store->num_buffered_readings() >= 90);
+                cursor.reset();
+
+                producer1.join();
+                producer2.join();
+                stopper.join();
+            }
+
+            BOOST_CHECK(!store->async_flush());
+            BOOST_CHECK_EQUAL(0, store->num_dropped_readings());
+            BOOST_CHECK_EQUAL(100, store->get_num_readings(sensor1));
+            BOOST_CHECK_EQUAL(100, store->get_num_readings(sensor2));
+
+            store->dispose();
 
         } catch (klio::StoreException const& ex) {
-            // cleanup
-            storeA->dispose();
-            storeB->dispose();
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_busy_timed_flush) {
+
+    try {
+        std::cout << std::endl << "Testing - Adding readings in SQLite3 while the store is busy with a timed flush." << std::endl;
+        klio::Sensor::Ptr sensor = create_test_sensor("sensor", "sensor", "Watt");
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(
+                TEST_DB1_FILE,
+                true,
+                true,
+                true,
+                0,
+                klio::SQLite3Store::OS_SYNC_OFF);
+
+        try {
+            store->add_sensor(sensor);
+
+            klio::readings_t readings;
+            for (klio::timestamp_t timestamp = 1000; timestamp < 1100; timestamp++) {
+                readings.insert(klio::reading_t(timestamp, 23));
+            }
+
+            {
+                //Every reading is due for a timed flush, the writer skips it while the cursor holds the store
+                klio::ReadingsCursor::Ptr cursor = store->get_all_readings_cursor(sensor);
+                boost::thread writer(boost::bind(add_test_readings_one_by_one, store, sensor, readings));
+
+                BOOST_CHECK(writer.timed_join(boost::posix_time::seconds(5)));
+                BOOST_CHECK_EQUAL(100, store->num_buffered_readings());
+                cursor.reset();
+                writer.join();
+            }
+
+            BOOST_CHECK_EQUAL(100, store->get_num_readings(sensor));
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_buffer_limits) {
+
+    try {
+        std::cout << std::endl << "Testing - The flushing of readings when buffer limits are reached in SQLite3." << std::endl;
+        klio::Sensor::Ptr sensor1 = create_test_sensor("sensor1", "sensor1", "Watt");
+        klio::Sensor::Ptr sensor2 = create_test_sensor("sensor2", "sensor2", "Watt");
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(
+                TEST_DB1_FILE,
+                true,
+                true,
+                true,
+                3600,
+                klio::SQLite3Store::OS_SYNC_OFF);
+
+        try {
+            store->add_sensor(sensor1);
+            store->add_sensor(sensor2);
+            store->max_sensor_buffered_readings(10);
+            store->max_buffered_readings(30);
+
+            klio::TimeConverter::Ptr tc(new klio::TimeConverter());
+            klio::timestamp_t start_time = tc->get_timestamp();
+
+            //The sensor limit must keep the buffer of each sensor small
+            for (size_t i = 0; i < 100; i++) {
+                store->add_reading(sensor1, start_time - i, 23);
+                BOOST_CHECK(store->num_buffered_readings() < 10);
+            }
+
+            //The store limit must be reached before any sensor limit
+            store->max_sensor_buffered_readings(0);
+
+            for (size_t i = 0; i < 100; i++) {
+                store->add_reading(i % 2 == 0 ? sensor1 : sensor2, start_time + i + 1, 42);
+                BOOST_CHECK(store->num_buffered_readings() < 30);
+            }
+
+            BOOST_CHECK_EQUAL(150, store->get_num_readings(sensor1));
+            BOOST_CHECK_EQUAL(50, store->get_num_readings(sensor2));
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_bulk_insert_conflicts) {
+
+    try {
+        std::cout << std::endl << "Testing - The bulk insertion of conflicting readings in SQLite3." << std::endl;
+        klio::Sensor::Ptr sensor = create_test_sensor("sensor1", "sensor1", "Watt");
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(
+                TEST_DB1_FILE,
+                true,
+                true,
+                true,
+                3600,
+                klio::SQLite3Store::OS_SYNC_OFF);
+
+        try {
+            store->add_sensor(sensor);
+
+            klio::TimeConverter::Ptr tc(new klio::TimeConverter());
+            klio::timestamp_t start_time = tc->get_timestamp();
+
+            klio::readings_t readings;
+            for (size_t i = 0; i < 100; i++) {
+                readings.insert(klio::reading_t(start_time - i, 23));
+            }
+            store->add_readings(sensor, readings);
+            store->flush();
+            BOOST_CHECK_EQUAL(100, store->get_num_readings(sensor));
+
+            //The readings that already exist are skipped, the others are inserted
+            readings.clear();
+            for (size_t i = 0; i < 37; i++) {
+                readings.insert(klio::reading_t(start_time - 95 - i, 42));
+            }
+            store->add_readings(sensor, readings);
+            store->flush();
+            BOOST_CHECK_EQUAL(132, store->get_num_readings(sensor));
+            BOOST_CHECK_EQUAL(23, store->get_reading(sensor, start_time - 95).second);
+            BOOST_CHECK_EQUAL(42, store->get_reading(sensor, start_time - 131).second);
+
+            store->update_readings(sensor, readings);
+            store->flush();
+            BOOST_CHECK_EQUAL(132, store->get_num_readings(sensor));
+            BOOST_CHECK_EQUAL(42, store->get_reading(sensor, start_time - 95).second);
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_add_multi_sensor_readings) {
+
+    try {
+        std::cout << std::endl << "Testing - The addition of readings of several sensors at once in SQLite3." << std::endl;
+        klio::Sensor::Ptr sensor1 = create_test_sensor("sensor1", "sensor1", "Watt");
+        klio::Sensor::Ptr sensor2 = create_test_sensor("sensor2", "sensor2", "Watt");
+        klio::Sensor::Ptr sensor3 = create_test_sensor("sensor3", "sensor3", "Watt");
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(
+                TEST_DB1_FILE,
+                true,
+                true,
+                true,
+                3600,
+                klio::SQLite3Store::OS_SYNC_OFF);
+
+        try {
+            store->add_sensor(sensor1);
+            store->add_sensor(sensor2);
+
+            klio::TimeConverter::Ptr tc(new klio::TimeConverter());
+            klio::timestamp_t start_time = tc->get_timestamp();
+
+            klio::readings_t readings1;
+            klio::readings_t readings2;
+            for (size_t i = 0; i < 25; i++) {
+                readings1.insert(klio::reading_t(start_time - i, 23));
+                readings2.insert(klio::reading_t(start_time - i * 2, 42));
+            }
+
+            klio::sensors_readings_t readings;
+            readings.push_back(klio::sensor_readings_t(sensor1, readings1));
+            readings.push_back(klio::sensor_readings_t(sensor2, readings2));
+
+            store->add_readings(readings);
+            store->flush();
+            BOOST_CHECK_EQUAL(0, store->num_buffered_readings());
+            BOOST_CHECK_EQUAL(25, store->get_num_readings(sensor1));
+            BOOST_CHECK_EQUAL(25, store->get_num_readings(sensor2));
+            BOOST_CHECK_EQUAL(42, store->get_reading(sensor2, start_time - 48).second);
+
+            //No reading is buffered when any of the sensors is unknown
+            readings.push_back(klio::sensor_readings_t(sensor3, readings1));
+            BOOST_CHECK_THROW(store->add_readings(readings), klio::StoreException);
+            BOOST_CHECK_EQUAL(0, store->num_buffered_readings());
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+/**
+ * SQLite3 store that counts the writes of readings per sensor, and that
+ * can be made to fail inserting them.
+ */
+class CountingSQLite3Store : public klio::SQLite3Store {
+public:
+    typedef boost::shared_ptr<CountingSQLite3Store> Ptr;
+
+    CountingSQLite3Store(const bfs::path& path) :
+    klio::SQLite3Store(path, true, false, 3600, klio::SQLite3Store::OS_SYNC_OFF, std::map<const std::string, const std::string>()),
+    _failing(false) {
+    };
+
+    void failing(const bool failing) {
+        _failing = failing;
+    };
+
+    const size_t num_writes(const klio::Sensor::Ptr sensor) {
+        return _writes[sensor->uuid()];
+    };
+
+    void clear_writes() {
+        _writes.clear();
+    };
+
+protected:
+    void add_batch_reading_records(const klio::sensors_readings_spans_t& readings, const bool ignore_errors) {
+
+        for (klio::sensors_readings_spans_cit_t it = readings.begin(); it != readings.end(); ++it) {
+            _writes[(*it).first->uuid()]++;
+        }
+
+        if (_failing) {
+            handle_reading_insertion_error(ignore_errors, readings, "The store is failing.");
+        } else {
+            klio::SQLite3Store::add_batch_reading_records(readings, ignore_errors);
+        }
+    };
+
+    void update_reading_records(const klio::Sensor::Ptr sensor, const klio::ReadingsSpan& readings, const bool ignore_errors) {
+
+        _writes[sensor->uuid()]++;
+        klio::SQLite3Store::update_reading_records(sensor, readings, ignore_errors);
+    };
+
+private:
+    std::map<klio::Sensor::uuid_t, size_t> _writes;
+    bool _failing;
+};
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_flush_dirty_sensors) {
+
+    try {
+        std::cout << std::endl << "Testing - Flushing only the sensors with buffered readings in SQLite3." << std::endl;
+        klio::Sensor::Ptr sensor1 = create_test_sensor("sensor1", "sensor1", "Watt");
+        klio::Sensor::Ptr sensor2 = create_test_sensor("sensor2", "sensor2", "Watt");
+        klio::Sensor::Ptr sensor3 = create_test_sensor("sensor3", "sensor3", "Watt");
+
+        CountingSQLite3Store::Ptr store(new CountingSQLite3Store(TEST_DB1_FILE));
+        store->open();
+        store->initialize();
+        store->prepare();
+
+        try {
+            store->add_sensor(sensor1);
+            store->add_sensor(sensor2);
+            store->add_sensor(sensor3);
+
+            klio::TimeConverter::Ptr tc(new klio::TimeConverter());
+            klio::timestamp_t start_time = tc->get_timestamp();
+
+            klio::readings_t readings;
+            for (size_t i = 0; i < 20; i++) {
+                readings.insert(klio::reading_t(start_time - i, 23));
+            }
+
+            //Only the sensor with buffered readings is written
+            store->add_readings(sensor2, readings);
+            store->flush();
+            BOOST_CHECK_EQUAL(0, store->num_buffered_readings());
+            BOOST_CHECK_EQUAL(0, store->num_writes(sensor1));
+            BOOST_CHECK_EQUAL(1, store->num_writes(sensor2));
+            BOOST_CHECK_EQUAL(0, store->num_writes(sensor3));
+
+            //The flushed sensor is clean again
+            store->clear_writes();
+            klio::readings_t updates;
+            updates.insert(klio::reading_t(start_time, 42));
+            store->update_readings(sensor3, updates);
+            store->flush();
+            BOOST_CHECK_EQUAL(0, store->num_writes(sensor1));
+            BOOST_CHECK_EQUAL(0, store->num_writes(sensor2));
+            BOOST_CHECK_EQUAL(1, store->num_writes(sensor3));
+
+            //Nothing is written without buffered readings
+            store->clear_writes();
+            store->flush();
+            BOOST_CHECK_EQUAL(0, store->num_writes(sensor1));
+            BOOST_CHECK_EQUAL(0, store->num_writes(sensor2));
+            BOOST_CHECK_EQUAL(0, store->num_writes(sensor3));
+
+            BOOST_CHECK_EQUAL(0, store->get_num_readings(sensor1));
+            BOOST_CHECK_EQUAL(20, store->get_num_readings(sensor2));
+            BOOST_CHECK_EQUAL(1, store->get_num_readings(sensor3));
+            BOOST_CHECK_EQUAL(42, store->get_reading(sensor3, start_time).second);
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_flush_ignored_errors) {
+
+    try {
+        std::cout << std::endl << "Testing - The summaries of readings that failed to be flushed in SQLite3." << std::endl;
+        klio::Sensor::Ptr sensor1 = create_test_sensor("sensor1", "sensor1", "Watt");
+        klio::Sensor::Ptr sensor2 = create_test_sensor("sensor2", "sensor2", "Watt");
+
+        CountingSQLite3Store::Ptr store(new CountingSQLite3Store(TEST_DB1_FILE));
+        store->open();
+        store->initialize();
+        store->prepare();
+
+        try {
+            store->add_sensor(sensor1);
+            store->add_sensor(sensor2);
+
+            klio::readings_t readings;
+            for (klio::timestamp_t timestamp = 1000; timestamp < 1020; timestamp++) {
+                readings.insert(klio::reading_t(timestamp, 1));
+            }
+            store->add_readings(sensor1, readings);
+            store->add_readings(sensor2, readings);
+            store->flush();
+
+            //The summaries are cached
+            BOOST_CHECK_EQUAL(20, store->get_sensor_summary(sensor1).num_readings());
+            BOOST_CHECK_EQUAL(20, store->get_sensor_summary(sensor2).num_readings());
+
+            klio::readings_t later;
+            for (klio::timestamp_t timestamp = 2000; timestamp < 2005; timestamp++) {
+                later.insert(klio::reading_t(timestamp, 2));
+            }
+
+            //The failed readings are logged and discarded, they are not counted
+            store->failing(true);
+            store->add_readings(sensor1, later);
+            store->add_readings(sensor2, later);
+            store->flush(true);
+            store->failing(false);
+
+            BOOST_CHECK_EQUAL(0, store->num_buffered_readings());
+            BOOST_CHECK_EQUAL(20, store->get_num_readings(sensor1));
+            BOOST_CHECK_EQUAL(20, store->get_num_readings(sensor2));
+            BOOST_CHECK_EQUAL(1019, store->get_last_reading(sensor1).first);
+            BOOST_CHECK_EQUAL(20, store->get_sensor_summary(sensor2).num_readings());
+
+            //Readings that are written again extend the summaries
+            store->add_readings(sensor1, later);
+            store->flush();
+            BOOST_CHECK_EQUAL(25, store->get_num_readings(sensor1));
+            BOOST_CHECK_EQUAL(2004, store->get_last_reading(sensor1).first);
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_sensor_summary) {
+
+    try {
+        std::cout << std::endl << "Testing - The summary of the readings of a sensor in SQLite3." << std::endl;
+        klio::Sensor::Ptr sensor = create_test_sensor("sensor1", "sensor1", "Watt");
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(
+                TEST_DB1_FILE,
+                true,
+                true,
+                false,
+                3600,
+                klio::SQLite3Store::OS_SYNC_OFF);
+
+        try {
+            store->add_sensor(sensor);
+            BOOST_CHECK(store->get_sensor_summary(sensor).empty());
+
+            klio::readings_t readings;
+            for (klio::timestamp_t timestamp = 1000; timestamp < 1010; timestamp++) {
+                readings.insert(klio::reading_t(timestamp, timestamp - 1000));
+            }
+            store->add_readings(sensor, readings);
+
+            klio::SensorSummary summary = store->get_sensor_summary(sensor);
+            BOOST_CHECK_EQUAL(10, summary.num_readings());
+            BOOST_CHECK_EQUAL(1000, summary.first_timestamp());
+            BOOST_CHECK_EQUAL(1009, summary.last_timestamp());
+            BOOST_CHECK_EQUAL(9, summary.last_value());
+            BOOST_CHECK_EQUAL(0, summary.min_value());
+            BOOST_CHECK_EQUAL(9, summary.max_value());
+            BOOST_CHECK_EQUAL(45, summary.sum());
+
+            //Newer readings extend the summary
+            store->add_reading(sensor, 1010, -5);
+            summary = store->get_sensor_summary(sensor);
+            BOOST_CHECK_EQUAL(11, summary.num_readings());
+            BOOST_CHECK_EQUAL(-5, summary.last_value());
+            BOOST_CHECK_EQUAL(-5, summary.min_value());
+            BOOST_CHECK_EQUAL(40, summary.sum());
+            BOOST_CHECK_EQUAL(11, store->get_num_readings(sensor));
+            BOOST_CHECK_EQUAL(1010, store->get_last_reading(sensor).first);
+
+            //Older readings and updates lead to a new summary
+            store->add_reading(sensor, 900, 100);
+            summary = store->get_sensor_summary(sensor);
+            BOOST_CHECK_EQUAL(12, summary.num_readings());
+            BOOST_CHECK_EQUAL(900, summary.first_timestamp());
+            BOOST_CHECK_EQUAL(100, summary.max_value());
+            BOOST_CHECK_EQUAL(140, summary.sum());
+
+            readings.clear();
+            readings.insert(klio::reading_t(1010, 5));
+            store->update_readings(sensor, readings);
+            summary = store->get_sensor_summary(sensor);
+            BOOST_CHECK_EQUAL(12, summary.num_readings());
+            BOOST_CHECK_EQUAL(5, summary.last_value());
+            BOOST_CHECK_EQUAL(150, summary.sum());
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_readings_cursor) {
+
+    try {
+        std::cout << std::endl << "Testing - The streaming of readings through cursors in SQLite3." << std::endl;
+        klio::Sensor::Ptr sensor = create_test_sensor("sensor1", "sensor1", "Watt");
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(
+                TEST_DB1_FILE,
+                true,
+                true,
+                true,
+                3600,
+                klio::SQLite3Store::OS_SYNC_OFF);
+
+        try {
+            store->add_sensor(sensor);
+
+            klio::TimeConverter::Ptr tc(new klio::TimeConverter());
+            klio::timestamp_t start_time = tc->get_timestamp();
+
+            //Buffered readings must be flushed before the cursor is opened
+            for (size_t i = 0; i < 100; i++) {
+                store->add_reading(sensor, start_time - i, i);
+            }
+
+            klio::ReadingsCursor::Ptr cursor = store->get_all_readings_cursor(sensor);
+            klio::reading_t reading;
+            size_t num_readings = 0;
+
+            while (cursor->next(reading)) {
+                BOOST_CHECK_EQUAL(start_time - 99 + num_readings, reading.first);
+                BOOST_CHECK_EQUAL((double) (99 - num_readings), reading.second);
+                num_readings++;
+            }
+            BOOST_CHECK_EQUAL(100, num_readings);
+            BOOST_CHECK(!cursor->next(reading));
+            cursor.reset();
+
+            cursor = store->get_timeframe_readings_cursor(sensor, start_time - 9, start_time);
+            num_readings = 0;
+
+            while (cursor->next(reading)) {
+                BOOST_CHECK(reading.first >= start_time - 9 && reading.first <= start_time);
+                num_readings++;
+            }
+            BOOST_CHECK_EQUAL(10, num_readings);
+            cursor.reset();
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_aggregated_readings) {
+
+    try {
+        std::cout << std::endl << "Testing - The aggregation of readings in SQLite3." << std::endl;
+        klio::Sensor::Ptr sensor = create_test_sensor("sensor1", "sensor1", "Watt");
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(
+                TEST_DB1_FILE,
+                true,
+                true,
+                false,
+                3600,
+                klio::SQLite3Store::OS_SYNC_OFF);
+
+        try {
+            store->add_sensor(sensor);
+
+            klio::readings_t readings;
+            for (klio::timestamp_t timestamp = 1000; timestamp < 1100; timestamp++) {
+                readings.insert(klio::reading_t(timestamp, timestamp % 10));
+            }
+            for (klio::timestamp_t timestamp = -5; timestamp < 5; timestamp++) {
+                readings.insert(klio::reading_t(timestamp, timestamp));
+            }
+            store->add_readings(sensor, readings);
+
+            klio::readings_t_Ptr averages = store->get_aggregated_readings(sensor, 1000, 1099, 60, klio::AGGREGATE_AVG);
+            BOOST_CHECK_EQUAL(3, averages->size());
+            BOOST_CHECK_CLOSE(4.5, (*averages)[960], 0.0001);
+            BOOST_CHECK_CLOSE(4.5, (*averages)[1020], 0.0001);
+            BOOST_CHECK_CLOSE(4.5, (*averages)[1080], 0.0001);
+
+            klio::readings_t_Ptr counts = store->get_aggregated_readings(sensor, 1010, 1049, 20, klio::AGGREGATE_COUNT);
+            BOOST_CHECK_EQUAL(3, counts->size());
+            BOOST_CHECK_EQUAL(10, (*counts)[1000]);
+            BOOST_CHECK_EQUAL(20, (*counts)[1020]);
+            BOOST_CHECK_EQUAL(10, (*counts)[1040]);
+
+            klio::readings_t_Ptr sums = store->get_aggregated_readings(sensor, 1000, 1099, 50, klio::AGGREGATE_SUM);
+            BOOST_CHECK_EQUAL(2, sums->size());
+            BOOST_CHECK_EQUAL(225, (*sums)[1000]);
+            BOOST_CHECK_EQUAL(225, (*sums)[1050]);
+
+            klio::readings_t_Ptr maxima = store->get_aggregated_readings(sensor, 1000, 1099, 100, klio::AGGREGATE_MAX);
+            BOOST_CHECK_EQUAL(9, (*maxima)[1000]);
+
+            klio::readings_t_Ptr firsts = store->get_aggregated_readings(sensor, 1003, 1099, 1000, klio::AGGREGATE_FIRST);
+            BOOST_CHECK_EQUAL(3, (*firsts)[1000]);
+
+            klio::readings_t_Ptr lasts = store->get_aggregated_readings(sensor, 1000, 1098, 1000, klio::AGGREGATE_LAST);
+            BOOST_CHECK_EQUAL(8, (*lasts)[1000]);
+
+            //Buckets before the epoch start at multiples of the interval as well
+            klio::readings_t_Ptr minima = store->get_aggregated_readings(sensor, -5, 4, 5, klio::AGGREGATE_MIN);
+            BOOST_CHECK_EQUAL(2, minima->size());
+            BOOST_CHECK_EQUAL(-5, (*minima)[-5]);
+            BOOST_CHECK_EQUAL(0, (*minima)[0]);
+
+            BOOST_CHECK_THROW(store->get_aggregated_readings(sensor, 1000, 1099, 0, klio::AGGREGATE_AVG), klio::StoreException);
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+void add_test_readings(const klio::Store::Ptr store, const klio::Sensor::Ptr sensor, const klio::timestamp_t start_time, const size_t num_readings) {
+
+    for (size_t i = 0; i < num_readings; i++) {
+        store->add_reading(sensor, start_time - i, 23);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_concurrent_readings) {
+
+    try {
+        std::cout << std::endl << "Testing - The concurrent addition of readings in SQLite3." << std::endl;
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(
+                TEST_DB1_FILE,
+                true,
+                true,
+                true,
+                0,
+                klio::SQLite3Store::OS_SYNC_OFF);
+
+        try {
+            klio::TimeConverter::Ptr tc(new klio::TimeConverter());
+            klio::timestamp_t start_time = tc->get_timestamp();
+            size_t num_sensors = 4;
+            size_t num_readings = 200;
+
+            std::vector<klio::Sensor::Ptr> sensors;
+            for (size_t i = 0; i < num_sensors; i++) {
+
+                klio::Sensor::Ptr sensor = create_test_sensor("sensor" + std::to_string(i), "sensor", "Watt");
+                store->add_sensor(sensor);
+                sensors.push_back(sensor);
+            }
+
+            boost::thread_group threads;
+            for (size_t i = 0; i < num_sensors; i++) {
+                threads.create_thread(boost::bind(add_test_readings, store, sensors[i], start_time, num_readings));
+            }
+            threads.join_all();
+
+            for (size_t i = 0; i < num_sensors; i++) {
+                BOOST_CHECK_EQUAL(num_readings, store->get_num_readings(sensors[i]));
+            }
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sync_readings) {
+
+    try {
+        std::cout << std::endl << "Testing - Readings synchronization." << std::endl;
+        klio::SQLite3Store::Ptr storeA = create_sqlite3_test_store(TEST_DB1_FILE);
+        klio::SQLite3Store::Ptr storeB = create_sqlite3_test_store(TEST_DB2_FILE);
+
+        klio::Sensor::Ptr sensor1 = create_test_sensor("sensor1", "sensor1", "Watt");
+        klio::Sensor::Ptr sensor2 = create_test_sensor("sensor2", "sensor2", "Watt");
+        klio::Sensor::Ptr sensor3 = create_test_sensor("sensor3", "sensor3", "Watt");
+        klio::Sensor::Ptr sensor4 = create_test_sensor("sensor4", "sensor4", "Watt");
+
+        try {
+            storeA->add_sensor(sensor1);
+            storeB->sync(storeA);
+            std::vector<klio::Sensor::uuid_t> uuids = storeB->get_sensor_uuids();
+            BOOST_CHECK_EQUAL(1, uuids.size());
+
+            storeA->add_sensor(sensor2);
+            storeA->add_sensor(sensor3);
+            storeB->add_sensor(sensor4);
+
+            //Add readings to sensor 1 and 3 at store A
+            klio::TimeConverter::Ptr tc(new klio::TimeConverter());
+            klio::readings_t readings;
+            size_t num_readings = 10;
+
+            klio::timestamp_t timestamp = tc->get_timestamp();
+            for (size_t i = 0; i < num_readings; i++) {
+                klio::reading_t foo(timestamp--, 23);
+                readings.insert(foo);
+            }
+            std::cout << "Inserting " << readings.size() << " readings to sensor 1 and 3." << std::endl;
+            storeA->add_readings(sensor1, readings);
+            storeA->add_readings(sensor3, readings);
+
+            std::cout << "Synchronize sensor1 readings." << std::endl;
+            storeB->sync_readings(sensor1, storeA);
+            std::cout << "Synchronized." << std::endl;
+
+            klio::readings_t sync_readings = *storeB->get_all_readings(sensor1);
+            BOOST_CHECK_EQUAL(readings.size(), sync_readings.size());
+
+            std::map<klio::timestamp_t, double>::iterator it1;
+            std::map<klio::timestamp_t, double>::iterator it2 = readings.begin();
+
+            for (it1 = sync_readings.begin(); it1 != sync_readings.end(); ++it1) {
+
+                klio::timestamp_t ts1 = (*it1).first;
+                klio::timestamp_t ts2 = (*it2).first;
+                double val1 = (*it1).second;
+                double val2 = (*it2).second;
+                ++it2;
+
+                BOOST_CHECK_EQUAL(ts1, ts2);
+                BOOST_CHECK_EQUAL(val1, val2);
+            }
+
+            //Repeat synchronization
+            storeB->sync_readings(sensor1, storeA);
+            sync_readings = *storeB->get_all_readings(sensor1);
+            BOOST_CHECK_EQUAL(readings.size(), sync_readings.size());
+
+            //Sensor 2 has no readings
+            storeB->sync_readings(sensor2, storeA);
+            sync_readings = *storeB->get_all_readings(sensor2);
+            BOOST_CHECK_EQUAL(0, sync_readings.size());
+
+            //Sensor 3 does not exist in store B
+            storeB->sync_readings(sensor3, storeA);
+
+            std::vector<klio::Sensor::Ptr> sensors = storeB->get_sensors_by_external_id(sensor3->external_id());
+
+            for (std::vector<klio::Sensor::Ptr>::const_iterator it = sensors.begin(); it != sensors.end(); ++it) {
+
+                sensor3 = *it;
+                sync_readings = *storeB->get_all_readings(sensor3);
+                BOOST_CHECK_EQUAL(readings.size(), sync_readings.size());
+            }
+
+            klio::Sensor::Ptr changed3 = sensor_factory->createSensor(sensor3->uuid(), sensor3->external_id(), "Changed Name", "Changed Description", "kWh", "Europe/Paris", klio::DeviceType::DRIER);
+            storeA->update_sensor(changed3);
+
+            storeB->sync_readings(changed3, storeA);
+
+            sync_readings = *storeB->get_all_readings(changed3);
+            BOOST_CHECK_EQUAL(readings.size(), sync_readings.size());
+
+            sensors = storeB->get_sensors_by_external_id(sensor3->external_id());
+            BOOST_CHECK_EQUAL(1, sensors.size());
+
+            for (std::vector<klio::Sensor::Ptr>::const_iterator it = sensors.begin(); it != sensors.end(); ++it) {
+
+                klio::Sensor::Ptr found = (*it);
+                BOOST_CHECK_EQUAL(found->uuid(), sensor3->uuid());
+                BOOST_CHECK_EQUAL(found->external_id(), sensor3->external_id());
+                BOOST_CHECK_EQUAL(found->name(), "Changed Name");
+                BOOST_CHECK_EQUAL(found->description(), "Changed Description");
+                BOOST_CHECK_EQUAL(found->unit(), "kWh");
+                BOOST_CHECK_EQUAL(found->timezone(), "Europe/Paris");
+                BOOST_CHECK_EQUAL(found->device_type(), klio::DeviceType::DRIER);
+            }
+
+            //Same external id, different uuids
+            klio::Sensor::Ptr copy4(sensor_factory->createSensor("sensor4", "copy of sensor 4", "kWh", "Europe/Paris"));
+            std::cout << "Created " << copy4->str() << std::endl;
+            storeA->add_sensor(copy4);
+            storeA->add_readings(copy4, readings);
+
+            storeB->sync_readings(copy4, storeA);
+            sync_readings = *storeB->get_all_readings(sensor4);
+            BOOST_CHECK_EQUAL(readings.size(), sync_readings.size());
+
+            klio::Sensor::Ptr found = storeB->get_sensor(sensor4->uuid());
+            BOOST_CHECK_EQUAL(found->uuid(), sensor4->uuid());
+            BOOST_CHECK_EQUAL(found->external_id(), sensor4->external_id());
+            BOOST_CHECK_EQUAL(found->name(), copy4->name());
+            BOOST_CHECK_EQUAL(found->description(), found->description());
+            BOOST_CHECK_EQUAL(found->unit(), found->unit());
+            BOOST_CHECK_EQUAL(found->timezone(), found->timezone());
+
+            // cleanup
+            storeA->dispose();
+            storeB->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            // cleanup
+            storeA->dispose();
+            storeB->dispose();
+            std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+            BOOST_FAIL("Unexpected store exception occurred during sensor test");
+        }
+    } catch (std::exception const& ex) {
+        BOOST_FAIL("Unexpected exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_load_readings) {
+
+    try {
+        std::cout << std::endl << "Testing - The bulk load of readings." << std::endl;
+        klio::SQLite3Store::Ptr store = create_sqlite3_test_store(TEST_DB1_FILE);
+        klio::Sensor::Ptr sensor = create_test_sensor("sensor", "sensor", "Watt");
+
+        try {
+            store->add_sensor(sensor);
+            store->add_reading(sensor, 1005, 1);
+            store->add_reading(sensor, 5000, 1);
+
+            klio::readings_t readings;
+            for (klio::timestamp_t timestamp = 1000; timestamp < 4000; timestamp++) {
+                readings.insert(klio::reading_t(timestamp, 2));
+            }
+            store->load_readings(sensor, readings);
+
+            //Loaded readings replace the buffered ones with the same timestamps
+            BOOST_CHECK_EQUAL(3001, store->get_num_readings(sensor));
+            BOOST_CHECK_EQUAL(2, store->get_reading(sensor, 1005).second);
+            BOOST_CHECK_EQUAL(5000, store->get_last_reading(sensor).first);
+            BOOST_CHECK_EQUAL(6001, store->get_sensor_summary(sensor).sum());
+
+            store->dispose();
+
+        } catch (klio::StoreException const& ex) {
+            store->dispose();
             std::cout << "Caught invalid exception: " << ex.what() << std::endl;
             BOOST_FAIL("Unexpected store exception occurred during sensor test");
         }
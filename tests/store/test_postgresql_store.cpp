@@ -431,6 +431,300 @@ BOOST_AUTO_TEST_CASE(check_postgresql_num_readings) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(check_postgresql_update_readings) {
+
+    std::cout << std::endl << "Checking updates of readings." << std::endl;
+    klio::PostgreSQLStore::Ptr store = create_postgresql_test_store();
+
+    try {
+        klio::Sensor::Ptr sensor = create_test_psensor("ffff", "Test libklio", "watt");
+        store->add_sensor(sensor);
+
+        klio::readings_t readings;
+        for (klio::timestamp_t timestamp = 1000; timestamp < 1010; timestamp++) {
+            readings.insert(klio::reading_t(timestamp, 1));
+        }
+        store->add_readings(sensor, readings);
+
+        //Existing readings are replaced, new ones are inserted
+        klio::readings_t updates;
+        updates.insert(klio::reading_t(1005, 2));
+        updates.insert(klio::reading_t(1010, 3));
+        store->update_readings(sensor, updates);
+
+        klio::readings_t_Ptr retrieved = store->get_all_readings(sensor);
+
+        BOOST_CHECK_EQUAL(11, retrieved->size());
+        BOOST_CHECK_EQUAL(1, (*retrieved)[1004]);
+        BOOST_CHECK_EQUAL(2, (*retrieved)[1005]);
+        BOOST_CHECK_EQUAL(1, (*retrieved)[1006]);
+        BOOST_CHECK_EQUAL(3, (*retrieved)[1010]);
+
+        store->dispose();
+
+    } catch (std::exception const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected store exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_postgresql_partitioned_readings) {
+
+    std::cout << std::endl << "Checking partitioned readings." << std::endl;
+    klio::PostgreSQLStore::Ptr store = pstore_factory->create_postgresql_store(
+            klio::PostgreSQLStore::DEFAULT_CONNECTION_INFO, true, true, true, 600, true, true);
+
+    try {
+        BOOST_CHECK(store->partitioned());
+
+        klio::Sensor::Ptr sensor = create_test_psensor("ffff", "Test libklio", "watt");
+        store->add_sensor(sensor);
+
+        //Readings at the end of January and the beginning of February 2015
+        const klio::timestamp_t february = 1422748800;
+        klio::readings_t readings;
+        for (klio::timestamp_t timestamp = february - 5; timestamp < february + 5; timestamp++) {
+            readings.insert(klio::reading_t(timestamp, 1));
+        }
+        store->add_readings(sensor, readings);
+
+        klio::readings_t updates;
+        updates.insert(klio::reading_t(february, 2));
+        store->update_readings(sensor, updates);
+
+        BOOST_CHECK_EQUAL(10, store->get_num_readings(sensor));
+        BOOST_CHECK_EQUAL(2, store->get_reading(sensor, february).second);
+
+        BOOST_CHECK_EQUAL(0, store->drop_partitions(february - 1));
+        BOOST_CHECK_EQUAL(1, store->drop_partitions(february));
+        BOOST_CHECK_EQUAL(5, store->get_num_readings(sensor));
+        BOOST_CHECK_EQUAL(february, store->get_all_readings(sensor)->begin()->first);
+
+        //A month that another store dropped is created again
+        klio::PostgreSQLStore::Ptr other = pstore_factory->create_postgresql_store(
+                klio::PostgreSQLStore::DEFAULT_CONNECTION_INFO, true, true, true, 600, true, true);
+        BOOST_CHECK_EQUAL(1, other->drop_partitions(february + 28 * 86400));
+        other->close();
+
+        readings.clear();
+        readings.insert(klio::reading_t(february + 10, 3));
+        store->add_readings(sensor, readings);
+        BOOST_CHECK_EQUAL(1, store->get_num_readings(sensor));
+        BOOST_CHECK_EQUAL(3, store->get_reading(sensor, february + 10).second);
+
+        store->dispose();
+
+    } catch (std::exception const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected store exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_postgresql_pipelined_readings) {
+
+    std::cout << std::endl << "Checking pipelined readings." << std::endl;
+    klio::PostgreSQLStore::Ptr store = pstore_factory->create_postgresql_store(
+            klio::PostgreSQLStore::DEFAULT_CONNECTION_INFO, true, true, true, 0, false);
+
+    try {
+        klio::Sensor::Ptr sensor = create_test_psensor("ffff", "Test libklio", "watt");
+        store->add_sensor(sensor);
+
+        //Every reading is flushed at once and queued without waiting for its result
+        for (klio::timestamp_t timestamp = 1000; timestamp < 1020; timestamp++) {
+            store->add_reading(sensor, timestamp, 1);
+        }
+
+        BOOST_CHECK_EQUAL(20, store->get_num_readings(sensor));
+        BOOST_CHECK_EQUAL(1019, store->get_last_reading(sensor).first);
+
+        //A failed statement is reported by the operation that queued it, not by the next read
+        BOOST_CHECK_THROW(store->add_sensor(sensor), klio::StoreException);
+        BOOST_CHECK_EQUAL(20, store->get_num_readings(sensor));
+        BOOST_CHECK_EQUAL(1, store->get_sensors().size());
+
+        store->dispose();
+
+    } catch (std::exception const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected store exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_postgresql_aggregated_readings) {
+
+    std::cout << std::endl << "Checking aggregation of readings on the server." << std::endl;
+    klio::PostgreSQLStore::Ptr store = pstore_factory->create_postgresql_store();
+
+    try {
+        klio::Sensor::Ptr sensor = create_test_psensor("gggg", "Test libklio", "watt");
+        store->add_sensor(sensor);
+
+        klio::readings_t readings;
+        for (klio::timestamp_t timestamp = 1000; timestamp < 1100; timestamp++) {
+            readings.insert(klio::reading_t(timestamp, timestamp % 10));
+        }
+        store->add_readings(sensor, readings);
+
+        klio::readings_t_Ptr averages = store->get_aggregated_readings(sensor, 1000, 1099, 60, klio::AGGREGATE_AVG);
+
+        BOOST_CHECK_EQUAL(3, averages->size());
+        BOOST_CHECK_CLOSE(4.5, (*averages)[960], 0.0001);
+        BOOST_CHECK_CLOSE(4.5, (*averages)[1020], 0.0001);
+        BOOST_CHECK_CLOSE(4.5, (*averages)[1080], 0.0001);
+
+        klio::readings_t_Ptr counts = store->get_aggregated_readings(sensor, 1010, 1049, 20, klio::AGGREGATE_COUNT);
+
+        BOOST_CHECK_EQUAL(3, counts->size());
+        BOOST_CHECK_EQUAL(10, (*counts)[1000]);
+        BOOST_CHECK_EQUAL(20, (*counts)[1020]);
+        BOOST_CHECK_EQUAL(10, (*counts)[1040]);
+
+        klio::readings_t_Ptr firsts = store->get_aggregated_readings(sensor, 1003, 1099, 1000, klio::AGGREGATE_FIRST);
+        BOOST_CHECK_EQUAL(3, (*firsts)[1000]);
+
+        klio::readings_t_Ptr lasts = store->get_aggregated_readings(sensor, 1000, 1098, 1000, klio::AGGREGATE_LAST);
+        BOOST_CHECK_EQUAL(8, (*lasts)[1000]);
+
+        store->dispose();
+
+    } catch (std::exception const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected store exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_postgresql_busy_readings_cursor) {
+
+    std::cout << std::endl << "Checking queries while a readings cursor is open." << std::endl;
+    klio::PostgreSQLStore::Ptr store = pstore_factory->create_postgresql_store();
+
+    try {
+        klio::Sensor::Ptr sensor = create_test_psensor("iiii", "Test libklio", "watt");
+        store->add_sensor(sensor);
+
+        klio::readings_t readings;
+        for (klio::timestamp_t timestamp = 1000; timestamp < 1100; timestamp++) {
+            readings.insert(klio::reading_t(timestamp, 1));
+        }
+        store->add_readings(sensor, readings);
+
+        klio::ReadingsCursor::Ptr cursor = store->get_all_readings_cursor(sensor);
+        klio::reading_t reading;
+        BOOST_CHECK(cursor->next(reading));
+
+        //The rows of the cursor must not be discarded by another query
+        BOOST_CHECK_THROW(store->get_reading(sensor, 1050), klio::StoreException);
+
+        size_t num_readings = 1;
+        while (cursor->next(reading)) {
+            num_readings++;
+        }
+        BOOST_CHECK_EQUAL(100, num_readings);
+        cursor.reset();
+
+        BOOST_CHECK_EQUAL(1, store->get_reading(sensor, 1050).second);
+
+        store->dispose();
+
+    } catch (std::exception const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected store exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_postgresql_duplicate_readings) {
+
+    std::cout << std::endl << "Checking batches with readings that exist already." << std::endl;
+    klio::PostgreSQLStore::Ptr store = pstore_factory->create_postgresql_store();
+
+    try {
+        klio::Sensor::Ptr sensor1 = create_test_psensor("jjjj", "Test libklio", "watt");
+        klio::Sensor::Ptr sensor2 = create_test_psensor("kkkk", "Test libklio", "watt");
+        store->add_sensor(sensor1);
+        store->add_sensor(sensor2);
+
+        klio::readings_t readings;
+        for (klio::timestamp_t timestamp = 1000; timestamp < 1100; timestamp++) {
+            readings.insert(klio::reading_t(timestamp, 1));
+        }
+        store->add_readings(sensor1, readings);
+        store->flush();
+
+        //Half of the readings of the first sensor exist already, they must not discard the others of the batch
+        klio::readings_t overlapping;
+        for (klio::timestamp_t timestamp = 1050; timestamp < 1150; timestamp++) {
+            overlapping.insert(klio::reading_t(timestamp, 2));
+        }
+        klio::sensors_readings_t batch;
+        batch.push_back(klio::sensor_readings_t(sensor1, overlapping));
+        batch.push_back(klio::sensor_readings_t(sensor2, readings));
+        store->add_readings(batch);
+        store->flush(true);
+
+        BOOST_CHECK_EQUAL(150, store->get_num_readings(sensor1));
+        BOOST_CHECK_EQUAL(100, store->get_num_readings(sensor2));
+        BOOST_CHECK_EQUAL(1, store->get_reading(sensor1, 1050).second);
+        BOOST_CHECK_EQUAL(2, store->get_reading(sensor1, 1100).second);
+
+        //The existing readings are still reported when errors are not ignored
+        store->add_readings(sensor2, readings);
+        BOOST_CHECK_THROW(store->flush(false), klio::StoreException);
+
+        store->dispose();
+
+    } catch (std::exception const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected store exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_postgresql_copy_encoding) {
+
+    std::cout << "Testing binary COPY encoding for PostgreSQL" << std::endl;
+
+    std::string buffer;
+    klio::PostgreSQLCodec::append_copy_header(buffer);
+
+    BOOST_CHECK_EQUAL(19, buffer.size());
+    BOOST_CHECK_EQUAL(std::string("PGCOPY\n\377\r\n\0", 11), buffer.substr(0, 11));
+
+    const std::string uuid = "01234567-89ab-cdef-0123-456789abcdef";
+    const std::string prefix = klio::PostgreSQLCodec::encode_copy_prefix(uuid);
+
+    buffer.clear();
+    klio::PostgreSQLCodec::append_copy_reading(buffer, prefix, 1234567890, 1.5);
+
+    BOOST_CHECK_EQUAL(klio::PostgreSQLCodec::TUPLE_SIZE, buffer.size());
+    BOOST_CHECK_EQUAL(std::string("\0\3\0\0\0\x24", 6), buffer.substr(0, 6));
+    BOOST_CHECK_EQUAL(uuid, buffer.substr(6, 36));
+    BOOST_CHECK_EQUAL(std::string("\0\0\0\4\x49\x96\x02\xd2", 8), buffer.substr(42, 8));
+    BOOST_CHECK_EQUAL(std::string("\0\0\0\x08\x3f\xf8\0\0\0\0\0\0", 12), buffer.substr(50, 12));
+
+    buffer.clear();
+    klio::PostgreSQLCodec::append_copy_trailer(buffer);
+    BOOST_CHECK_EQUAL(std::string("\xff\xff"), buffer);
+}
+
+BOOST_AUTO_TEST_CASE(check_postgresql_binary_decoding) {
+
+    std::cout << "Testing binary result decoding for PostgreSQL" << std::endl;
+
+    std::string buffer;
+    klio::PostgreSQLCodec::append_int32(buffer, -1234567890);
+    klio::PostgreSQLCodec::append_double(buffer, -273.15);
+
+    BOOST_CHECK_EQUAL(-1234567890, klio::PostgreSQLCodec::decode_int32(buffer.data()));
+    BOOST_CHECK_EQUAL(-273.15, klio::PostgreSQLCodec::decode_double(buffer.data() + 4));
+    BOOST_CHECK_EQUAL(1.5, klio::PostgreSQLCodec::decode_double("\x3f\xf8\0\0\0\0\0\0"));
+}
+
 BOOST_AUTO_TEST_CASE(check_postgresql_store_creation_performance) {
 
     try {
@@ -34,7 +34,10 @@ klio::SensorFactory::Ptr sensor_factory = klio::SensorFactory::Ptr(new klio::Sen
 klio::RedisStore::Ptr create_redis_test_store() {
 
     std::cout << "Attempting to create Redis store " << std::endl;
-    klio::RedisStore::Ptr store = store_factory->create_redis_store();
+    klio::RedisStore::Ptr store = store_factory->create_redis_store(
+            TEST_REDIS_HOST,
+            TEST_REDIS_PORT,
+            klio::RedisStore::DEFAULT_REDIS_DB);
     std::cout << "Created: " << store->str() << std::endl;
     return store;
 }
@@ -55,8 +58,8 @@ BOOST_AUTO_TEST_CASE(check_create_redis_storage) {
     try {
         klio::RedisStore::Ptr store = create_redis_test_store();
 
-        BOOST_CHECK_EQUAL(store->host(), klio::RedisStore::DEFAULT_REDIS_HOST);
-        BOOST_CHECK_EQUAL(store->port(), klio::RedisStore::DEFAULT_REDIS_PORT);
+        BOOST_CHECK_EQUAL(store->host(), TEST_REDIS_HOST);
+        BOOST_CHECK_EQUAL(store->port(), TEST_REDIS_PORT);
         BOOST_CHECK_EQUAL(store->db(), klio::RedisStore::DEFAULT_REDIS_DB);
 
         store->dispose();
@@ -429,6 +432,193 @@ BOOST_AUTO_TEST_CASE(check_redis_num_readings) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(check_upgrade_legacy_redis_store) {
+
+    std::cout << std::endl << "Checking the upgrade of a Redis store of an older version." << std::endl;
+
+    //Older versions kept the readings of each sensor in a hash, and wrote no layout
+    const std::string uuid = "89c18074-8bcf-240b-db7c-c1281038adcb";
+    const std::string key = "libklio:sensor:" + uuid;
+    const klio::timestamp_t start = 1234567890;
+    const size_t num_readings = 100;
+
+    redis3m::connection::ptr_t connection = redis3m::connection::create(TEST_REDIS_HOST, TEST_REDIS_PORT);
+    connection->run(redis3m::command("SELECT") (klio::RedisStore::DEFAULT_REDIS_DB));
+    connection->run(redis3m::command("FLUSHDB"));
+    connection->run(redis3m::command("HMSET") (key)
+            ("uuid") (uuid)
+            ("external_id") ("legacy")
+            ("name") ("Legacy")
+            ("description") ("this sensor was written by an older version")
+            ("unit") ("watt")
+            ("timezone") ("Europe/Berlin"));
+
+    redis3m::command hmset = redis3m::command("HMSET");
+    hmset << key + ":readings";
+
+    for (size_t i = 0; i < num_readings; i++) {
+        hmset << start + i << i * 0.5;
+    }
+    connection->run(hmset);
+    connection->run(redis3m::command("SADD") ("libklio:sensors") (key));
+
+    klio::RedisStore::Ptr store = create_redis_test_store();
+
+    try {
+        std::vector<klio::Sensor::Ptr> sensors = store->get_sensors_by_name("Legacy");
+        BOOST_REQUIRE_EQUAL(1, sensors.size());
+        klio::Sensor::Ptr sensor = sensors.front();
+        BOOST_CHECK_EQUAL(uuid, sensor->uuid_string());
+
+        try {
+            store->get_timeframe_readings(sensor, start, start + num_readings - 1);
+            BOOST_FAIL("An exception is expected to be risen when the readings of an older version are read.");
+
+        } catch (klio::StoreException const& ex) {
+            //This exception is expected
+        }
+
+        store->upgrade();
+
+        klio::readings_t_Ptr upgraded = store->get_timeframe_readings(sensor, start, start + num_readings - 1);
+        BOOST_CHECK_EQUAL(num_readings, upgraded->size());
+        BOOST_CHECK_EQUAL(0, (*upgraded)[start]);
+        BOOST_CHECK_EQUAL(49.5, (*upgraded)[start + num_readings - 1]);
+        BOOST_CHECK_EQUAL("zset", connection->run(redis3m::command("GET") ("libklio:layout")).str());
+
+        //A second upgrade leaves the store as it is
+        store->upgrade();
+        BOOST_CHECK_EQUAL(num_readings, store->get_num_readings(sensor));
+        BOOST_CHECK_EQUAL(num_readings, store->get_timeframe_readings(sensor, start, start + num_readings - 1)->size());
+
+        store->dispose();
+
+    } catch (std::exception const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected exception occurred during the upgrade test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_redis_timeframe_readings) {
+
+    std::cout << std::endl << "Checking time ranges of readings." << std::endl;
+    klio::RedisStore::Ptr store = create_redis_test_store();
+
+    try {
+        klio::Sensor::Ptr sensor = create_test_sensor("ffff", "Test libklio", "watt");
+        store->add_sensor(sensor);
+
+        klio::readings_t readings;
+        for (klio::timestamp_t timestamp = 1000; timestamp < 1100; timestamp++) {
+            readings.insert(klio::reading_t(timestamp, 1));
+        }
+        store->add_readings(sensor, readings);
+
+        //Replaced readings keep a single member per timestamp
+        klio::readings_t updates;
+        updates.insert(klio::reading_t(1050, 2.5));
+        store->update_readings(sensor, updates);
+
+        klio::readings_t_Ptr timeframe = store->get_timeframe_readings(sensor, 1040, 1059);
+
+        BOOST_CHECK_EQUAL(20, timeframe->size());
+        BOOST_CHECK_EQUAL(2.5, (*timeframe)[1050]);
+        BOOST_CHECK_EQUAL(100, store->get_num_readings(sensor));
+        BOOST_CHECK_EQUAL(1099, store->get_last_reading(sensor).first);
+        BOOST_CHECK_EQUAL(2.5, store->get_reading(sensor, 1050).second);
+
+        store->dispose();
+
+    } catch (std::exception const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected store exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_redis_aggregated_readings) {
+
+    std::cout << std::endl << "Checking aggregation of readings on the server." << std::endl;
+    klio::RedisStore::Ptr store = create_redis_test_store();
+
+    try {
+        klio::Sensor::Ptr sensor = create_test_sensor("hhhh", "Test libklio", "watt");
+        store->add_sensor(sensor);
+
+        klio::readings_t readings;
+        for (klio::timestamp_t timestamp = 1000; timestamp < 1100; timestamp++) {
+            readings.insert(klio::reading_t(timestamp, timestamp % 10));
+        }
+        store->add_readings(sensor, readings);
+
+        klio::readings_t_Ptr averages = store->get_aggregated_readings(sensor, 1000, 1099, 60, klio::AGGREGATE_AVG);
+
+        BOOST_CHECK_EQUAL(3, averages->size());
+        BOOST_CHECK_CLOSE(4.5, (*averages)[960], 0.0001);
+        BOOST_CHECK_CLOSE(4.5, (*averages)[1020], 0.0001);
+        BOOST_CHECK_CLOSE(4.5, (*averages)[1080], 0.0001);
+
+        klio::readings_t_Ptr counts = store->get_aggregated_readings(sensor, 1010, 1049, 20, klio::AGGREGATE_COUNT);
+
+        BOOST_CHECK_EQUAL(3, counts->size());
+        BOOST_CHECK_EQUAL(10, (*counts)[1000]);
+        BOOST_CHECK_EQUAL(20, (*counts)[1020]);
+        BOOST_CHECK_EQUAL(10, (*counts)[1040]);
+
+        klio::readings_t_Ptr maxima = store->get_aggregated_readings(sensor, 1000, 1099, 100, klio::AGGREGATE_MAX);
+        BOOST_CHECK_EQUAL(9, (*maxima)[1000]);
+
+        klio::readings_t_Ptr firsts = store->get_aggregated_readings(sensor, 1003, 1099, 1000, klio::AGGREGATE_FIRST);
+        BOOST_CHECK_EQUAL(3, (*firsts)[1000]);
+
+        store->dispose();
+
+    } catch (std::exception const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected store exception occurred during sensor test");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_redis_connection_pool) {
+
+    std::cout << std::endl << "Checking pooled Redis connections." << std::endl;
+    klio::RedisConnectionPool::Ptr pool(new klio::RedisConnectionPool(
+            TEST_REDIS_HOST,
+            TEST_REDIS_PORT,
+            klio::RedisStore::DEFAULT_REDIS_DB,
+            2));
+
+    klio::RedisStore::Ptr store1 = store_factory->create_redis_store(pool, true, true, 600);
+    klio::RedisStore::Ptr store2 = store_factory->create_redis_store(pool, true, true, 600);
+
+    try {
+        klio::Sensor::Ptr sensor = create_test_sensor("gggg", "Test libklio", "watt");
+        store1->add_sensor(sensor);
+
+        BOOST_CHECK_EQUAL(sensor->uuid(), store2->get_sensor(sensor->uuid())->uuid());
+        BOOST_CHECK_EQUAL(0, pool->idle());
+
+        store2->close();
+        BOOST_CHECK_EQUAL(1, pool->idle());
+
+        //A closed store borrows a connection again when it is reopened
+        store2->open();
+        BOOST_CHECK_EQUAL(0, pool->idle());
+        BOOST_CHECK_EQUAL(1, store2->get_sensors().size());
+
+        store2->close();
+        store1->dispose();
+        BOOST_CHECK_EQUAL(2, pool->idle());
+
+    } catch (std::exception const& ex) {
+        store1->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected store exception occurred during sensor test");
+    }
+}
+
 BOOST_AUTO_TEST_CASE(check_redis_store_creation_performance) {
 
     try {
@@ -453,8 +643,8 @@ BOOST_AUTO_TEST_CASE(check_redis_store_creation_performance) {
             time_before = boost::posix_time::microsec_clock::local_time();
 
             store = store_factory->create_redis_store(
-                    klio::RedisStore::DEFAULT_REDIS_HOST,
-                    klio::RedisStore::DEFAULT_REDIS_PORT,
+                    TEST_REDIS_HOST,
+                    TEST_REDIS_PORT,
                     klio::RedisStore::DEFAULT_REDIS_DB,
                     false,
                     false,
@@ -505,8 +695,8 @@ void run_redis_store_performance_tests(const bool auto_commit, const bool auto_f
                     ", auto flushing: " << (auto_flush ? "true" : "false") << std::endl;
 
             store = store_factory->create_redis_store(
-                    klio::RedisStore::DEFAULT_REDIS_HOST,
-                    klio::RedisStore::DEFAULT_REDIS_PORT,
+                    TEST_REDIS_HOST,
+                    TEST_REDIS_PORT,
                     klio::RedisStore::DEFAULT_REDIS_DB,
                     auto_commit,
                     auto_flush,
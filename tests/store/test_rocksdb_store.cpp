@@ -24,6 +24,7 @@
 #include <iostream>
 #include <boost/test/unit_test.hpp>
 #include <boost/uuid/uuid_io.hpp>
+#include <rocksdb/db.h>
 #include <libklio/store-factory.hpp>
 #include <libklio/sensor-factory.hpp>
 #include <testconfig.h>
@@ -523,6 +524,94 @@ BOOST_AUTO_TEST_CASE(check_rocksdb_num_readings) {
     }
 }
 
+//Writes one of the databases of a sensor, as they were laid out by older versions
+void write_legacy_rocksdb_database(const bfs::path& path, const std::map<std::string, std::string>& entries) {
+
+    bfs::create_directories(path);
+
+    rocksdb::Options options;
+    options.create_if_missing = true;
+
+    rocksdb::DB* db = NULL;
+    rocksdb::Status status = rocksdb::DB::Open(options, path.string(), &db);
+
+    for (std::map<std::string, std::string>::const_iterator it = entries.begin(); status.ok() && it != entries.end(); ++it) {
+        status = db->Put(rocksdb::WriteOptions(), it->first, it->second);
+    }
+    delete db;
+
+    if (!status.ok()) {
+        throw klio::StoreException(status.ToString());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_upgrade_legacy_rocksdb_store) {
+
+    std::cout << std::endl << "Checking the upgrade of a RocksDB store of an older version." << std::endl;
+    klio::StoreFactory::Ptr store_factory(new klio::StoreFactory());
+    bfs::path db = boost::filesystem::unique_path();
+    const std::string uuid = "89c18074-8bcf-240b-db7c-c1281038adcb";
+    const bfs::path sensor_path = db / "sensors" / uuid;
+
+    try {
+        std::map<std::string, std::string> properties;
+        properties["external_id"] = "legacy";
+        properties["name"] = "Legacy";
+        properties["description"] = "this sensor was written by an older version";
+        properties["unit"] = "watt";
+        properties["timezone"] = "Europe/Berlin";
+        write_legacy_rocksdb_database(sensor_path / "properties", properties);
+
+        //Readings were kept as decimal strings
+        const klio::timestamp_t start = 1234567890;
+        const size_t num_readings = 100;
+        std::map<std::string, std::string> readings;
+
+        for (size_t i = 0; i < num_readings; i++) {
+            readings[std::to_string(start + i)] = std::to_string(i * 0.5);
+        }
+        write_legacy_rocksdb_database(sensor_path / "readings", readings);
+
+        try {
+            store_factory->open_rocksdb_store(db);
+            BOOST_FAIL("An exception is expected to be risen when a store of an older version is opened.");
+
+        } catch (klio::StoreException const& ex) {
+            //This exception is expected
+        }
+        BOOST_CHECK(bfs::exists(sensor_path));
+
+        klio::RocksDBStore::Ptr store(store_factory->upgrade_rocksdb_store(db));
+        BOOST_CHECK(!bfs::exists(db / "sensors"));
+
+        std::vector<klio::Sensor::Ptr> sensors = store->get_sensors_by_external_id("legacy");
+        BOOST_REQUIRE_EQUAL(1, sensors.size());
+        BOOST_CHECK_EQUAL(uuid, sensors.front()->uuid_string());
+        BOOST_CHECK_EQUAL("Legacy", sensors.front()->name());
+        BOOST_CHECK_EQUAL("watt", sensors.front()->unit());
+        BOOST_CHECK_EQUAL("Europe/Berlin", sensors.front()->timezone());
+
+        klio::readings_t_Ptr upgraded = store->get_timeframe_readings(sensors.front(), start, start + num_readings - 1);
+        BOOST_CHECK_EQUAL(num_readings, upgraded->size());
+        BOOST_CHECK_EQUAL(0, (*upgraded)[start]);
+        BOOST_CHECK_EQUAL(49.5, (*upgraded)[start + num_readings - 1]);
+
+        //A second upgrade leaves the store as it is
+        store->upgrade();
+        BOOST_CHECK_EQUAL(num_readings, store->get_num_readings(sensors.front()));
+        store->close();
+
+        store = store_factory->open_rocksdb_store(db);
+        BOOST_CHECK_EQUAL(num_readings, store->get_num_readings(sensors.front()));
+        store->dispose();
+
+    } catch (std::exception const& ex) {
+        bfs::remove_all(db);
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected exception occurred during the upgrade test");
+    }
+}
+
 BOOST_AUTO_TEST_CASE(check_rocksdb_store_creation_performance) {
 
     try {
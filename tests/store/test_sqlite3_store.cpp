@@ -59,6 +59,233 @@ BOOST_AUTO_TEST_CASE(check_create_sqlite3_storage) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(check_sqlite3_wal_options) {
+
+    std::cout << "Testing WAL journal mode and options for SQLite3" << std::endl;
+    klio::StoreFactory::Ptr store_factory(new klio::StoreFactory());
+    klio::SensorFactory::Ptr sensor_factory(new klio::SensorFactory());
+    bfs::path db(TEST_DB1_FILE);
+    bfs::path wal(db.string() + "-wal");
+    klio::SQLite3Store::Ptr store;
+
+    std::map<const std::string, const std::string> db_options;
+    db_options.insert(std::make_pair(klio::SQLite3Store::JOURNAL_MODE, klio::SQLite3Store::JOURNAL_MODE_WAL));
+    db_options.insert(std::make_pair(klio::SQLite3Store::MMAP_SIZE, "268435456"));
+    db_options.insert(std::make_pair(klio::SQLite3Store::CACHE_SIZE, "-8000"));
+    db_options.insert(std::make_pair(klio::SQLite3Store::TEMP_STORE, "MEMORY"));
+    db_options.insert(std::make_pair(klio::SQLite3Store::WAL_AUTOCHECKPOINT, "0"));
+
+    try {
+        store = store_factory->create_sqlite3_store(db, true, true, false, 600, klio::SQLite3Store::OS_SYNC_NORMAL, db_options);
+
+        klio::Sensor::Ptr sensor(sensor_factory->createSensor("sensor1", "sensor1", "Watt", "Europe/Berlin"));
+        store->add_sensor(sensor);
+        store->add_reading(sensor, 1234567890, 42);
+        store->flush();
+        BOOST_CHECK(bfs::exists(wal) && bfs::file_size(wal) > 0);
+
+        //A second connection reads the data that is still in the log
+        klio::Store::Ptr loaded(store_factory->open_sqlite3_store(db, true, false, 600, klio::SQLite3Store::OS_SYNC_NORMAL, db_options));
+        BOOST_CHECK_EQUAL(1, loaded->get_num_readings(loaded->get_sensor(sensor->uuid())));
+        loaded.reset();
+
+        store->checkpoint();
+        BOOST_CHECK_EQUAL(0, bfs::file_size(wal));
+
+        store->dispose();
+        BOOST_CHECK(!bfs::exists(wal));
+
+    } catch (klio::GenericException const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected exception occurred for WAL options");
+    }
+
+    std::map<const std::string, const std::string> invalid_options;
+    invalid_options.insert(std::make_pair(klio::SQLite3Store::JOURNAL_MODE, "everything"));
+    BOOST_CHECK_THROW(store_factory->create_sqlite3_store(db, true, true, false, 600, klio::SQLite3Store::OS_SYNC_NORMAL, invalid_options), klio::StoreException);
+    bfs::remove(db);
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_readings_table_upgrade) {
+
+    std::cout << "Testing upgrade of SQLite3 sensor tables to a readings table" << std::endl;
+    klio::StoreFactory::Ptr store_factory(new klio::StoreFactory());
+    klio::SensorFactory::Ptr sensor_factory(new klio::SensorFactory());
+    bfs::path db(TEST_DB1_FILE);
+    klio::SQLite3Store::Ptr store;
+
+    std::map<const std::string, const std::string> db_options;
+    db_options.insert(std::make_pair(klio::SQLite3Store::SCHEMA, klio::SQLite3Store::SCHEMA_SENSOR_TABLES));
+
+    try {
+        store = store_factory->create_sqlite3_store(db, true, true, false, 600, klio::SQLite3Store::OS_SYNC_OFF, db_options);
+        BOOST_CHECK(!store->readings_table());
+
+        klio::Sensor::Ptr sensor1(sensor_factory->createSensor("sensor1", "sensor1", "Watt", "Europe/Berlin"));
+        klio::Sensor::Ptr sensor2(sensor_factory->createSensor("sensor2", "sensor2", "Watt", "Europe/Berlin"));
+        store->add_sensor(sensor1);
+        store->add_sensor(sensor2);
+        store->add_reading(sensor1, 1234567890, 42);
+        store->add_reading(sensor1, 1234567891, 43);
+        store->add_reading(sensor2, 1234567890, 44);
+        store->flush();
+        store->close();
+
+        store = store_factory->open_sqlite3_store(db);
+        BOOST_CHECK(!store->readings_table());
+        store->upgrade();
+        BOOST_CHECK(store->readings_table());
+
+        BOOST_CHECK_EQUAL(2, store->get_num_readings(sensor1));
+        BOOST_CHECK_EQUAL(1, store->get_num_readings(sensor2));
+        BOOST_CHECK_EQUAL(43, store->get_last_reading(sensor1).second);
+        BOOST_CHECK_EQUAL(44, store->get_reading(sensor2, 1234567890).second);
+
+        store->add_reading(sensor2, 1234567891, 45);
+        store->flush();
+        BOOST_CHECK_EQUAL(2, store->get_timeframe_readings(sensor2, 1234567890, 1234567891)->size());
+
+        store->remove_sensor(sensor1);
+        BOOST_CHECK_EQUAL(2, store->get_num_readings(sensor2));
+        store->dispose();
+
+        //New stores use the readings table by default
+        store = store_factory->create_sqlite3_store(db);
+        BOOST_CHECK(store->readings_table());
+        store->dispose();
+
+    } catch (klio::GenericException const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected exception occurred during the readings table upgrade");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_millisecond_timestamps) {
+
+    std::cout << "Testing SQLite3 millisecond timestamps" << std::endl;
+    klio::StoreFactory::Ptr store_factory(new klio::StoreFactory());
+    klio::SensorFactory::Ptr sensor_factory(new klio::SensorFactory());
+    bfs::path db(TEST_DB1_FILE);
+    klio::SQLite3Store::Ptr store;
+
+    std::map<const std::string, const std::string> db_options;
+    db_options.insert(std::make_pair(klio::SQLite3Store::TIMESTAMP_RESOLUTION, klio::SQLite3Store::TIMESTAMP_RESOLUTION_MILLISECONDS));
+
+    try {
+        store = store_factory->create_sqlite3_store(db, true, true, false, 600, klio::SQLite3Store::OS_SYNC_OFF, db_options);
+        BOOST_CHECK_EQUAL(1000, store->timestamps_per_second());
+
+        klio::Sensor::Ptr sensor(sensor_factory->createSensor("sensor1", "sensor1", "Watt", "Europe/Berlin"));
+        store->add_sensor(sensor);
+
+        //50 Hz readings beyond the range of 32-bit integers
+        klio::readings_t readings;
+        for (klio::timestamp_t timestamp = 1234567890000LL; timestamp < 1234567891000LL; timestamp += 20) {
+            readings.insert(klio::reading_t(timestamp, timestamp % 1000));
+        }
+        store->add_readings(sensor, readings);
+        store->flush();
+        store->close();
+
+        store = store_factory->open_sqlite3_store(db);
+        BOOST_CHECK_EQUAL(1000, store->timestamps_per_second());
+        BOOST_CHECK_EQUAL(50, store->get_num_readings(sensor));
+        BOOST_CHECK_EQUAL(1234567890980LL, store->get_last_reading(sensor).first);
+        BOOST_CHECK_EQUAL(120, store->get_reading(sensor, 1234567890120LL).second);
+
+        klio::readings_t_Ptr timeframe = store->get_timeframe_readings(sensor, 1234567890100LL, 1234567890199LL);
+        BOOST_CHECK_EQUAL(5, timeframe->size());
+        BOOST_CHECK_EQUAL(1234567890100LL, timeframe->begin()->first);
+        store->close();
+
+        //The resolution can not be changed once the store exists
+        std::map<const std::string, const std::string> seconds_options;
+        seconds_options.insert(std::make_pair(klio::SQLite3Store::TIMESTAMP_RESOLUTION, klio::SQLite3Store::TIMESTAMP_RESOLUTION_SECONDS));
+        BOOST_CHECK_THROW(store_factory->open_sqlite3_store(db, true, false, 600, klio::SQLite3Store::OS_SYNC_OFF, seconds_options), klio::StoreException);
+
+        //A store opened without the option rotates into a file with the same resolution
+        bfs::path rotated(TEST_DB2_FILE);
+        store = store_factory->open_sqlite3_store(db);
+        store->rotate(rotated);
+        BOOST_CHECK_EQUAL(1000, store->timestamps_per_second());
+        store->close();
+
+        store = store_factory->open_sqlite3_store(db, true, false, 600, klio::SQLite3Store::OS_SYNC_OFF, db_options);
+        BOOST_CHECK_EQUAL(1000, store->timestamps_per_second());
+        store->dispose();
+
+        store = store_factory->open_sqlite3_store(rotated);
+        store->dispose();
+
+    } catch (klio::GenericException const& ex) {
+        store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected exception occurred for millisecond timestamps");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(check_sqlite3_sync_timestamp_resolutions) {
+
+    std::cout << "Testing the synchronization of SQLite3 stores with different timestamp resolutions" << std::endl;
+    klio::StoreFactory::Ptr store_factory(new klio::StoreFactory());
+    klio::SensorFactory::Ptr sensor_factory(new klio::SensorFactory());
+    klio::SQLite3Store::Ptr milliseconds_store;
+    klio::SQLite3Store::Ptr seconds_store;
+
+    std::map<const std::string, const std::string> db_options;
+    db_options.insert(std::make_pair(klio::SQLite3Store::TIMESTAMP_RESOLUTION, klio::SQLite3Store::TIMESTAMP_RESOLUTION_MILLISECONDS));
+
+    try {
+        milliseconds_store = store_factory->create_sqlite3_store(bfs::path(TEST_DB1_FILE), true, true, false, 600, klio::SQLite3Store::OS_SYNC_OFF, db_options);
+        seconds_store = store_factory->create_sqlite3_store(bfs::path(TEST_DB2_FILE));
+
+        klio::Sensor::Ptr sensor(sensor_factory->createSensor("sensor1", "sensor1", "Watt", "Europe/Berlin"));
+        seconds_store->add_sensor(sensor);
+
+        klio::readings_t readings;
+        for (klio::timestamp_t timestamp = 1234567890; timestamp < 1234567900; timestamp++) {
+            readings.insert(klio::reading_t(timestamp, timestamp % 10));
+        }
+        seconds_store->add_readings(sensor, readings);
+        seconds_store->flush();
+
+        //Seconds are converted to milliseconds
+        milliseconds_store->sync(seconds_store);
+        klio::Sensor::Ptr synced = milliseconds_store->get_sensors_by_external_id("sensor1").front();
+        BOOST_CHECK_EQUAL(10, milliseconds_store->get_num_readings(synced));
+        BOOST_CHECK_EQUAL(1234567899000LL, milliseconds_store->get_last_reading(synced).first);
+        BOOST_CHECK_EQUAL(5, milliseconds_store->get_reading(synced, 1234567895000LL).second);
+
+        milliseconds_store->add_reading(synced, 1234567899020LL, 42);
+        milliseconds_store->flush();
+
+        //Milliseconds would be merged into seconds
+        BOOST_CHECK_THROW(seconds_store->sync(milliseconds_store), klio::StoreException);
+        BOOST_CHECK_THROW(seconds_store->sync_readings(synced, milliseconds_store), klio::StoreException);
+        BOOST_CHECK_THROW(seconds_store->load_readings(sensor, *milliseconds_store->get_all_readings(synced), 1000), klio::StoreException);
+        BOOST_CHECK_EQUAL(10, seconds_store->get_num_readings(sensor));
+        BOOST_CHECK_EQUAL(1234567899, seconds_store->get_last_reading(sensor).first);
+
+        //Imported readings are converted like synchronized ones
+        klio::readings_t imported;
+        imported.insert(klio::reading_t(1234567900, 7));
+        milliseconds_store->load_readings(synced, imported, 1);
+        BOOST_CHECK_EQUAL(12, milliseconds_store->get_num_readings(synced));
+        BOOST_CHECK_EQUAL(7, milliseconds_store->get_reading(synced, 1234567900000LL).second);
+
+        milliseconds_store->dispose();
+        seconds_store->dispose();
+
+    } catch (klio::GenericException const& ex) {
+        milliseconds_store->dispose();
+        seconds_store->dispose();
+        std::cout << "Caught invalid exception: " << ex.what() << std::endl;
+        BOOST_FAIL("Unexpected exception occurred for synchronized timestamp resolutions");
+    }
+}
+
 int get_openfiles() {
 
     fd_set closet;